@@ -7,25 +7,31 @@
 MEMPOOL_DIR=$(git rev-parse --show-toplevel 2>/dev/null || echo $MEMPOOL_DIR)
 cd $MEMPOOL_DIR/hardware
 
+# Number of sweep points simulated in parallel
+jobs=${jobs:-$(nproc)}
+
 # Timestamp
 timestamp=`date +%Y%m%d_%H%M%S`
-mkdir load_thru_$timestamp
+resultdir=$MEMPOOL_DIR/hardware/load_thru_$timestamp
+mkdir $resultdir
 
-# Request forced to be in the sequential region
+# Sweep points: request forced to be in the sequential region x request probability
 for seq_prob in `seq 0 0.2 1`; do
-    echo "Prob. of request forced at the sequential region: ${seq_prob}"
-    echo ""
-
-    # Probability request
     for req_prob in `seq 0.02 0.02 0.6`; do
-        # Clean-up
-        make clean
+        echo "$req_prob $seq_prob" >> $resultdir/sweep
+    done
+done
 
-        # Compile the verilator model
-        tmpfile=`mktemp`
-        tg=1 tg_ncycles=10000 tg_reqprob=${req_prob} tg_seqprob=${seq_prob} make verilate &> /dev/null
+# Clean-up
+make clean
 
-        echo "$req_prob `cat build/transcript | grep Average | cut -d: -f2` `cat build/transcript | grep Throughput | cut -d: -f2`" >> load_thru_$timestamp/results_seqprob${seq_prob}
-        echo "Req. Probability: $req_prob | Avg. Latency: `cat build/transcript | grep Average | cut -d: -f2` cycle | Throughput: `cat build/transcript | grep Throughput | cut -d: -f2` req/core/cycle"
-    done
+# Compile the verilator model once and simulate all points of the sweep with it.
+# The sweep forks the model, which is only possible for a single-threaded one.
+verilator_threads=1 tg=1 tg_ncycles=10000 tg_sweep=$resultdir/sweep tg_jobs=$jobs tg_results=$resultdir/results make verilate
+
+# Split the results table, which follows the order of the sweep file, per
+# probability of the sequential region
+tail -n +2 $resultdir/results | paste -d ' ' $resultdir/sweep - | \
+while read req_prob seq_prob _ _ latency throughput; do
+    echo "$req_prob $latency $throughput" >> $resultdir/results_seqprob${seq_prob}
 done
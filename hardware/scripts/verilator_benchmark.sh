@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+
+# Copyright 2021 ETH Zurich and University of Bologna.
+# Solderpad Hardware License, Version 0.51, see LICENSE for details.
+# SPDX-License-Identifier: SHL-0.51
+
+# Measure the simulation speed of the Verilator model for different numbers of
+# threads. Every thread count gets its own model, which is built on demand.
+
+MEMPOOL_DIR=$(git rev-parse --show-toplevel 2>/dev/null || echo $MEMPOOL_DIR)
+cd $MEMPOOL_DIR/hardware
+
+# Applications to simulate (must be compiled into software/bin)
+apps=${apps:-"hello_world matmul_i32 axpy conv2d_i8"}
+# Thread counts of the benchmarked models
+threads=${threads:-"1 2 4 8 16"}
+
+# Make sure all applications exist
+for app in $apps; do
+  if [[ ! -f $MEMPOOL_DIR/software/bin/$app ]]; then
+    echo "Application $app not found, compile it in software/apps first"
+    exit 1
+  fi
+done
+
+# Timestamp
+timestamp=`date +%Y%m%d_%H%M%S`
+resultdir=$MEMPOOL_DIR/hardware/verilator_bench_$timestamp
+mkdir $resultdir
+
+# Results table: simulated kHz per application and thread count
+echo -e "threads\t${apps// /\\t}" | tee $resultdir/results
+
+for t in $threads; do
+  line="$t"
+  for app in $apps; do
+    buildpath=$resultdir/build_t${t}_$app
+    verilator_threads=$t buildpath=$buildpath app=$app \
+      make verilate > $resultdir/log_t${t}_$app 2>&1
+    # Extract the speed reported by VerilatorSimCtrl::PrintStatistics
+    speed=$(sed -n 's/^Simulation speed: .*(\(.*\) kHz)$/\1/p' \
+      $buildpath/transcript 2>/dev/null)
+    line="$line\t${speed:-nan}"
+  done
+  echo -e "$line" | tee -a $resultdir/results
+done
@@ -206,15 +206,85 @@ module mempool_cc
   logic [63:0] cycle;
   int unsigned stall, stall_ins, stall_raw, stall_lsu, stall_acc;
 
+`ifdef SNITCH_BINARY_TRACE
+  // Binary trace, see tb/dpi/snitch_trace.h. The trace is compressed with the
+  // gzip level given by `+SNITCH_TRACE_GZIP=<level>` (default: uncompressed).
+  import "DPI-C" function chandle snitch_trace_open(input int unsigned hart_id, input int compression);
+  import "DPI-C" function void snitch_trace_record(input chandle trace,
+      input longint unsigned time_ns, input longint unsigned cycle,
+      input int unsigned pc, input int unsigned insn, input int unsigned source,
+      input int unsigned stall, input int unsigned stall_tot,
+      input int unsigned stall_ins, input int unsigned stall_raw,
+      input int unsigned stall_lsu, input int unsigned stall_acc,
+      input int unsigned rs1, input int unsigned rs2, input int unsigned rd,
+      input int unsigned is_load, input int unsigned is_store,
+      input int unsigned is_branch, input int unsigned pc_d,
+      input int unsigned opa, input int unsigned opb,
+      input int unsigned opa_select, input int unsigned opb_select,
+      input int unsigned opc_select, input int unsigned write_rd,
+      input int unsigned csr_addr, input int unsigned writeback,
+      input int unsigned gpr_rdata_1, input int unsigned gpr_rdata_2,
+      input int unsigned ls_size, input int unsigned ld_result_32,
+      input int unsigned lsu_rd, input int unsigned retire_load,
+      input int unsigned alu_result, input int unsigned ls_amo,
+      input int unsigned retire_acc, input int unsigned acc_pid,
+      input int unsigned acc_pdata_32);
+  import "DPI-C" function void snitch_trace_close(input chandle trace);
+
+  chandle trace;
+  int trace_gzip;
+
+  function void open_trace();
+    if (!$value$plusargs("SNITCH_TRACE_GZIP=%d", trace_gzip))
+      trace_gzip = 0;
+    trace = snitch_trace_open(hart_id_i, trace_gzip);
+  endfunction
+
+  function void close_trace();
+    snitch_trace_close(trace);
+  endfunction
+
+`ifndef VERILATOR_SAVABLE
+  always_ff @(posedge rst_i) begin
+    if(rst_i) begin
+      if (trace != null)
+        snitch_trace_close(trace);
+      open_trace();
+    end
+  end
+`endif
+`else
+  function void open_trace();
+    // Format in hex because vcs and vsim treat decimal differently
+    // Format with 8 digits because Verilator does not support anything else
+    $sformat(fn, "trace_hart_0x%08x.dasm", hart_id_i);
+    f = $fopen(fn, "w");
+    $display("[Tracer] Logging Hart %d to %s", hart_id_i, fn);
+  endfunction
+
+  function void close_trace();
+    $fclose(f);
+  endfunction
+
+`ifndef VERILATOR_SAVABLE
   always_ff @(posedge rst_i) begin
     if(rst_i) begin
-      // Format in hex because vcs and vsim treat decimal differently
-      // Format with 8 digits because Verilator does not support anything else
-      $sformat(fn, "trace_hart_0x%08x.dasm", hart_id_i);
-      f = $fopen(fn, "w");
-      $display("[Tracer] Logging Hart %d to %s", hart_id_i, fn);
+      open_trace();
     end
   end
+`endif
+`endif
+
+`ifdef VERILATOR_SAVABLE
+  // A restored simulation skips the reset and holds the trace handles of the
+  // run that saved the checkpoint. Checkpointable models therefore open the
+  // trace at the first clock edge of every epoch of the simulation controller,
+  // i.e., after the start and after every restore. The handles restored from
+  // a checkpoint are stale and are not closed.
+  import "DPI-C" function int unsigned simctrl_epoch();
+  import "DPI-C" function int unsigned simctrl_start_epoch();
+  int unsigned trace_epoch;
+`endif
 
   typedef enum logic [1:0] {SrcSnitch =  0, SrcFpu = 1, SrcFpuSeq = 2} trace_src_e;
   localparam int SnitchTrace = `ifdef SNITCH_TRACE `SNITCH_TRACE `else 0 `endif;
@@ -223,6 +293,14 @@ module mempool_cc
       automatic string trace_entry;
       automatic string extras_str;
 
+`ifdef VERILATOR_SAVABLE
+      if (trace_epoch != simctrl_epoch()) begin
+        if (trace_epoch >= simctrl_start_epoch())
+          close_trace();
+        trace_epoch = simctrl_epoch();
+        open_trace();
+      end
+`endif
       if (!rst_i) begin
         cycle <= cycle + 1;
         // Trace snitch iff:
@@ -230,6 +308,20 @@ module mempool_cc
         // we are not stalled <==> we have issued and processed an instruction (including offloads)
         // OR we are retiring (issuing a writeback from) a load or accelerator instruction
         if ((i_snitch.csr_trace_q || SnitchTrace) && (!i_snitch.stall || i_snitch.retire_load || i_snitch.retire_acc)) begin
+`ifdef SNITCH_BINARY_TRACE
+          // Same fields as the text trace below, the timescale is 1ns
+          snitch_trace_record(trace, $time, cycle, i_snitch.pc_q, i_snitch.inst_data_i,
+              SrcSnitch, i_snitch.stall, stall, stall_ins, stall_raw, stall_lsu, stall_acc,
+              i_snitch.rs1, i_snitch.rs2, i_snitch.rd,
+              i_snitch.is_load, i_snitch.is_store, i_snitch.is_branch, i_snitch.pc_d,
+              i_snitch.opa, i_snitch.opb,
+              i_snitch.opa_select, i_snitch.opb_select, i_snitch.opc_select,
+              i_snitch.write_rd, i_snitch.inst_data_i[31:20], i_snitch.alu_writeback,
+              i_snitch.gpr_rdata[1], i_snitch.gpr_rdata[2], i_snitch.ls_size,
+              i_snitch.ld_result[31:0], i_snitch.lsu_rd, i_snitch.retire_load,
+              i_snitch.alu_result, i_snitch.ls_amo,
+              i_snitch.retire_acc, i_snitch.acc_pid_i, i_snitch.acc_pdata_i[31:0]);
+`else
           // Manual loop unrolling for Verilator
           // Data type keys for arrays are currently not supported in Verilator
           extras_str = "{";
@@ -279,6 +371,7 @@ module mempool_cc
           $sformat(trace_entry, "%t %8d 0x%h DASM(%h) #; %s\n",
               $time, cycle, i_snitch.pc_q, i_snitch.inst_data_i, extras_str);
           $fwrite(f, trace_entry);
+`endif
         end
 
         // Reset all stalls when we execute an instruction
@@ -317,8 +410,25 @@ module mempool_cc
     end
 
   final begin
-    $fclose(f);
+    close_trace();
   end
+
+`ifdef VERILATOR
+  // Notify the simulation controller when the trace CSR is set for the first
+  // time, e.g., to checkpoint the simulation at the start of a kernel
+  import "DPI-C" function void simctrl_trace_csr_set(input int unsigned hart_id);
+
+  logic trace_csr_set_q;
+
+  always_ff @(posedge clk_i or posedge rst_i) begin
+    if (rst_i) begin
+      trace_csr_set_q <= 1'b0;
+    end else if (!trace_csr_set_q && |i_snitch.csr_trace_q) begin
+      trace_csr_set_q <= 1'b1;
+      simctrl_trace_csr_set(hart_id_i);
+    end
+  end
+`endif
   // pragma translate_on
 `endif
 
@@ -0,0 +1,374 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "address_pattern.h"
+
+// Includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits.h>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "traffic_generator.h"
+
+// Architecture
+#ifndef NUM_CORES
+#define NUM_CORES 256
+#endif
+
+#ifndef NUM_CORES_PER_TILE
+#define NUM_CORES_PER_TILE 4
+#endif
+
+#ifndef NUM_GROUPS
+#define NUM_GROUPS 4
+#endif
+
+#ifndef BANKING_FACTOR
+#define BANKING_FACTOR 4
+#endif
+
+// Size of the sequential memory per core, used to scramble replayed addresses
+#ifndef SEQ_MEM_SIZE
+#define SEQ_MEM_SIZE 512
+#endif
+
+#define BYTE_OFFSET 2
+#define NUM_BANKS_PER_TILE (NUM_CORES_PER_TILE * BANKING_FACTOR)
+
+static uint32_t clog2(uint32_t val) {
+  uint32_t bits = 0;
+  while ((1u << bits) < val)
+    bits++;
+  return bits;
+}
+
+TcdmMap::TcdmMap(uint32_t tcdm_base_addr, uint32_t tcdm_mask,
+                 uint32_t tile_mask, uint32_t seq_mask)
+    : base(tcdm_base_addr), mask(tcdm_mask), size(~tcdm_mask + 1),
+      bank_lsb(BYTE_OFFSET), num_banks_per_tile(NUM_BANKS_PER_TILE) {
+  tile_lsb = bank_lsb + clog2(num_banks_per_tile);
+  num_tiles = (tile_mask >> tile_lsb) + 1;
+  row_lsb = tile_lsb + clog2(num_tiles);
+  num_rows = size >> row_lsb;
+  own_tile = (seq_mask & tile_mask) >> tile_lsb;
+}
+
+// Draw a random value in [0, max)
+static inline uint32_t draw(std::default_random_engine &engine, uint32_t max) {
+  std::uniform_int_distribution<uint32_t> dist(0, max - 1);
+  return dist(engine);
+}
+
+/**
+ * Uniformly distributed addresses. With a probability of `seq_prob`, the
+ * request is forced to target the own tile.
+ */
+class UniformPattern : public AddressPattern {
+public:
+  explicit UniformPattern(const TrafficGeneratorConfig &config)
+      : config_(config) {}
+
+  bool NextAddress(uint32_t core_id, const TcdmMap &map,
+                   std::default_random_engine &engine,
+                   uint32_t *addr) override {
+    std::uniform_int_distribution<uint32_t> addr_dist(0, INT_MAX);
+    std::uniform_real_distribution<float> real_dist(0, 1);
+
+    uint32_t tile_mask = (map.num_tiles - 1) << map.tile_lsb;
+    uint32_t seq_mask = map.own_tile << map.tile_lsb;
+
+    *addr = addr_dist(engine);
+    // Make sure the request is in the TCDM region
+    *addr = (*addr & ~map.mask) | (map.base & map.mask);
+
+    // Should the request be in the sequential region?
+    if (real_dist(engine) < config_.seq_prob) {
+      *addr = (*addr & ~tile_mask) | (seq_mask & tile_mask);
+    }
+
+    // Address is aligned to 32 bits
+    *addr = (*addr >> 2) << 2;
+    return true;
+  }
+
+private:
+  const TrafficGeneratorConfig &config_;
+};
+
+/**
+ * Constant stride. Core `i` starts at word `i`, such that all cores start in
+ * different banks, and advances by `stride` bytes with every request.
+ */
+class StridePattern : public AddressPattern {
+public:
+  explicit StridePattern(uint32_t stride)
+      : stride_(stride), offset_(NUM_CORES, 0) {}
+
+  bool NextAddress(uint32_t core_id, const TcdmMap &map,
+                   std::default_random_engine &engine,
+                   uint32_t *addr) override {
+    uint32_t &offset = offset_[core_id];
+    *addr = (map.base & map.mask) |
+            (((core_id << BYTE_OFFSET) + offset) & (map.size - 1) &
+             ~((1u << BYTE_OFFSET) - 1));
+    offset += stride_;
+    return true;
+  }
+
+private:
+  uint32_t stride_;
+  std::vector<uint32_t> offset_;
+};
+
+/**
+ * Uniformly distributed addresses, but a fraction of `hotspot_prob` of the
+ * requests targets the single bank `hotspot_bank`.
+ */
+class HotspotPattern : public AddressPattern {
+public:
+  HotspotPattern(double prob, uint32_t bank) : prob_(prob), bank_(bank) {}
+
+  bool NextAddress(uint32_t core_id, const TcdmMap &map,
+                   std::default_random_engine &engine,
+                   uint32_t *addr) override {
+    std::uniform_real_distribution<float> real_dist(0, 1);
+    uint32_t num_banks = map.num_tiles * map.num_banks_per_tile;
+    uint32_t bank = (real_dist(engine) < prob_) ? bank_ % num_banks
+                                                 : draw(engine, num_banks);
+    *addr = map.Compose(draw(engine, map.num_rows),
+                        bank / map.num_banks_per_tile,
+                        bank % map.num_banks_per_tile);
+    return true;
+  }
+
+private:
+  double prob_;
+  uint32_t bank_;
+};
+
+/**
+ * Uniformly distributed addresses within the own group or the own tile
+ */
+class LocalPattern : public AddressPattern {
+public:
+  explicit LocalPattern(bool group) : group_(group) {}
+
+  bool NextAddress(uint32_t core_id, const TcdmMap &map,
+                   std::default_random_engine &engine,
+                   uint32_t *addr) override {
+    uint32_t tile = map.own_tile;
+    if (group_) {
+      uint32_t num_tiles_per_group = std::max(map.num_tiles / NUM_GROUPS, 1u);
+      tile = (map.own_tile / num_tiles_per_group) * num_tiles_per_group +
+             draw(engine, num_tiles_per_group);
+    }
+    *addr = map.Compose(draw(engine, map.num_rows), tile,
+                        draw(engine, map.num_banks_per_tile));
+    return true;
+  }
+
+private:
+  bool group_;
+};
+
+/**
+ * Zipf-distributed banks: the probability of hitting the bank of rank `k` is
+ * proportional to `1/k^s`, the row is uniformly distributed
+ */
+class ZipfPattern : public AddressPattern {
+public:
+  explicit ZipfPattern(double s) {
+    uint32_t num_banks = NUM_CORES * BANKING_FACTOR;
+    double sum = 0;
+    cdf_.reserve(num_banks);
+    for (uint32_t k = 1; k <= num_banks; k++) {
+      sum += 1.0 / std::pow((double)k, s);
+      cdf_.push_back(sum);
+    }
+    for (double &p : cdf_)
+      p /= sum;
+  }
+
+  bool NextAddress(uint32_t core_id, const TcdmMap &map,
+                   std::default_random_engine &engine,
+                   uint32_t *addr) override {
+    std::uniform_real_distribution<double> real_dist(0, 1);
+    uint32_t num_banks = map.num_tiles * map.num_banks_per_tile;
+    uint32_t bank =
+        std::upper_bound(cdf_.begin(), cdf_.end(), real_dist(engine)) -
+        cdf_.begin();
+    bank = std::min(bank, num_banks - 1);
+    *addr = map.Compose(draw(engine, map.num_rows),
+                        bank / map.num_banks_per_tile,
+                        bank % map.num_banks_per_tile);
+    return true;
+  }
+
+private:
+  std::vector<double> cdf_;
+};
+
+/**
+ * Replay of recorded per-core address streams
+ *
+ * The stream of core `i` is read from `<dir>/trace_hart_0x<i>.trace`, an
+ * annotated trace as written by `gen_trace.py`, or from
+ * `<dir>/trace_hart_0x<i>.bin`, a sequence of little-endian 32-bit byte
+ * addresses. The streams hold the addresses issued by the cores, which are
+ * scrambled like the cores' requests. Accesses outside of the TCDM are
+ * skipped and each stream restarts once it is exhausted.
+ */
+class ReplayPattern : public AddressPattern {
+public:
+  explicit ReplayPattern(const std::string &dir)
+      : streams_(NUM_CORES), cursor_(NUM_CORES, 0),
+        filtered_(NUM_CORES, 0) {
+    uint32_t num_streams = 0;
+    for (uint32_t c = 0; c < NUM_CORES; c++) {
+      char name[64];
+      snprintf(name, sizeof(name), "/trace_hart_0x%08x", c);
+      std::string path = dir + name;
+      if (LoadTrace(path + ".trace", streams_[c]) ||
+          LoadBinary(path + ".bin", streams_[c])) {
+        num_streams++;
+      }
+    }
+    if (num_streams == 0) {
+      std::ostringstream oss;
+      oss << "No replay trace found in `" << dir << "'.";
+      throw std::runtime_error(oss.str());
+    }
+  }
+
+  bool NextAddress(uint32_t core_id, const TcdmMap &map,
+                   std::default_random_engine &engine,
+                   uint32_t *addr) override {
+    std::vector<uint32_t> &stream = streams_[core_id];
+    // Scramble the stream and drop non-TCDM accesses on first use
+    if (!filtered_[core_id]) {
+      size_t len = 0;
+      for (uint32_t a : stream) {
+        a = Scramble(a, map);
+        if (map.Contains(a))
+          stream[len++] = (a >> BYTE_OFFSET) << BYTE_OFFSET;
+      }
+      stream.resize(len);
+      filtered_[core_id] = 1;
+    }
+    if (stream.empty())
+      return false;
+
+    uint32_t &cursor = cursor_[core_id];
+    *addr = stream[cursor];
+    cursor = (cursor + 1 == stream.size()) ? 0 : cursor + 1;
+    return true;
+  }
+
+private:
+  std::vector<std::vector<uint32_t>> streams_;
+  std::vector<uint32_t> cursor_;
+  // Not a std::vector<bool>, whose elements cannot be written concurrently
+  std::vector<uint8_t> filtered_;
+
+  // Mirror the address scrambler: addresses of the sequential region are
+  // mapped to the banks of their tile
+  static uint32_t Scramble(uint32_t addr, const TcdmMap &map) {
+    uint32_t seq_per_tile_bits = clog2(SEQ_MEM_SIZE * NUM_CORES_PER_TILE);
+    uint32_t tile_bits = map.row_lsb - map.tile_lsb;
+    if (map.num_tiles < 2 || addr >= (map.num_tiles << seq_per_tile_bits))
+      return addr;
+    uint32_t scramble_bits = seq_per_tile_bits - map.tile_lsb;
+    uint32_t scramble = (addr >> map.tile_lsb) & ((1u << scramble_bits) - 1);
+    uint32_t tile = (addr >> seq_per_tile_bits) & ((1u << tile_bits) - 1);
+    uint32_t seq_total_bits = seq_per_tile_bits + tile_bits;
+    uint32_t msb = addr & ~((1ull << seq_total_bits) - 1);
+    uint32_t lsb = addr & ((1u << map.tile_lsb) - 1);
+    return msb | (scramble << map.row_lsb) | (tile << map.tile_lsb) | lsb;
+  }
+
+  // Extract the load and store addresses of an annotated trace, e.g.,
+  // `a0  <~~ Word[0x00001234]` or `5 ~~> Word[0x00001234]`
+  static bool LoadTrace(const std::string &path,
+                        std::vector<uint32_t> &stream) {
+    std::ifstream file(path);
+    if (!file)
+      return false;
+    std::string line;
+    while (std::getline(file, line)) {
+      size_t pos = 0;
+      while ((pos = line.find("~~", pos)) != std::string::npos) {
+        size_t open = line.find('[', pos);
+        pos += 2;
+        if (open == std::string::npos)
+          break;
+        char *end;
+        unsigned long addr = strtoul(line.c_str() + open + 1, &end, 0);
+        if (*end == ']')
+          stream.push_back(addr);
+      }
+    }
+    return true;
+  }
+
+  static bool LoadBinary(const std::string &path,
+                         std::vector<uint32_t> &stream) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+      return false;
+    uint8_t buf[4];
+    while (file.read(reinterpret_cast<char *>(buf), sizeof(buf))) {
+      stream.push_back(buf[0] | (buf[1] << 8) | (buf[2] << 16) |
+                       ((uint32_t)buf[3] << 24));
+    }
+    return true;
+  }
+};
+
+TrafficPattern GetTrafficPatternByName(const std::string &name) {
+  if (name == "uniform")
+    return kPatternUniform;
+  if (name == "stride")
+    return kPatternStride;
+  if (name == "hotspot")
+    return kPatternHotspot;
+  if (name == "group")
+    return kPatternGroup;
+  if (name == "tile")
+    return kPatternTile;
+  if (name == "zipf")
+    return kPatternZipf;
+  if (name == "replay")
+    return kPatternReplay;
+
+  std::ostringstream oss;
+  oss << "Unknown traffic pattern: `" << name << "'.";
+  throw std::runtime_error(oss.str());
+}
+
+AddressPattern *CreateAddressPattern(const TrafficGeneratorConfig &config) {
+  switch (config.pattern) {
+  case kPatternUniform:
+    return new UniformPattern(config);
+  case kPatternStride:
+    return new StridePattern(config.stride);
+  case kPatternHotspot:
+    return new HotspotPattern(config.hotspot_prob, config.hotspot_bank);
+  case kPatternGroup:
+    return new LocalPattern(true);
+  case kPatternTile:
+    return new LocalPattern(false);
+  case kPatternZipf:
+    return new ZipfPattern(config.zipf_s);
+  case kPatternReplay:
+    return new ReplayPattern(config.replay_dir);
+  }
+  throw std::runtime_error("Unknown traffic pattern.");
+}
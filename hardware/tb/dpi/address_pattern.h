@@ -0,0 +1,93 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef MEMPOOL_TB_DPI_ADDRESS_PATTERN_H_
+#define MEMPOOL_TB_DPI_ADDRESS_PATTERN_H_
+
+#include <random>
+#include <stdint.h>
+#include <string>
+
+struct TrafficGeneratorConfig;
+
+/**
+ * Address patterns of the traffic generator
+ */
+enum TrafficPattern {
+  kPatternUniform = 0, ///< Uniform, optionally forced to the own tile
+  kPatternStride,      ///< Constant stride, starting at a per-core offset
+  kPatternHotspot,     ///< Uniform, but a fraction hits a single bank
+  kPatternGroup,       ///< Uniform within the own group
+  kPatternTile,        ///< Uniform within the own tile
+  kPatternZipf,        ///< Zipf-distributed over all banks
+  kPatternReplay,      ///< Replay of each core's recorded address stream
+};
+
+/**
+ * Physical layout of the TCDM seen by the traffic generator of one core
+ *
+ * The traffic generator's requests bypass the address scrambler, so addresses
+ * are composed as `{row, tile, bank, byte}`.
+ */
+struct TcdmMap {
+  TcdmMap(uint32_t tcdm_base_addr, uint32_t tcdm_mask, uint32_t tile_mask,
+          uint32_t seq_mask);
+
+  uint32_t base;     ///< Base address of the TCDM
+  uint32_t mask;     ///< Bits of an address that select the TCDM
+  uint32_t size;     ///< Size of the TCDM in bytes
+  uint32_t bank_lsb; ///< Offset of the bank index in an address
+  uint32_t tile_lsb; ///< Offset of the tile index in an address
+  uint32_t row_lsb;  ///< Offset of the row index in an address
+  uint32_t num_banks_per_tile;
+  uint32_t num_tiles;
+  uint32_t num_rows;
+  uint32_t own_tile; ///< Tile of the core generating the traffic
+
+  /**
+   * Compose an address from its row, tile and bank index
+   */
+  uint32_t Compose(uint32_t row, uint32_t tile, uint32_t bank) const {
+    return (base & mask) | (row << row_lsb) | (tile << tile_lsb) |
+           (bank << bank_lsb);
+  }
+
+  /**
+   * Is the address located in the TCDM?
+   */
+  bool Contains(uint32_t addr) const { return (addr & mask) == (base & mask); }
+};
+
+/**
+ * Generator of the target addresses of the traffic generator
+ *
+ * NextAddress() is called once per request. Implementations must only touch
+ * state belonging to core_id, such that cores can be evaluated concurrently.
+ */
+class AddressPattern {
+public:
+  virtual ~AddressPattern() {}
+
+  /**
+   * Get the next address of core_id. Returns false if the core has no
+   * further request to issue.
+   */
+  virtual bool NextAddress(uint32_t core_id, const TcdmMap &map,
+                           std::default_random_engine &engine,
+                           uint32_t *addr) = 0;
+};
+
+/**
+ * Convert a pattern name to a TrafficPattern. Throws a std::runtime_error for
+ * unknown names.
+ */
+TrafficPattern GetTrafficPatternByName(const std::string &name);
+
+/**
+ * Create the address pattern described by config. Throws a std::runtime_error
+ * if the pattern cannot be set up, e.g., because a replay file is missing.
+ */
+AddressPattern *CreateAddressPattern(const TrafficGeneratorConfig &config);
+
+#endif // MEMPOOL_TB_DPI_ADDRESS_PATTERN_H_
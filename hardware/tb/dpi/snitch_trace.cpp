@@ -0,0 +1,158 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Binary tracer of the Snitch harts. Every hart writes its own, buffered and
+// optionally gzip-compressed trace file. A trace is only ever touched by the
+// DPI calls of its hart, such that no locking is needed.
+
+#include "snitch_trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <zlib.h>
+
+// Function declarations
+extern "C" {
+void *snitch_trace_open(unsigned int hart_id, int compression);
+void snitch_trace_record(
+    void *trace, uint64_t time, uint64_t cycle, unsigned int pc,
+    unsigned int insn, unsigned int source, unsigned int stall,
+    unsigned int stall_tot, unsigned int stall_ins, unsigned int stall_raw,
+    unsigned int stall_lsu, unsigned int stall_acc, unsigned int rs1,
+    unsigned int rs2, unsigned int rd, unsigned int is_load,
+    unsigned int is_store, unsigned int is_branch, unsigned int pc_d,
+    unsigned int opa, unsigned int opb, unsigned int opa_select,
+    unsigned int opb_select, unsigned int opc_select, unsigned int write_rd,
+    unsigned int csr_addr, unsigned int writeback, unsigned int gpr_rdata_1,
+    unsigned int gpr_rdata_2, unsigned int ls_size, unsigned int ld_result_32,
+    unsigned int lsu_rd, unsigned int retire_load, unsigned int alu_result,
+    unsigned int ls_amo, unsigned int retire_acc, unsigned int acc_pid,
+    unsigned int acc_pdata_32);
+void snitch_trace_close(void *trace);
+}
+
+// Number of records buffered before they are handed to zlib
+#define SNITCH_TRACE_BUFFER 8192
+
+typedef struct {
+  gzFile file;
+  uint32_t num_records;
+  snitch_trace_record_t records[SNITCH_TRACE_BUFFER];
+} snitch_trace_t;
+
+static void flush(snitch_trace_t *trace) {
+  if (trace->num_records) {
+    gzwrite(trace->file, trace->records,
+            trace->num_records * sizeof(snitch_trace_record_t));
+    trace->num_records = 0;
+  }
+}
+
+extern "C" void *snitch_trace_open(unsigned int hart_id, int compression) {
+  // Format in hex and with 8 digits, like the names of the text traces
+  char fn[64];
+  snprintf(fn, sizeof(fn), "trace_hart_0x%08x.strace", hart_id);
+
+  // Write uncompressed traces transparently, i.e., without a gzip wrapper. The
+  // decoder tells both apart by the gzip magic number.
+  char mode[8];
+  if (compression > 0) {
+    snprintf(mode, sizeof(mode), "wb%d", compression > 9 ? 9 : compression);
+  } else {
+    snprintf(mode, sizeof(mode), "wbT");
+  }
+
+  gzFile file = gzopen(fn, mode);
+  if (file == NULL) {
+    printf("[Tracer] Could not open %s\n", fn);
+    return NULL;
+  }
+  printf("[Tracer] Logging Hart %d to %s\n", hart_id, fn);
+
+  snitch_trace_header_t header;
+  memset(&header, 0, sizeof(header));
+  strncpy(header.magic, SNITCH_TRACE_MAGIC, sizeof(header.magic));
+  header.version = SNITCH_TRACE_VERSION;
+  header.hart_id = hart_id;
+  gzwrite(file, &header, sizeof(header));
+
+  snitch_trace_t *trace = new snitch_trace_t;
+  trace->file = file;
+  trace->num_records = 0;
+  return trace;
+}
+
+extern "C" void snitch_trace_record(
+    void *handle, uint64_t time, uint64_t cycle, unsigned int pc,
+    unsigned int insn, unsigned int source, unsigned int stall,
+    unsigned int stall_tot, unsigned int stall_ins, unsigned int stall_raw,
+    unsigned int stall_lsu, unsigned int stall_acc, unsigned int rs1,
+    unsigned int rs2, unsigned int rd, unsigned int is_load,
+    unsigned int is_store, unsigned int is_branch, unsigned int pc_d,
+    unsigned int opa, unsigned int opb, unsigned int opa_select,
+    unsigned int opb_select, unsigned int opc_select, unsigned int write_rd,
+    unsigned int csr_addr, unsigned int writeback, unsigned int gpr_rdata_1,
+    unsigned int gpr_rdata_2, unsigned int ls_size, unsigned int ld_result_32,
+    unsigned int lsu_rd, unsigned int retire_load, unsigned int alu_result,
+    unsigned int ls_amo, unsigned int retire_acc, unsigned int acc_pid,
+    unsigned int acc_pdata_32) {
+  snitch_trace_t *trace = static_cast<snitch_trace_t *>(handle);
+  if (trace == NULL) {
+    return;
+  }
+
+  snitch_trace_record_t &rec = trace->records[trace->num_records];
+  rec.time = time;
+  rec.cycle = cycle;
+  rec.pc = pc;
+  rec.insn = insn;
+  rec.pc_d = pc_d;
+  rec.opa = opa;
+  rec.opb = opb;
+  rec.writeback = writeback;
+  rec.gpr_rdata_1 = gpr_rdata_1;
+  rec.gpr_rdata_2 = gpr_rdata_2;
+  rec.ld_result_32 = ld_result_32;
+  rec.alu_result = alu_result;
+  rec.acc_pdata_32 = acc_pdata_32;
+  rec.stall_tot = stall_tot;
+  rec.stall_ins = stall_ins;
+  rec.stall_raw = stall_raw;
+  rec.stall_lsu = stall_lsu;
+  rec.stall_acc = stall_acc;
+  rec.csr_addr = csr_addr;
+  rec.rs1 = rs1;
+  rec.rs2 = rs2;
+  rec.rd = rd;
+  rec.lsu_rd = lsu_rd;
+  rec.acc_pid = acc_pid;
+  rec.ls_size = ls_size;
+  rec.source = source;
+  rec.opa_select = opa_select;
+  rec.opb_select = opb_select;
+  rec.opc_select = opc_select;
+  rec.ls_amo = ls_amo;
+  rec.flags = (stall ? SNITCH_TRACE_STALL : 0) |
+              (is_load ? SNITCH_TRACE_IS_LOAD : 0) |
+              (is_store ? SNITCH_TRACE_IS_STORE : 0) |
+              (is_branch ? SNITCH_TRACE_IS_BRANCH : 0) |
+              (write_rd ? SNITCH_TRACE_WRITE_RD : 0) |
+              (retire_load ? SNITCH_TRACE_RETIRE_LOAD : 0) |
+              (retire_acc ? SNITCH_TRACE_RETIRE_ACC : 0);
+  rec.reserved[0] = rec.reserved[1] = 0;
+
+  if (++trace->num_records == SNITCH_TRACE_BUFFER) {
+    flush(trace);
+  }
+}
+
+extern "C" void snitch_trace_close(void *handle) {
+  snitch_trace_t *trace = static_cast<snitch_trace_t *>(handle);
+  if (trace == NULL) {
+    return;
+  }
+  flush(trace);
+  gzclose(trace->file);
+  delete trace;
+}
@@ -0,0 +1,83 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef MEMPOOL_TB_DPI_SNITCH_TRACE_H_
+#define MEMPOOL_TB_DPI_SNITCH_TRACE_H_
+
+#include <stdint.h>
+
+/**
+ * Binary trace of a Snitch hart
+ *
+ * A trace file starts with a snitch_trace_header_t, followed by one
+ * snitch_trace_record_t per traced cycle. All fields are little-endian. The
+ * record holds the same information as a line of the text trace, i.e., the
+ * instruction and the annotations that gen_trace.py evaluates.
+ *
+ * The format is shared with mempool-trace-decode of riscv-isa-sim, which
+ * converts binary traces back to text. Bump SNITCH_TRACE_VERSION on every
+ * change of the layout.
+ */
+
+#define SNITCH_TRACE_MAGIC "SNTRACE"
+#define SNITCH_TRACE_VERSION 1
+
+typedef struct {
+  char magic[8];    ///< SNITCH_TRACE_MAGIC, zero-terminated
+  uint32_t version; ///< SNITCH_TRACE_VERSION
+  uint32_t hart_id; ///< Hart that produced the trace
+} snitch_trace_header_t;
+
+/// Flags of a trace record
+enum {
+  SNITCH_TRACE_STALL = 1 << 0,
+  SNITCH_TRACE_IS_LOAD = 1 << 1,
+  SNITCH_TRACE_IS_STORE = 1 << 2,
+  SNITCH_TRACE_IS_BRANCH = 1 << 3,
+  SNITCH_TRACE_WRITE_RD = 1 << 4,
+  SNITCH_TRACE_RETIRE_LOAD = 1 << 5,
+  SNITCH_TRACE_RETIRE_ACC = 1 << 6,
+};
+
+typedef struct {
+  uint64_t time;  ///< Simulation time in ns
+  uint64_t cycle; ///< Cycle since the end of the reset
+  uint32_t pc;
+  uint32_t insn;
+  uint32_t pc_d;
+  uint32_t opa;
+  uint32_t opb;
+  uint32_t writeback;
+  uint32_t gpr_rdata_1;
+  uint32_t gpr_rdata_2;
+  uint32_t ld_result_32;
+  uint32_t alu_result;
+  uint32_t acc_pdata_32;
+  uint32_t stall_tot;
+  uint32_t stall_ins;
+  uint32_t stall_raw;
+  uint32_t stall_lsu;
+  uint32_t stall_acc;
+  uint16_t csr_addr;
+  uint8_t rs1;
+  uint8_t rs2;
+  uint8_t rd;
+  uint8_t lsu_rd;
+  uint8_t acc_pid;
+  uint8_t ls_size;
+  uint8_t source;
+  uint8_t opa_select;
+  uint8_t opb_select;
+  uint8_t opc_select;
+  uint8_t ls_amo;
+  uint8_t flags; ///< SNITCH_TRACE_* flags
+  uint8_t reserved[2];
+} snitch_trace_record_t;
+
+static_assert(sizeof(snitch_trace_header_t) == 16,
+              "Unexpected size of the binary trace header");
+static_assert(sizeof(snitch_trace_record_t) == 96,
+              "Unexpected size of the binary trace record");
+
+#endif // MEMPOOL_TB_DPI_SNITCH_TRACE_H_
@@ -4,12 +4,11 @@
 
 // Author: Matheus Cavalcante, ETH Zurich
 
+#include "traffic_generator.h"
+
 // Includes
 #include <iostream>
-#include <limits.h>
-#include <map>
-#include <mutex>
-#include <queue>
+#include <memory>
 #include <random>
 #include <stdint.h>
 
@@ -33,7 +32,7 @@ void probe_response(const core_id_t *core_id, const uint32_t *cycle,
 void print_histogram();
 }
 
-// Request probabilities
+// Default request probabilities, can be overridden at runtime
 #ifndef TG_REQ_PROB
 #define TG_REQ_PROB 0.2
 #endif
@@ -42,7 +41,7 @@ void print_histogram();
 #define TG_SEQ_PROB 0
 #endif
 
-// Number of cycles the simulation has ran
+// Default number of cycles the simulation runs, can be overridden at runtime
 #ifndef TG_NCYCLES
 #define TG_NCYCLES 10000
 #endif
@@ -52,14 +51,30 @@ void print_histogram();
 #define NUM_CORES 256
 #endif
 
+// Number of transaction identifiers per core (must be a power of two)
+#ifndef TG_NUM_IDS
+#define TG_NUM_IDS 2048
+#endif
+
+// Number of bins of the latency histogram. Longer latencies are accounted
+// in the last bin.
+#ifndef TG_MAX_LATENCY
+#define TG_MAX_LATENCY 1024
+#endif
+
+static_assert((TG_NUM_IDS & (TG_NUM_IDS - 1)) == 0,
+              "TG_NUM_IDS must be a power of two");
+
 // Randomizer
 std::random_device r;
-std::default_random_engine e1(r());
-std::uniform_int_distribution<addr_t> addr_dist(0, INT_MAX);
-std::uniform_real_distribution<float> real_dist(0, 1);
 
-// Mutexes
-std::mutex g_mutex;
+// Runtime configuration
+TrafficGeneratorConfig g_config = {
+    TG_REQ_PROB, TG_SEQ_PROB, TG_NCYCLES, r(), kPatternUniform, 4, 0.5, 0, 1.0,
+    ""};
+
+// Address pattern
+std::unique_ptr<AddressPattern> g_pattern(CreateAddressPattern(g_config));
 
 // Request struct
 typedef struct {
@@ -67,61 +82,86 @@ typedef struct {
   req_id_t id;
 } request_t;
 
-// Map the starting cycle of each request
-std::map<std::pair<core_id_t, req_id_t>, uint32_t> starting_cycle;
-// Latency histogram
-std::map<uint32_t, uint32_t> latency_histogram;
-// Request queues
-std::map<core_id_t, std::queue<request_t>> requests;
-
-// Transaction IDs
-uint32_t tran_id_initialized = 0;
-std::map<core_id_t, std::queue<req_id_t>> tran_id;
+// Fixed-size FIFO. It never holds more than N elements, since every element
+// is tied to one of the core's transaction identifiers.
+template <typename T, uint32_t N> struct ring_buffer_t {
+  T data[N];
+  uint32_t head;
+  uint32_t tail;
+
+  bool empty() const { return head == tail; }
+  uint32_t size() const { return tail - head; }
+  T &front() { return data[head & (N - 1)]; }
+  void push(const T &val) { data[tail++ & (N - 1)] = val; }
+  void pop() { head++; }
+};
+
+// State of a single core's traffic generator. Each core's state is only
+// touched by the DPI calls of that core, such that the calls need no locking
+// and stay safe when the model is evaluated by several threads. The states are
+// cache-line aligned to avoid false sharing between neighboring cores.
+typedef struct alignas(64) {
+  bool initialized;
+  // Randomizer, seeded per core to be independent of the evaluation order
+  std::default_random_engine engine;
+  // Request queue
+  ring_buffer_t<request_t, TG_NUM_IDS> requests;
+  // Free transaction IDs
+  ring_buffer_t<req_id_t, TG_NUM_IDS> tran_id;
+  // Starting cycle of each request, indexed by the transaction ID
+  uint32_t starting_cycle[TG_NUM_IDS];
+  // Latency histogram
+  uint32_t latency_histogram[TG_MAX_LATENCY];
+  uint64_t latency;
+  uint64_t transactions;
+} core_state_t;
+
+core_state_t core_state[NUM_CORES];
+
+static void init_core_state(core_id_t core_id, core_state_t &state) {
+  state.engine.seed(g_config.seed + core_id);
+  state.requests.head = state.requests.tail = 0;
+  state.tran_id.head = state.tran_id.tail = 0;
+  for (req_id_t id = 0; id < TG_NUM_IDS; id++)
+    state.tran_id.push(id);
+  for (uint32_t l = 0; l < TG_MAX_LATENCY; l++)
+    state.latency_histogram[l] = 0;
+  state.latency = 0;
+  state.transactions = 0;
+  state.initialized = true;
+}
 
 extern "C" void create_request(const core_id_t *core_id, const uint32_t *cycle,
                                const addr_t *tcdm_base_addr,
                                const addr_t *tcdm_mask, const addr_t *tile_mask,
                                const addr_t *seq_mask, bool *req_valid,
                                req_id_t *req_id, addr_t *req_addr) {
-  // Lock the function
-  std::lock_guard<std::mutex> guard(g_mutex);
-
-  // Initialize the transaction ID queues
-  if (!tran_id_initialized) {
-    for (int c = 0; c < NUM_CORES; c++)
-      for (int id = 0; id < 2048; id++)
-        tran_id[c].push(id);
-    tran_id_initialized = 1;
+  core_state_t &state = core_state[*core_id];
+  std::uniform_real_distribution<float> real_dist(0, 1);
+
+  // Initialize the transaction ID queue
+  if (!state.initialized) {
+    init_core_state(*core_id, state);
   }
 
   // Generate new request
-  if (!tran_id[*core_id].empty()) {
-    if (real_dist(e1) < TG_REQ_PROB) {
+  if (!state.tran_id.empty()) {
+    if (real_dist(state.engine) < g_config.req_prob) {
       // Generate new address
+      TcdmMap map(*tcdm_base_addr, *tcdm_mask, *tile_mask, *seq_mask);
       request_t next_request;
 
-      // Transaction id
-      req_id_t req_id = tran_id[*core_id].front();
-      tran_id[*core_id].pop();
-
-      next_request.id = req_id;
-      next_request.addr = addr_dist(e1);
-      // Make sure the request is in the TCDM region
-      next_request.addr =
-          (next_request.addr & ~(*tcdm_mask)) | (*tcdm_base_addr & *tcdm_mask);
+      if (g_pattern->NextAddress(*core_id, map, state.engine,
+                                 &next_request.addr)) {
+        // Transaction id
+        req_id_t req_id = state.tran_id.front();
+        state.tran_id.pop();
+        next_request.id = req_id;
 
-      // Should the request be in the sequential region?
-      if (real_dist(e1) < TG_SEQ_PROB) {
-        next_request.addr =
-            (next_request.addr & ~(*tile_mask)) | (*seq_mask & *tile_mask);
+        // Push the request
+        state.starting_cycle[req_id] = *cycle;
+        state.requests.push(next_request);
       }
-
-      // Address is aligned to 32 bits
-      next_request.addr = (next_request.addr >> 2) << 2;
-
-      // Push the request
-      starting_cycle[std::make_pair(*core_id, req_id)] = *cycle;
-      requests[*core_id].push(next_request);
     }
   } else {
     std::cerr
@@ -130,10 +170,10 @@ extern "C" void create_request(const core_id_t *core_id, const uint32_t *cycle,
   }
 
   // Is there a request to be sent?
-  if (!requests[*core_id].empty()) {
+  if (!state.requests.empty()) {
     *req_valid = true;
-    *req_id = requests[*core_id].front().id;
-    *req_addr = requests[*core_id].front().addr;
+    *req_id = state.requests.front().id;
+    *req_addr = state.requests.front().addr;
   } else {
     *req_valid = false;
     *req_id = 0;
@@ -144,43 +184,69 @@ extern "C" void create_request(const core_id_t *core_id, const uint32_t *cycle,
 extern "C" void probe_response(const core_id_t *core_id, const uint32_t *cycle,
                                const bool req_ready, const bool resp_valid,
                                const req_id_t *resp_id) {
-  // Lock the function
-  std::lock_guard<std::mutex> guard(g_mutex);
+  core_state_t &state = core_state[*core_id];
 
   // Acknowledged request
-  if (req_ready && !requests[*core_id].empty()) {
+  if (req_ready && !state.requests.empty()) {
     // Pop the request
-    requests[*core_id].pop();
+    state.requests.pop();
   }
 
   // Acknowledged response
   if (resp_valid) {
+    req_id_t id = *resp_id & (TG_NUM_IDS - 1);
+
     // Free the request ID
-    tran_id[*core_id].push(*resp_id);
+    state.tran_id.push(id);
 
     // Account for the latency
-    uint32_t latency =
-        *cycle - starting_cycle[std::make_pair(*core_id, *resp_id)];
-    if (latency_histogram.count(latency) != 0)
-      latency_histogram[latency]++;
-    else
-      latency_histogram[latency] = 1;
+    uint32_t latency = *cycle - state.starting_cycle[id];
+    uint32_t bin = latency < TG_MAX_LATENCY ? latency : TG_MAX_LATENCY - 1;
+    state.latency_histogram[bin]++;
+    state.latency += latency;
+    state.transactions++;
   }
 }
 
 extern "C" void print_histogram() {
-  uint32_t latency = 0;
-  uint32_t tran_counter = 0;
-
   std::cout << "Latency\tCount" << std::endl;
-  for (const auto &it : latency_histogram) {
-    tran_counter += it.second;
-    latency += it.first * it.second;
-    std::cout << it.first << "\t" << it.second << std::endl;
+  for (uint32_t l = 0; l < TG_MAX_LATENCY; l++) {
+    uint64_t count = 0;
+    for (core_id_t c = 0; c < NUM_CORES; c++)
+      count += core_state[c].latency_histogram[l];
+    if (count == 0)
+      continue;
+    if (l == TG_MAX_LATENCY - 1)
+      std::cout << ">=";
+    std::cout << l << "\t" << count << std::endl;
   }
 
-  std::cout << "Average latency: " << (1.0 * latency) / tran_counter
-            << std::endl;
-  std::cout << "Throughput: " << (1.0 * tran_counter) / (TG_NCYCLES * NUM_CORES)
-            << std::endl;
+  TrafficGeneratorStats stats = tg_stats();
+  std::cout << "Average latency: " << stats.avg_latency << std::endl;
+  std::cout << "Throughput: " << stats.throughput << std::endl;
+}
+
+TrafficGeneratorConfig &tg_config() { return g_config; }
+
+void tg_configure_pattern() {
+  g_pattern.reset(CreateAddressPattern(g_config));
+}
+
+void tg_seed(uint32_t seed) {
+  g_config.seed = seed;
+  // Re-seed the cores that already generated traffic
+  for (core_id_t c = 0; c < NUM_CORES; c++)
+    core_state[c].engine.seed(seed + c);
+}
+
+TrafficGeneratorStats tg_stats() {
+  TrafficGeneratorStats stats = {0, 0, 0, 0};
+  for (core_id_t c = 0; c < NUM_CORES; c++) {
+    stats.transactions += core_state[c].transactions;
+    stats.latency += core_state[c].latency;
+  }
+  stats.avg_latency = (1.0 * stats.latency) / stats.transactions;
+  stats.throughput =
+      (1.0 * stats.transactions) / ((double)g_config.ncycles * NUM_CORES);
+  return stats;
 }
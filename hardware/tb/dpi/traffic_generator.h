@@ -0,0 +1,67 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef MEMPOOL_TB_DPI_TRAFFIC_GENERATOR_H_
+#define MEMPOOL_TB_DPI_TRAFFIC_GENERATOR_H_
+
+#include <stdint.h>
+#include <string>
+
+#include "address_pattern.h"
+
+/**
+ * Runtime knobs of the DPI traffic generator
+ */
+struct TrafficGeneratorConfig {
+  double req_prob;  ///< Probability of issuing a request in a given cycle
+  double seq_prob;  ///< Probability of a request targeting the own tile
+  uint32_t ncycles; ///< Number of cycles the traffic generation runs for
+  uint32_t seed;    ///< Seed of the address and request randomizers
+  // Address pattern
+  TrafficPattern pattern;
+  uint32_t stride;        ///< Stride in bytes of the stride pattern
+  double hotspot_prob;    ///< Probability of a request hitting the hotspot
+  uint32_t hotspot_bank;  ///< Bank index of the hotspot
+  double zipf_s;          ///< Exponent of the Zipf distribution
+  std::string replay_dir; ///< Directory with the per-core replay traces
+};
+
+/**
+ * Statistics gathered by the traffic generator during one simulation
+ */
+struct TrafficGeneratorStats {
+  uint64_t transactions; ///< Number of completed transactions
+  uint64_t latency;      ///< Accumulated latency of all transactions
+  double avg_latency;    ///< Average latency per transaction in cycles
+  double throughput;     ///< Transactions per core and cycle
+};
+
+/**
+ * Get the runtime configuration of the traffic generator
+ *
+ * The configuration defaults to the TG_REQ_PROB, TG_SEQ_PROB and TG_NCYCLES
+ * macros and can be modified before the simulation starts.
+ */
+TrafficGeneratorConfig &tg_config();
+
+/**
+ * Create the address pattern described by tg_config() and use it for all
+ * subsequent requests. Must not be called while the simulation runs. Throws a
+ * std::runtime_error if the pattern cannot be created.
+ */
+void tg_configure_pattern();
+
+/**
+ * Re-seed the randomizers of the traffic generator
+ *
+ * Every core draws from its own randomizer, seeded with `seed + core_id`.
+ */
+void tg_seed(uint32_t seed);
+
+/**
+ * Get the statistics of the traffic generated so far
+ */
+TrafficGeneratorStats tg_stats();
+
+#endif // MEMPOOL_TB_DPI_TRAFFIC_GENERATOR_H_
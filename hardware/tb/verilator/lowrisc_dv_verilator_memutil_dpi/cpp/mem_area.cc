@@ -16,11 +16,33 @@ extern "C" {
 void simutil_memload(const char *file);
 int simutil_set_mem(int index, const svBitVecVal *val);
 int simutil_get_mem(int index, svBitVecVal *val);
+int simutil_set_mem_bulk(int index, int num_words);
+void simutil_get_bulk_word(int offset, svBitVecVal *val);
+}
+
+// Words handed to the memory during a call to simutil_set_mem_bulk. Word i is
+// located at byte `offset + i * stride` of data and zero-extended if data ends
+// within the word.
+static struct {
+  const uint8_t *data;
+  size_t size;
+  size_t offset;
+  size_t stride;
+  uint32_t width_byte;
+} bulk_src;
+
+void simutil_get_bulk_word(int offset, svBitVecVal *val) {
+  size_t start = bulk_src.offset + (size_t)offset * bulk_src.stride;
+  memset(val, 0, SV_MEM_WIDTH_BYTES);
+  if (start < bulk_src.size) {
+    memcpy(val, bulk_src.data + start,
+           std::min((size_t)bulk_src.width_byte, bulk_src.size - start));
+  }
 }
 
 MemArea::MemArea(const std::string &scope, uint32_t num_words,
-                 uint32_t width_byte)
-    : num_words_(num_words), width_byte_(width_byte) {
+                 uint32_t width_byte, bool bulk_write)
+    : num_words_(num_words), width_byte_(width_byte), bulk_write_(bulk_write) {
   scopes_.push_back(scope);
   num_banks_ = 1;
   assert(0 < num_words);
@@ -28,8 +50,9 @@ MemArea::MemArea(const std::string &scope, uint32_t num_words,
 }
 
 MemArea::MemArea(const std::vector<std::string> &scopes, uint32_t num_words,
-                 uint32_t width_byte)
-    : scopes_(scopes), num_words_(num_words), width_byte_(width_byte) {
+                 uint32_t width_byte, bool bulk_write)
+    : scopes_(scopes), num_words_(num_words), width_byte_(width_byte),
+      bulk_write_(bulk_write) {
   num_banks_ = scopes_.size();
   assert(0 < num_words);
   assert(width_byte <= SV_MEM_WIDTH_BYTES);
@@ -37,6 +60,10 @@ MemArea::MemArea(const std::vector<std::string> &scopes, uint32_t num_words,
 
 void MemArea::Write(uint32_t word_offset,
                     const std::vector<uint8_t> &data) const {
+  if (bulk_write_ && WriteBulk(word_offset, data)) {
+    return;
+  }
+
   // This "mini buffer" is used to transfer each write to SystemVerilog.
   // `simutil_set_mem` takes a fixed SV_MEM_WIDTH_BITS-bit vector but it will
   // only use the bits required for the RAM width. As an example, for a 32-bit
@@ -72,6 +99,35 @@ void MemArea::Write(uint32_t word_offset,
   }
 }
 
+bool MemArea::WriteBulk(uint32_t word_offset,
+                        const std::vector<uint8_t> &data) const {
+  uint32_t data_words = (data.size() + width_byte_ - 1) / width_byte_;
+  assert(word_offset + data_words <= num_words_);
+
+  // The words of a bank are every num_banks_-th word of the data
+  bulk_src.data = data.data();
+  bulk_src.size = data.size();
+  bulk_src.stride = (size_t)num_banks_ * width_byte_;
+  bulk_src.width_byte = width_byte_;
+
+  for (uint32_t bank = 0; bank < num_banks_; ++bank) {
+    // First word of the data that is located in this bank
+    uint32_t first = (bank + num_banks_ - word_offset % num_banks_) % num_banks_;
+    if (first >= data_words) {
+      continue;
+    }
+    uint32_t bank_words = (data_words - first + num_banks_ - 1) / num_banks_;
+    bulk_src.offset = (size_t)first * width_byte_;
+
+    SVScoped scoped(scopes_[bank]);
+    if (!simutil_set_mem_bulk((word_offset + first) / num_banks_,
+                              bank_words)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 std::vector<uint8_t> MemArea::Read(uint32_t word_offset,
                                    uint32_t num_words) const {
   assert(word_offset + num_words <= num_words_);
@@ -124,7 +180,7 @@ void MemArea::ReadBuffer(std::vector<uint8_t> &data,
 }
 
 void MemArea::ReadToMinibuf(uint8_t *minibuf, uint32_t phys_addr) const {
-  SVScoped scoped(scopes_[phys_addr % phys_addr]);
+  SVScoped scoped(scopes_[phys_addr % num_banks_]);
   if (!simutil_get_mem(phys_addr / num_banks_, (svBitVecVal *)minibuf)) {
     std::ostringstream oss;
     oss << "Could not read memory word at physical index 0x" << std::hex
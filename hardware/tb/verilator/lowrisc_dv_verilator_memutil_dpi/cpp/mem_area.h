@@ -20,6 +20,10 @@
 
 /**
  * A "memory area", representing a memory in the simulated design.
+ *
+ * Accesses set the DPI scope, which is a per-thread state of Verilator, and
+ * call into the model. They must be made from the main thread while the model
+ * is not being evaluated, which also holds for multi-threaded models.
  */
 class MemArea {
 public:
@@ -33,10 +37,17 @@ public:
    * @param num_words The number of words of the memory (must be positive)
    *
    * @param size      The width of each entry in bytes (must be positive)
+   *
+   * @param bulk_write Write whole segments with one \c simutil_set_mem_bulk
+   *                   call per scope instead of one \c simutil_set_mem call
+   *                   per word. The scopes need to support this DPI-C
+   *                   interface, and the physical address and contents of a
+   *                   word must match its logical ones.
    */
-  MemArea(const std::string &scope, uint32_t num_words, uint32_t width_byte);
+  MemArea(const std::string &scope, uint32_t num_words, uint32_t width_byte,
+          bool bulk_write = false);
   MemArea(const std::vector<std::string> &scopes, uint32_t num_words,
-          uint32_t width_byte);
+          uint32_t width_byte, bool bulk_write = false);
 
   virtual ~MemArea() {}
 
@@ -87,6 +98,7 @@ protected:
   uint32_t num_words_;  ///< Size of the memory area in words
   uint32_t width_byte_; ///< Size of each word in bytes
   uint32_t num_banks_;  ///< Number of interleaved banks for the memory
+  bool bulk_write_;     ///< Write segments with simutil_set_mem_bulk
 
   /** Write to buf with the data that should be copied to the physical memory
    * for a single memory word.
@@ -134,6 +146,14 @@ protected:
     return logical_addr;
   }
 
+  /** Write data to this memory area with one DPI call per bank
+   *
+   * Returns false if the memory does not support bulk writes, e.g., because
+   * its words are wider than SV_MEM_WIDTH_BITS. The caller then falls back to
+   * writing word by word.
+   */
+  bool WriteBulk(uint32_t word_offset, const std::vector<uint8_t> &data) const;
+
   /** Read the memory word at phys_addr into minibuf
    *
    * minibuf should be at least SV_MEM_WIDTH_BYTES in size. See the
@@ -43,6 +43,18 @@
 #endif
 #endif
 
+// VM_SAVABLE must be set by the user when calling Verilator with --savable.
+#ifndef VM_SAVABLE
+#define VM_SAVABLE 0
+#endif
+
+#if VM_SAVABLE == 1
+#include "verilated_save.h"
+#else
+class VerilatedSerialize;
+class VerilatedDeserialize;
+#endif
+
 #if VM_TRACE == 1
 /**
  * "Base" for all tracers in Verilator with common functionality
@@ -123,6 +135,20 @@ public:
   virtual const char *name() const = 0;
   virtual void trace(VerilatedTracer &tfp, int levels, int options) = 0;
 
+  /**
+   * Serialize the state of the model
+   *
+   * Only supported if the model was verilated with --savable.
+   */
+  virtual void save(VerilatedSerialize &os) = 0;
+
+  /**
+   * Deserialize the state of the model
+   *
+   * Only supported if the model was verilated with --savable.
+   */
+  virtual void restore(VerilatedDeserialize &os) = 0;
+
   /**
    * Get the Verilator-generated device under test
    *
@@ -148,6 +174,20 @@ public:
                                    levels, options);
 #else
     assert(0 && "Tracing not enabled.");
+#endif
+  }
+  void save(VerilatedSerialize &os) {
+#if VM_SAVABLE == 1
+    os << *static_cast<VERILATED_TOPLEVEL_NAME *>(this);
+#else
+    assert(0 && "Checkpointing not enabled.");
+#endif
+  }
+  void restore(VerilatedDeserialize &os) {
+#if VM_SAVABLE == 1
+    os >> *static_cast<VERILATED_TOPLEVEL_NAME *>(this);
+#else
+    assert(0 && "Checkpointing not enabled.");
 #endif
   }
 };
@@ -29,11 +29,40 @@ double sc_time_stamp() { return VerilatorSimCtrl::GetInstance().GetTime(); }
  * This function overrides Verilator's default implementation to more gracefully
  * shut down the simulation.
  */
-void vl_stop(const char *filename, int linenum, const char *hier) VL_MT_UNSAFE {
+void vl_stop(const char *filename, int linenum, const char *hier) VL_MT_SAFE {
   VerilatorSimCtrl::GetInstance().RequestStop(false);
 }
 #endif
 
+/**
+ * A core set its trace CSR
+ *
+ * Called by the tracer of every core the first time its trace CSR is set.
+ */
+extern "C" void simctrl_trace_csr_set(unsigned int hart_id) {
+  VerilatorSimCtrl::GetInstance().TraceCsrSet();
+}
+
+/**
+ * Get the epoch of the simulation
+ *
+ * Called by the tracers of checkpointable models to reopen their trace files
+ * after a restore.
+ */
+extern "C" unsigned int simctrl_epoch() {
+  return VerilatorSimCtrl::GetInstance().GetEpoch();
+}
+
+/**
+ * Get the epoch in which this process started to simulate
+ *
+ * Called by the tracers of checkpointable models to close only the trace files
+ * opened by this process.
+ */
+extern "C" unsigned int simctrl_start_epoch() {
+  return VerilatorSimCtrl::GetInstance().GetStartEpoch();
+}
+
 VerilatorSimCtrl &VerilatorSimCtrl::GetInstance() {
   static VerilatorSimCtrl instance;
   return instance;
@@ -110,6 +139,10 @@ bool VerilatorSimCtrl::ParseCommandArgs(int argc, char **argv, bool &exit_app) {
   const struct option long_options[] = {
       {"term-after-cycles", required_argument, nullptr, 'c'},
       {"trace", no_argument, nullptr, 't'},
+      {"save-at-cycle", required_argument, nullptr, 'A'},
+      {"save-on-trace", no_argument, nullptr, 'T'},
+      {"save-file", required_argument, nullptr, 'F'},
+      {"restore", required_argument, nullptr, 'R'},
       {"help", no_argument, nullptr, 'h'},
       {nullptr, no_argument, nullptr, 0}};
 
@@ -140,6 +173,21 @@ bool VerilatorSimCtrl::ParseCommandArgs(int argc, char **argv, bool &exit_app) {
         return false;
       }
       break;
+    case 'A':
+      if (!read_ul_arg(&save_at_cycle_, "save-at-cycle", optarg)) {
+        exit_app = true;
+        return false;
+      }
+      break;
+    case 'T':
+      save_on_trace_ = true;
+      break;
+    case 'F':
+      save_file_ = optarg;
+      break;
+    case 'R':
+      restore_file_ = optarg;
+      break;
     case 'h':
       PrintHelp();
       exit_app = true;
@@ -155,6 +203,14 @@ bool VerilatorSimCtrl::ParseCommandArgs(int argc, char **argv, bool &exit_app) {
     }
   }
 
+  if ((save_at_cycle_ || save_on_trace_ || !restore_file_.empty()) &&
+      !checkpoint_possible_) {
+    std::cerr << "ERROR: Checkpointing has not been enabled at compile time."
+              << std::endl;
+    exit_app = true;
+    return false;
+  }
+
   // Pass args to verilator
   Verilated::commandArgs(argc, argv);
 
@@ -213,8 +269,11 @@ void VerilatorSimCtrl::SetTimeout(unsigned int cycles) {
 }
 
 void VerilatorSimCtrl::RequestStop(bool simulation_success) {
+  // Called concurrently by multi-threaded models, a failure must stick
+  if (!simulation_success) {
+    simulation_success_ = false;
+  }
   request_stop_ = true;
-  simulation_success_ &= simulation_success;
 }
 
 void VerilatorSimCtrl::RegisterExtension(SimCtrlExtension *ext) {
@@ -222,12 +281,15 @@ void VerilatorSimCtrl::RegisterExtension(SimCtrlExtension *ext) {
 }
 
 VerilatorSimCtrl::VerilatorSimCtrl()
-    : top_(nullptr), time_(0), tracing_enabled_(false),
+    : top_(nullptr), time_(0), start_time_(0), tracing_enabled_(false),
       tracing_enabled_changed_(false), tracing_ever_enabled_(false),
       tracing_possible_(VM_TRACE), initial_reset_delay_cycles_(2),
       reset_duration_cycles_(2), request_stop_(false),
       simulation_success_(true), tracer_(VerilatedTracer()),
-      term_after_cycles_(0) {}
+      term_after_cycles_(0), checkpoint_possible_(VM_SAVABLE),
+      save_at_cycle_(0), save_on_trace_(false), saved_(false),
+      trace_csr_set_(false), save_file_("sim.ckpt"), epoch_(1),
+      start_epoch_(1) {}
 
 void VerilatorSimCtrl::RegisterSignalHandler() {
   struct sigaction sigIntHandler;
@@ -264,7 +326,20 @@ void VerilatorSimCtrl::PrintHelp() const {
                  "  Write a trace file from the start\n\n";
   }
   std::cout << "-c|--term-after-cycles=N\n"
-               "  Terminate simulation after N cycles. 0 means no timeout.\n\n"
+               "  Terminate simulation after N cycles. 0 means no timeout.\n\n";
+  if (checkpoint_possible_) {
+    std::cout << "--save-at-cycle=N\n"
+                 "  Save a checkpoint of the simulation after N cycles\n\n"
+                 "--save-on-trace\n"
+                 "  Save a checkpoint when a core first sets its trace CSR\n\n"
+                 "--save-file=FILE\n"
+                 "  Write the checkpoint to FILE (default: "
+              << save_file_
+              << ")\n\n"
+                 "--restore=FILE\n"
+                 "  Resume the simulation from the checkpoint in FILE\n\n";
+  }
+  std::cout <<
                "-h|--help\n"
                "  Show help\n\n"
                "All arguments are passed to the design and can be used "
@@ -291,14 +366,73 @@ bool VerilatorSimCtrl::TraceOff() {
   return tracing_enabled_;
 }
 
+bool VerilatorSimCtrl::SaveRequested() const {
+  // Only checkpoint complete clock cycles
+  if (saved_ || time_ % 2) {
+    return false;
+  }
+  return (save_at_cycle_ && time_ / 2 >= save_at_cycle_) ||
+         (save_on_trace_ && trace_csr_set_);
+}
+
+bool VerilatorSimCtrl::Save() {
+#if VM_SAVABLE == 1
+  VerilatedSave os;
+  os.open(save_file_.c_str());
+  if (!os.isOpen()) {
+    std::cerr << "ERROR: Could not open checkpoint file `" << save_file_
+              << "'." << std::endl;
+    return false;
+  }
+  vluint64_t time = time_;
+  vluint32_t epoch = epoch_;
+  os << time << epoch;
+  top_->save(os);
+  os.close();
+
+  std::cout << "Saved checkpoint of cycle " << time_ / 2 << " to "
+            << save_file_ << "." << std::endl;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool VerilatorSimCtrl::Restore() {
+#if VM_SAVABLE == 1
+  VerilatedRestore os;
+  os.open(restore_file_.c_str());
+  if (!os.isOpen()) {
+    std::cerr << "ERROR: Could not open checkpoint file `" << restore_file_
+              << "'." << std::endl;
+    return false;
+  }
+  vluint64_t time;
+  vluint32_t epoch;
+  os >> time >> epoch;
+  top_->restore(os);
+  os.close();
+  time_ = time;
+  epoch_ = epoch + 1;
+
+  std::cout << "Restored checkpoint of cycle " << time_ / 2 << " from "
+            << restore_file_ << "." << std::endl;
+  return true;
+#else
+  return false;
+#endif
+}
+
 void VerilatorSimCtrl::PrintStatistics() const {
-  double speed_hz = time_ / 2 / (GetExecutionTimeMs() / 1000.0);
+  // Only account for the cycles simulated in this run, not the restored ones
+  unsigned long cycles = (time_ - start_time_) / 2;
+  double speed_hz = cycles / (GetExecutionTimeMs() / 1000.0);
   double speed_khz = speed_hz / 1000.0;
 
   std::cout << std::endl
             << "Simulation statistics" << std::endl
             << "=====================" << std::endl
-            << "Executed cycles:  " << std::dec << time_ / 2 << std::endl
+            << "Executed cycles:  " << std::dec << cycles << std::endl
             << "Wallclock time:   " << GetExecutionTimeMs() / 1000.0 << " s"
             << std::endl
             << "Simulation speed: " << speed_hz << " cycles/s "
@@ -327,6 +461,16 @@ void VerilatorSimCtrl::Run() {
     top_->trace(tracer_, 99, 0);
   }
 
+  // Resume from a checkpoint. This overwrites the memories initialized before,
+  // and skips the initial blocks and the reset sequence.
+  if (!restore_file_.empty() && !Restore()) {
+    RequestStop(false);
+    time_begin_ = time_end_ = std::chrono::steady_clock::now();
+    return;
+  }
+  start_time_ = time_;
+  start_epoch_ = epoch_;
+
   // Evaluate all initial blocks, including the DPI setup routines
   top_->eval();
 
@@ -364,6 +508,13 @@ void VerilatorSimCtrl::Run() {
 
     Trace();
 
+    if (SaveRequested()) {
+      saved_ = true;
+      if (!Save()) {
+        RequestStop(false);
+      }
+    }
+
     if (request_stop_) {
       std::cout << "Received stop request, shutting down simulation."
                 << std::endl;
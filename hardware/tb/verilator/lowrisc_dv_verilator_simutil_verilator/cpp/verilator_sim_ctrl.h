@@ -5,6 +5,7 @@
 #ifndef OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_VERILATOR_SIM_CTRL_H_
 #define OPENTITAN_HW_DV_VERILATOR_SIMUTIL_VERILATOR_CPP_VERILATOR_SIM_CTRL_H_
 
+#include <atomic>
 #include <chrono>
 #include <string>
 #include <vector>
@@ -19,6 +20,11 @@ enum VerilatorSimCtrlFlags {
 
 /**
  * Simulation controller for verilated simulations
+ *
+ * With a multi-threaded model, RequestStop(), TraceCsrSet() and GetTime() can
+ * be called from any model thread, e.g., through DPI calls or $stop(). All
+ * other functions must be called from the main thread outside of the model's
+ * evaluation.
  */
 class VerilatorSimCtrl {
 public:
@@ -111,6 +117,31 @@ public:
    */
   void RequestStop(bool simulation_success);
 
+  /**
+   * Notify the controller that a core set its trace CSR
+   *
+   * Used to checkpoint the simulation at the first trace CSR write.
+   */
+  void TraceCsrSet() { trace_csr_set_ = true; }
+
+  /**
+   * Get the epoch of the simulation
+   *
+   * The epoch is 1 for a simulation started from reset and one more than the
+   * epoch of the checkpoint for a restored one. A restored simulation skips
+   * the reset, so the tracers use it to reopen their trace files instead of
+   * writing through the handles of the run that saved the checkpoint.
+   */
+  unsigned int GetEpoch() const { return epoch_; }
+
+  /**
+   * Get the epoch in which this process started to simulate
+   *
+   * Trace handles opened in an earlier epoch come from a checkpoint and are
+   * stale in this process.
+   */
+  unsigned int GetStartEpoch() const { return start_epoch_; }
+
   /**
    * Register an extension to be called automatically
    */
@@ -127,19 +158,29 @@ private:
   CData *sig_rst_;
   VerilatorSimCtrlFlags flags_;
   unsigned long time_;
+  unsigned long start_time_;
   bool tracing_enabled_;
   bool tracing_enabled_changed_;
   bool tracing_ever_enabled_;
   bool tracing_possible_;
   unsigned int initial_reset_delay_cycles_;
   unsigned int reset_duration_cycles_;
-  volatile unsigned int request_stop_;
-  volatile bool simulation_success_;
+  std::atomic<bool> request_stop_;
+  std::atomic<bool> simulation_success_;
   std::chrono::steady_clock::time_point time_begin_;
   std::chrono::steady_clock::time_point time_end_;
   VerilatedTracer tracer_;
   unsigned long term_after_cycles_;
   std::vector<SimCtrlExtension *> extension_array_;
+  bool checkpoint_possible_;
+  unsigned long save_at_cycle_;
+  bool save_on_trace_;
+  bool saved_;
+  std::atomic<bool> trace_csr_set_;
+  std::string save_file_;
+  std::string restore_file_;
+  unsigned int epoch_;
+  unsigned int start_epoch_;
 
   /**
    * Default constructor
@@ -199,6 +240,28 @@ private:
    */
   bool TracingPossible() const { return tracing_possible_; }
 
+  /**
+   * Should the model be checkpointed after the current cycle?
+   */
+  bool SaveRequested() const;
+
+  /**
+   * Save the state of the simulation to save_file_
+   *
+   * The checkpoint holds the complete state of the model, including the
+   * contents of all memories such as the L2, and the simulation time.
+   *
+   * @return Return code, true == success
+   */
+  bool Save();
+
+  /**
+   * Restore the state of the simulation from restore_file_
+   *
+   * @return Return code, true == success
+   */
+  bool Restore();
+
   /**
    * Print statistics about the simulation run
    */
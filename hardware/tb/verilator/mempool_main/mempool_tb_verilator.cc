@@ -8,6 +8,7 @@
 #include "verilated_toplevel.h"
 #include "verilator_memutil.h"
 #include "verilator_sim_ctrl.h"
+#include "verilator_traffic_generator.h"
 
 // Please define the following parameters with sensible values
 #ifndef L2_BASE
@@ -39,9 +40,15 @@ int main(int argc, char **argv) {
     l2_scope.push_back("TOP.mempool_tb_verilator.dut.gen_l2_banks[" +
                        std::to_string(i) + "].l2_mem");
   }
-  MemArea l2_mem(l2_scope, L2_SIZE / (AXI_DATA_WIDTH / 8), AXI_DATA_WIDTH / 8);
+  // The L2 banks support bulk writes, which load each segment of an ELF file
+  // with a single DPI call per bank
+  MemArea l2_mem(l2_scope, L2_SIZE / (AXI_DATA_WIDTH / 8), AXI_DATA_WIDTH / 8,
+                 true);
   memutil.RegisterMemoryArea("ram", L2_BASE, &l2_mem);
   simctrl.RegisterExtension(&memutil);
+#else
+  VerilatorTrafficGenerator tg;
+  simctrl.RegisterExtension(&tg);
 #endif
 
   simctrl.SetInitialResetDelay(1);
@@ -53,6 +60,13 @@ int main(int argc, char **argv) {
     return ret_code;
   }
 
+#ifdef TRAFFIC_GEN
+  // Run each point of a load/throughput sweep in its own process
+  if (tg.IsSweep()) {
+    return tg.RunSweep(simctrl);
+  }
+#endif
+
   std::cout << "Simulation of MemPool" << std::endl
             << "=====================" << std::endl
             << std::endl;
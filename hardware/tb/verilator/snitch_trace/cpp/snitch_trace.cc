@@ -0,0 +1 @@
+../../../dpi/snitch_trace.cpp
\ No newline at end of file
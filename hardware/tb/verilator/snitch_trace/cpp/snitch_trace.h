@@ -0,0 +1 @@
+../../../dpi/snitch_trace.h
\ No newline at end of file
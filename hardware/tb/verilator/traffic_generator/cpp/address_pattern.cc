@@ -0,0 +1 @@
+../../../dpi/address_pattern.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../../../dpi/address_pattern.h
\ No newline at end of file
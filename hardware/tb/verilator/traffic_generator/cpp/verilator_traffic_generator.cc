@@ -0,0 +1,422 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "verilator_traffic_generator.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "verilator_sim_ctrl.h"
+
+// Number of threads of the Verilator model, set by the Makefile
+#ifndef VERILATOR_THREADS
+#define VERILATOR_THREADS 1
+#endif
+
+// Parse a floating-point command-line argument in the range [0, 1]
+static bool read_prob_arg(double *arg_val, const char *arg_name,
+                          const char *arg_text) {
+  char *txt_end;
+  errno = 0;
+  *arg_val = strtod(arg_text, &txt_end);
+  if (txt_end == arg_text || *txt_end || errno != 0 || *arg_val < 0 ||
+      *arg_val > 1) {
+    std::cerr << "ERROR: Bad format for " << arg_name << " argument: `"
+              << arg_text << "' is not a probability between 0 and 1.\n";
+    return false;
+  }
+  return true;
+}
+
+// Parse an unsigned 32-bit integer command-line argument
+static bool read_u32_arg(unsigned long *arg_val, const char *arg_name,
+                         const char *arg_text) {
+  char *txt_end;
+  errno = 0;
+  *arg_val = strtoul(arg_text, &txt_end, 0);
+  if (!(('0' <= arg_text[0]) && (arg_text[0] <= '9')) || *txt_end ||
+      errno != 0 || *arg_val > UINT32_MAX) {
+    std::cerr << "ERROR: Bad format for " << arg_name << " argument: `"
+              << arg_text << "' is not an unsigned 32-bit integer.\n";
+    return false;
+  }
+  return true;
+}
+
+// Parse a positive floating-point command-line argument
+static bool read_pos_arg(double *arg_val, const char *arg_name,
+                         const char *arg_text) {
+  char *txt_end;
+  errno = 0;
+  *arg_val = strtod(arg_text, &txt_end);
+  if (txt_end == arg_text || *txt_end || errno != 0 || !(*arg_val > 0)) {
+    std::cerr << "ERROR: Bad format for " << arg_name << " argument: `"
+              << arg_text << "' is not a positive number.\n";
+    return false;
+  }
+  return true;
+}
+
+// Print a usage message to stdout
+static void PrintHelp() {
+  std::cout << "Traffic generator:\n\n"
+               "--tg-req-prob=P\n"
+               "  Probability of a core issuing a request in a cycle\n\n"
+               "--tg-seq-prob=P\n"
+               "  Probability of a request targeting the local tile\n\n"
+               "--tg-ncycles=N\n"
+               "  Generate traffic for N cycles, then terminate\n\n"
+               "--tg-seed=N\n"
+               "  Seed the randomizers with N\n\n"
+               "--tg-pattern=NAME\n"
+               "  Address pattern: uniform, stride, hotspot, group, tile,\n"
+               "  zipf or replay\n\n"
+               "--tg-stride=N\n"
+               "  Stride in bytes of the stride pattern\n\n"
+               "--tg-hotspot-prob=P\n"
+               "  Probability of a request hitting the hotspot bank\n\n"
+               "--tg-hotspot-bank=N\n"
+               "  Global index of the hotspot bank\n\n"
+               "--tg-zipf-s=S\n"
+               "  Exponent of the Zipf distribution over the banks\n\n"
+               "--tg-replay=DIR\n"
+               "  Replay the per-hart traces in DIR (implies --tg-pattern=replay)\n\n"
+               "--tg-sweep=FILE\n"
+               "  Simulate every `req_prob seq_prob' line of FILE\n\n"
+               "--tg-jobs=N\n"
+               "  Simulate up to N sweep points in parallel\n\n"
+               "--tg-results=FILE\n"
+               "  Write the results table of the sweep to FILE\n\n";
+}
+
+void VerilatorTrafficGenerator::ParseSweepFile(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    std::ostringstream oss;
+    oss << "Could not open sweep file `" << path << "'.";
+    throw std::runtime_error(oss.str());
+  }
+
+  std::string line;
+  unsigned int lineno = 0;
+  while (std::getline(file, line)) {
+    lineno++;
+    // Skip comments and empty lines
+    size_t comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+
+    std::istringstream iss(line);
+    SweepPoint point;
+    std::string trailing;
+    if (!(iss >> point.req_prob >> point.seq_prob) || (iss >> trailing) ||
+        point.req_prob < 0 || point.req_prob > 1 || point.seq_prob < 0 ||
+        point.seq_prob > 1) {
+      std::ostringstream oss;
+      oss << "Malformed line " << lineno << " in sweep file `" << path
+          << "': expected `req_prob seq_prob' with probabilities in [0, 1].";
+      throw std::runtime_error(oss.str());
+    }
+    sweep_.push_back(point);
+  }
+
+  if (sweep_.empty()) {
+    std::ostringstream oss;
+    oss << "Sweep file `" << path << "' does not contain any point.";
+    throw std::runtime_error(oss.str());
+  }
+}
+
+bool VerilatorTrafficGenerator::ParseCLIArguments(int argc, char **argv,
+                                                  bool &exit_app) {
+  const struct option long_options[] = {
+      {"tg-req-prob", required_argument, nullptr, 'R'},
+      {"tg-seq-prob", required_argument, nullptr, 'S'},
+      {"tg-ncycles", required_argument, nullptr, 'N'},
+      {"tg-seed", required_argument, nullptr, 'D'},
+      {"tg-pattern", required_argument, nullptr, 'P'},
+      {"tg-stride", required_argument, nullptr, 'T'},
+      {"tg-hotspot-prob", required_argument, nullptr, 'H'},
+      {"tg-hotspot-bank", required_argument, nullptr, 'B'},
+      {"tg-zipf-s", required_argument, nullptr, 'Z'},
+      {"tg-replay", required_argument, nullptr, 'L'},
+      {"tg-sweep", required_argument, nullptr, 'W'},
+      {"tg-jobs", required_argument, nullptr, 'J'},
+      {"tg-results", required_argument, nullptr, 'O'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, no_argument, nullptr, 0}};
+
+  TrafficGeneratorConfig &config = tg_config();
+  unsigned long val;
+
+  // Reset the command parsing index in-case other utils have already parsed
+  // some arguments
+  optind = 1;
+  while (1) {
+    int c = getopt_long(argc, argv, ":h", long_options, nullptr);
+    if (c == -1) {
+      break;
+    }
+
+    // Disable error reporting by getopt
+    opterr = 0;
+
+    switch (c) {
+    case 0:
+      break;
+    case 'R':
+      if (!read_prob_arg(&config.req_prob, "tg-req-prob", optarg)) {
+        return false;
+      }
+      break;
+    case 'S':
+      if (!read_prob_arg(&config.seq_prob, "tg-seq-prob", optarg)) {
+        return false;
+      }
+      break;
+    case 'N':
+      if (!read_u32_arg(&val, "tg-ncycles", optarg)) {
+        return false;
+      }
+      config.ncycles = val;
+      break;
+    case 'D':
+      if (!read_u32_arg(&val, "tg-seed", optarg)) {
+        return false;
+      }
+      tg_seed(val);
+      break;
+    case 'P':
+      try {
+        config.pattern = GetTrafficPatternByName(optarg);
+      } catch (const std::runtime_error &err) {
+        std::cerr << "ERROR: " << err.what() << std::endl;
+        return false;
+      }
+      break;
+    case 'T':
+      if (!read_u32_arg(&val, "tg-stride", optarg)) {
+        return false;
+      }
+      config.stride = val;
+      break;
+    case 'H':
+      if (!read_prob_arg(&config.hotspot_prob, "tg-hotspot-prob", optarg)) {
+        return false;
+      }
+      break;
+    case 'B':
+      if (!read_u32_arg(&val, "tg-hotspot-bank", optarg)) {
+        return false;
+      }
+      config.hotspot_bank = val;
+      break;
+    case 'Z':
+      if (!read_pos_arg(&config.zipf_s, "tg-zipf-s", optarg)) {
+        return false;
+      }
+      break;
+    case 'L':
+      config.replay_dir = optarg;
+      config.pattern = kPatternReplay;
+      break;
+    case 'W':
+      try {
+        ParseSweepFile(optarg);
+      } catch (const std::runtime_error &err) {
+        std::cerr << "ERROR: " << err.what() << std::endl;
+        return false;
+      }
+      break;
+    case 'J':
+      if (!read_u32_arg(&jobs_, "tg-jobs", optarg)) {
+        return false;
+      }
+      if (jobs_ == 0) {
+        std::cerr << "ERROR: tg-jobs must be at least one." << std::endl;
+        return false;
+      }
+      break;
+    case 'O':
+      results_file_ = optarg;
+      break;
+    case 'h':
+      PrintHelp();
+      return true;
+    case ':': // missing argument
+      std::cerr << "ERROR: Missing argument." << std::endl << std::endl;
+      return false;
+    case '?':
+    default:;
+      // Ignore unrecognized options since they might be consumed by
+      // other utils
+    }
+  }
+
+  // Set up the address pattern, e.g., load the replay traces
+  try {
+    tg_configure_pattern();
+  } catch (const std::runtime_error &err) {
+    std::cerr << "ERROR: " << err.what() << std::endl;
+    return false;
+  }
+
+  // Stop the simulation once the traffic generation is done
+  VerilatorSimCtrl::GetInstance().SetTimeout(config.ncycles);
+
+  return true;
+}
+
+void VerilatorTrafficGenerator::RunSweepPoint(VerilatorSimCtrl &simctrl,
+                                              size_t idx, int fd) {
+  // The transcript of the individual sweep points is not of interest
+  int devnull = open("/dev/null", O_WRONLY);
+  if (devnull >= 0) {
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+  }
+
+  // Configure this sweep point. Every point gets its own, reproducible seed.
+  TrafficGeneratorConfig &config = tg_config();
+  config.req_prob = sweep_[idx].req_prob;
+  config.seq_prob = sweep_[idx].seq_prob;
+  tg_seed(config.seed + idx);
+
+  simctrl.RunSimulation();
+
+  // Report the statistics to the parent process
+  TrafficGeneratorStats stats = tg_stats();
+  bool success = write(fd, &stats, sizeof(stats)) == sizeof(stats);
+  close(fd);
+
+  std::cout.flush();
+  _exit((success && simctrl.WasSimulationSuccessful()) ? 0 : 1);
+}
+
+int VerilatorTrafficGenerator::RunSweep(VerilatorSimCtrl &simctrl) {
+  struct Worker {
+    size_t idx;
+    int fd;
+  };
+
+#if VERILATOR_THREADS > 1
+  // The workers are forked from the constructed model, whose worker threads
+  // would not survive the fork
+  std::cerr << "ERROR: Sweeps need a single-threaded model, rebuild it with "
+               "verilator_threads=1."
+            << std::endl;
+  return 1;
+#endif
+
+  std::vector<TrafficGeneratorStats> results(sweep_.size());
+  std::vector<bool> valid(sweep_.size(), false);
+  std::map<pid_t, Worker> workers;
+  size_t next = 0;
+
+  std::cout << "Sweeping " << sweep_.size() << " traffic generator points with "
+            << jobs_ << " parallel job(s)." << std::endl;
+
+  while (next < sweep_.size() || !workers.empty()) {
+    // Fork new workers until all job slots are busy
+    while (next < sweep_.size() && workers.size() < jobs_) {
+      int fds[2];
+      if (pipe(fds) != 0) {
+        std::cerr << "ERROR: Could not create a pipe for sweep point " << next
+                  << "." << std::endl;
+        return 1;
+      }
+
+      // Avoid duplicating buffered output in the forked process
+      std::cout.flush();
+      std::cerr.flush();
+
+      pid_t pid = fork();
+      if (pid < 0) {
+        std::cerr << "ERROR: Could not fork sweep point " << next << "."
+                  << std::endl;
+        return 1;
+      }
+      if (pid == 0) {
+        close(fds[0]);
+        RunSweepPoint(simctrl, next, fds[1]);
+      }
+
+      close(fds[1]);
+      workers[pid] = {next, fds[0]};
+      next++;
+    }
+
+    // Collect the results of the next worker to finish
+    int status;
+    pid_t pid = wait(&status);
+    if (pid < 0) {
+      std::cerr << "ERROR: Lost track of the sweep workers." << std::endl;
+      return 1;
+    }
+    auto it = workers.find(pid);
+    if (it == workers.end()) {
+      continue;
+    }
+
+    const Worker &worker = it->second;
+    const SweepPoint &point = sweep_[worker.idx];
+    TrafficGeneratorStats stats;
+    if (read(worker.fd, &stats, sizeof(stats)) == sizeof(stats) &&
+        WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+      results[worker.idx] = stats;
+      valid[worker.idx] = true;
+      std::cout << "Req. Probability: " << point.req_prob
+                << " | Seq. Probability: " << point.seq_prob
+                << " | Avg. Latency: " << stats.avg_latency
+                << " cycle | Throughput: " << stats.throughput
+                << " req/core/cycle" << std::endl;
+    } else {
+      std::cerr << "ERROR: Sweep point " << point.req_prob << " "
+                << point.seq_prob << " failed." << std::endl;
+    }
+    close(worker.fd);
+    workers.erase(it);
+  }
+
+  // Write the results table
+  std::ofstream results_file;
+  if (!results_file_.empty()) {
+    results_file.open(results_file_);
+    if (!results_file) {
+      std::cerr << "ERROR: Could not open results file `" << results_file_
+                << "'." << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &out = results_file_.empty() ? std::cout : results_file;
+
+  bool success = true;
+  out << "req_prob\tseq_prob\tavg_latency\tthroughput" << std::endl;
+  for (size_t i = 0; i < sweep_.size(); ++i) {
+    success &= valid[i];
+    out << sweep_[i].req_prob << "\t" << sweep_[i].seq_prob << "\t";
+    if (valid[i]) {
+      out << results[i].avg_latency << "\t" << results[i].throughput;
+    } else {
+      out << "nan\tnan";
+    }
+    out << std::endl;
+  }
+
+  return success ? 0 : 1;
+}
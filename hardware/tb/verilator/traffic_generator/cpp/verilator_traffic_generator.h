@@ -0,0 +1,72 @@
+// Copyright 2021 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef MEMPOOL_TB_VERILATOR_TRAFFIC_GENERATOR_VERILATOR_TRAFFIC_GENERATOR_H_
+#define MEMPOOL_TB_VERILATOR_TRAFFIC_GENERATOR_VERILATOR_TRAFFIC_GENERATOR_H_
+
+//
+// A wrapper class that configures the DPI traffic generator at runtime
+//
+
+#include <string>
+#include <vector>
+
+#include "sim_ctrl_extension.h"
+#include "traffic_generator.h"
+
+class VerilatorSimCtrl;
+
+/**
+ * Simulation control extension for the DPI traffic generator
+ *
+ * The probabilities and the duration of the traffic generation are read from
+ * the command line, such that a single verilated model serves a whole
+ * load/throughput sweep. A sweep is described by a file with one
+ * `req_prob seq_prob` pair per line. Every point is simulated in a forked copy
+ * of the not yet evaluated model, with up to `--tg-jobs` points in parallel.
+ */
+class VerilatorTrafficGenerator : public SimCtrlExtension {
+public:
+  VerilatorTrafficGenerator() : jobs_(1) {}
+
+  // Declared in SimCtrlExtension
+  bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
+
+  /**
+   * Was a sweep requested on the command line?
+   */
+  bool IsSweep() const { return !sweep_.empty(); }
+
+  /**
+   * Simulate all points of the sweep and write the results table
+   *
+   * Must be called after ParseCommandArgs() and instead of RunSimulation().
+   *
+   * @return main()-compatible process exit code
+   */
+  int RunSweep(VerilatorSimCtrl &simctrl);
+
+private:
+  struct SweepPoint {
+    double req_prob;
+    double seq_prob;
+  };
+
+  std::vector<SweepPoint> sweep_;
+  unsigned long jobs_;
+  std::string results_file_;
+
+  /**
+   * Parse a sweep file. Throws a std::runtime_error on malformed input.
+   */
+  void ParseSweepFile(const std::string &path);
+
+  /**
+   * Simulate a single sweep point in a forked process and report the
+   * statistics through the file descriptor fd. Does not return.
+   */
+  void RunSweepPoint(VerilatorSimCtrl &simctrl, size_t idx, int fd);
+};
+
+#endif // MEMPOOL_TB_VERILATOR_TRAFFIC_GENERATOR_VERILATOR_TRAFFIC_GENERATOR_H_
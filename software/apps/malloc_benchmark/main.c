@@ -0,0 +1,137 @@
+// Copyright 2022 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Concurrent allocation from all cores: small blocks from the slabs of the
+// tiles' sequential heaps, large blocks from the locked interleaved heap
+
+#include <stdint.h>
+
+#include "alloc.h"
+#include "encoding.h"
+#include "printf.h"
+#include "runtime.h"
+#include "synchronization.h"
+
+// Blocks per core
+#ifndef NUM_SMALL
+#define NUM_SMALL 16
+#endif
+#ifndef NUM_LARGE
+#define NUM_LARGE 2
+#endif
+#define LARGE_SIZE 256
+
+uint32_t small_cycles[NUM_CORES] __attribute__((section(".l1")));
+uint32_t large_cycles[NUM_CORES] __attribute__((section(".l1")));
+uint32_t errors __attribute__((section(".l1")));
+
+// Fill the blocks with the core ID and check that no other core wrote them
+static void fill(uint32_t **blocks, uint32_t num, uint32_t words,
+                 uint32_t core_id) {
+  for (uint32_t i = 0; i < num; ++i) {
+    for (uint32_t j = 0; j < words; ++j) {
+      blocks[i][j] = core_id;
+    }
+  }
+}
+
+static uint32_t check(uint32_t **blocks, uint32_t num, uint32_t words,
+                      uint32_t core_id) {
+  uint32_t error = 0;
+  for (uint32_t i = 0; i < num; ++i) {
+    for (uint32_t j = 0; j < words; ++j) {
+      error |= blocks[i][j] != core_id;
+    }
+  }
+  return error;
+}
+
+static void print_cycles(const char *name, uint32_t *cycles, uint32_t num) {
+  uint32_t max = 0, sum = 0;
+  for (uint32_t i = 0; i < NUM_CORES; ++i) {
+    max = cycles[i] > max ? cycles[i] : max;
+    sum += cycles[i];
+  }
+  printf("%s: %u cycles per malloc/free pair (max %u over all cores)\n", name,
+         sum / (NUM_CORES * num), max / num);
+}
+
+int main() {
+  uint32_t core_id = mempool_get_core_id();
+  uint32_t num_cores = mempool_get_core_count();
+  uint32_t *small[NUM_SMALL];
+  uint32_t *large[NUM_LARGE];
+
+  // Initialize synchronization variables
+  mempool_barrier_init(core_id);
+
+  // Initialization
+  if (core_id == 0) {
+    errors = 0;
+  }
+  mempool_init(core_id);
+  mempool_barrier(num_cores);
+
+  // Small blocks of 4 to 64 bytes; the second round reuses the freed blocks
+  for (uint32_t round = 0; round < 2; ++round) {
+    mempool_start_benchmark();
+    uint32_t time = mempool_get_timer();
+    for (uint32_t i = 0; i < NUM_SMALL; ++i) {
+      small[i] = (uint32_t *)simple_malloc(4 << (i % 5));
+    }
+    time = mempool_get_timer() - time;
+    mempool_stop_benchmark();
+    for (uint32_t i = 0; i < NUM_SMALL; ++i) {
+      fill(&small[i], 1, 1 << (i % 5), core_id);
+    }
+    mempool_barrier(num_cores);
+    for (uint32_t i = 0; i < NUM_SMALL; ++i) {
+      if (check(&small[i], 1, 1 << (i % 5), core_id)) {
+        __atomic_fetch_or(&errors, 1, __ATOMIC_SEQ_CST);
+      }
+    }
+    mempool_barrier(num_cores);
+    mempool_start_benchmark();
+    uint32_t start = mempool_get_timer();
+    for (uint32_t i = 0; i < NUM_SMALL; ++i) {
+      simple_free(small[i]);
+    }
+    small_cycles[core_id] = time + mempool_get_timer() - start;
+    mempool_stop_benchmark();
+    mempool_barrier(num_cores);
+  }
+
+  // Large blocks from the interleaved heap
+  mempool_start_benchmark();
+  uint32_t time = mempool_get_timer();
+  for (uint32_t i = 0; i < NUM_LARGE; ++i) {
+    large[i] = (uint32_t *)simple_malloc(LARGE_SIZE);
+  }
+  time = mempool_get_timer() - time;
+  mempool_stop_benchmark();
+  fill(large, NUM_LARGE, LARGE_SIZE / 4, core_id);
+  mempool_barrier(num_cores);
+  if (check(large, NUM_LARGE, LARGE_SIZE / 4, core_id)) {
+    __atomic_fetch_or(&errors, 1, __ATOMIC_SEQ_CST);
+  }
+  mempool_barrier(num_cores);
+  mempool_start_benchmark();
+  uint32_t start = mempool_get_timer();
+  for (uint32_t i = 0; i < NUM_LARGE; ++i) {
+    simple_free(large[i]);
+  }
+  large_cycles[core_id] = time + mempool_get_timer() - start;
+  mempool_stop_benchmark();
+  mempool_barrier(num_cores);
+
+  if (core_id == 0) {
+    print_cycles("Small blocks (slabs)", small_cycles, NUM_SMALL);
+    print_cycles("Large blocks (first-fit)", large_cycles, NUM_LARGE);
+    printf("%s\n", errors ? "Overlapping blocks" : "No overlapping blocks");
+  }
+
+  // wait until all cores have finished
+  mempool_barrier(num_cores);
+  return (int)errors;
+}
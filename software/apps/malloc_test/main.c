@@ -160,6 +160,30 @@ int main() {
       // Print out allocator
       alloc_dump(tile_alloc);
     }
+
+    // ------------------------------------------------------------------------
+    // Bank-aware Allocation Tests
+    // ------------------------------------------------------------------------
+    printf("Test distributed matrix:\n");
+    alloc_matrix_t matrix;
+    if (matrix_malloc(&matrix, 2 * num_cores, ARRAY_SIZE)) {
+      printf("Matrix allocation failed\n");
+    } else {
+      uint32_t misplaced = 0;
+      for (uint32_t row = 0; row < 2 * num_cores; ++row) {
+        for (uint32_t col = 0; col < ARRAY_SIZE; ++col) {
+          int32_t *element = matrix_element(&matrix, row, col);
+          *element = (int32_t)row;
+          // Core i owns rows 2 * i and 2 * i + 1 in its banks
+          misplaced += alloc_bank_of(element) / BANKING_FACTOR != row / 2;
+        }
+      }
+      printf("Allocated matrix at %08X with %u misplaced elements\n",
+             (uint32_t)matrix.rows, misplaced);
+      alloc_dump(get_alloc_l1());
+      matrix_free(&matrix);
+      alloc_dump(get_alloc_l1());
+    }
   }
 
   // wait until all cores have finished
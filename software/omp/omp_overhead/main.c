@@ -13,6 +13,8 @@
 
 #define N 16
 #define M 4
+// Repetitions of the fork/join measurement
+#define R 8
 
 void work2(unsigned long num) {
   uint32_t i;
@@ -78,6 +80,13 @@ void section_parallel() {
   }
 }
 
+void empty_parallel(uint32_t num_threads) {
+#pragma omp parallel num_threads(num_threads)
+  {
+    // Only fork and join the team
+  }
+}
+
 int main() {
   uint32_t core_id = mempool_get_core_id();
   uint32_t cycles;
@@ -118,6 +127,20 @@ int main() {
     cycles = mempool_get_timer() - cycles;
     printf("Section Duration: %d\n", cycles);
 
+    for (uint32_t num_threads = 1; num_threads <= NUM_CORES;
+         num_threads <<= 1) {
+      // Warm up the instruction cache
+      empty_parallel(num_threads);
+      cycles = mempool_get_timer();
+      mempool_start_benchmark();
+      for (uint32_t i = 0; i < R; i++) {
+        empty_parallel(num_threads);
+      }
+      mempool_stop_benchmark();
+      cycles = mempool_get_timer() - cycles;
+      printf("Fork/Join %u Threads: %d cycles\n", num_threads, cycles / R);
+    }
+
   } else {
     while (1) {
       mempool_wfi();
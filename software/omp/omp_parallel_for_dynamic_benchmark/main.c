@@ -64,6 +64,43 @@ void spmv_dynamic(int *y, int *data, int *colidx, int *rowb, int *rowe, int *x,
   }
 }
 
+void spmv_guided(int *y, int *data, int *colidx, int *rowb, int *rowe, int *x,
+                 int n) {
+  int i, j;
+  int sum;
+  int rowstart;
+  int rowend;
+#pragma omp parallel for num_threads(16) schedule(guided, 4)
+  for (i = 0; i < n; i++) {
+    sum = 0;
+    rowstart = rowb[i];
+    rowend = rowe[i];
+    for (j = rowstart; j < rowend; j++) {
+      sum += data[j] * x[colidx[j]];
+    }
+    y[i] = sum;
+  }
+}
+
+// All cores of the cluster, such that the chunks come from all groups
+void spmv_dynamic_all(int *y, int *data, int *colidx, int *rowb, int *rowe,
+                      int *x, int n) {
+  int i, j;
+  int sum;
+  int rowstart;
+  int rowend;
+#pragma omp parallel for schedule(dynamic, 4)
+  for (i = 0; i < n; i++) {
+    sum = 0;
+    rowstart = rowb[i];
+    rowend = rowe[i];
+    for (j = rowstart; j < rowend; j++) {
+      sum += data[j] * x[colidx[j]];
+    }
+    y[i] = sum;
+  }
+}
+
 int main() {
   uint32_t core_id = mempool_get_core_id();
 
@@ -97,6 +134,20 @@ int main() {
     cycles = mempool_get_timer() - cycles;
     printf("Dynamic Duration: %d\n", cycles);
 
+    cycles = mempool_get_timer();
+    mempool_start_benchmark();
+    spmv_guided(y, nnz, col, rowb, rowe, x, n);
+    mempool_stop_benchmark();
+    cycles = mempool_get_timer() - cycles;
+    printf("Guided Duration: %d\n", cycles);
+
+    cycles = mempool_get_timer();
+    mempool_start_benchmark();
+    spmv_dynamic_all(y, nnz, col, rowb, rowe, x, n);
+    mempool_stop_benchmark();
+    cycles = mempool_get_timer() - cycles;
+    printf("Dynamic (all cores) Duration: %d\n", cycles);
+
   } else {
     while (1) {
       mempool_wfi();
@@ -131,6 +131,26 @@ int32_t dot_product_omp_static(int32_t const *__restrict__ A,
   return dotp;
 }
 
+int32_t dot_product_omp_tree(int32_t const *__restrict__ A,
+                             int32_t const *__restrict__ B,
+                             uint32_t num_elements) {
+  int32_t dotp = 0;
+#pragma omp parallel
+  {
+    int32_t partial = 0;
+#pragma omp for nowait
+    for (uint32_t i = 0; i < num_elements; i++) {
+      partial += A[i] * B[i];
+    }
+    // Combine the partial sums with a tree instead of the ATOMIC lock
+    partial = omp_reduce_int(partial, omp_reduce_add);
+    if (omp_get_thread_num() == 0) {
+      dotp = partial;
+    }
+  }
+  return dotp;
+}
+
 int32_t dot_product_omp_dynamic(int32_t const *__restrict__ A,
                                 int32_t const *__restrict__ B,
                                 uint32_t num_elements, uint32_t chunksize) {
@@ -262,6 +282,24 @@ int main() {
 
     mempool_wait(4 * num_cores);
 
+    cycles = mempool_get_timer();
+    mempool_start_benchmark();
+    omp_result = dot_product_omp_tree(a, b, M);
+    mempool_stop_benchmark();
+    cycles = mempool_get_timer() - cycles;
+
+    printf("OMP Tree Result: %d\n", omp_result);
+    printf("OMP Tree Duration: %d\n", cycles);
+    if (!verify_dotproduct(omp_result, M, A_a, A_b, B_a, B_b,
+                           &correct_result)) {
+      printf("OMP Tree Result is %d instead of %d\n", omp_result,
+             correct_result);
+    } else {
+      printf("Result is correct!\n");
+    }
+
+    mempool_wait(4 * num_cores);
+
     cycles = mempool_get_timer();
     mempool_start_benchmark();
     omp_result = dot_product_omp_dynamic(a, b, M, 4);
@@ -6,6 +6,7 @@
 
 #include "alloc.h"
 #include "printf.h"
+#include "runtime.h"
 
 // ----------------------------------------------------------------------------
 // Block Alignment
@@ -24,6 +25,21 @@
 #define ALIGN_UP(addr, size) ((addr + size - 1) & ~(size - 1))
 #define ALIGN_DOWN(addr, size) (addr & ~(size - 1))
 
+// Slabs start with their header, followed by the blocks
+#define SLAB_HEADER_SIZE                                                       \
+  ALIGN_UP((uint32_t)sizeof(alloc_slab_t), MIN_BLOCK_SIZE)
+
+// Largest block size served from the slabs
+#define MAX_CLASS_SIZE (1U << (ALLOC_MIN_CLASS_LOG2 + ALLOC_NUM_CLASSES - 1))
+
+// Metadata flag of slab blocks, which store their offset in the slab instead
+// of their size (both are multiples of MIN_BLOCK_SIZE)
+#define SLAB_FLAG 1U
+
+// Metadata flag of aligned blocks, which start MIN_BLOCK_SIZE bytes before
+// their data, i.e. with padding before the metadata
+#define ALIGNED_FLAG 2U
+
 // ----------------------------------------------------------------------------
 // Static Variables
 // ----------------------------------------------------------------------------
@@ -55,14 +71,39 @@ static inline canary_and_size_t canary_decode(const uint32_t value) {
   return (canary_and_size_t){.canary = value & 0xFF, .size = value >> 8};
 }
 
+// ----------------------------------------------------------------------------
+// Locking of the linked list of free blocks
+// ----------------------------------------------------------------------------
+static inline void alloc_lock(alloc_t *alloc) {
+  while (__atomic_fetch_or(&alloc->lock, 1, __ATOMIC_SEQ_CST)) {
+    mempool_wait(NUM_CORES);
+  }
+}
+
+static inline void alloc_unlock(alloc_t *alloc) {
+  __atomic_fetch_and(&alloc->lock, 0, __ATOMIC_SEQ_CST);
+}
+
 // ----------------------------------------------------------------------------
 // Initialization
 // ----------------------------------------------------------------------------
 void alloc_init(alloc_t *alloc, void *base, const uint32_t size) {
+  alloc->lock = 0;
+  for (uint32_t i = 0; i < ALLOC_NUM_CLASSES; ++i) {
+    alloc->slabs[i] = NULL;
+  }
+
   // Create first block at base address aligned up
   uint32_t aligned_base = ALIGN_UP((uint32_t)base, MIN_BLOCK_SIZE);
   alloc_block_t *block_ptr = (alloc_block_t *)aligned_base;
 
+  // Special case: No space for a block (e.g. the stacks fill a tile's
+  // sequential region), which must not be written
+  if (size < aligned_base - (uint32_t)base + MIN_BLOCK_SIZE) {
+    alloc->first_block = NULL;
+    return;
+  }
+
   // Calculate block size aligned down
   uint32_t block_size = size - ((uint32_t)block_ptr - (uint32_t)base);
   block_size = ALIGN_DOWN(block_size, MIN_BLOCK_SIZE);
@@ -116,6 +157,125 @@ static void *allocate_memory(alloc_t *alloc, const uint32_t size) {
   }
 }
 
+// Allocate a block whose data, MIN_BLOCK_SIZE bytes after its start, is
+// aligned (align must be a multiple of MIN_BLOCK_SIZE)
+static void *allocate_memory_aligned(alloc_t *alloc, const uint32_t size,
+                                     const uint32_t align) {
+  alloc_block_t *curr = alloc->first_block;
+  alloc_block_t *prev = 0;
+
+  // Search first block large enough after the alignment in linked list
+  while (curr) {
+    uint32_t start =
+        ALIGN_UP((uint32_t)curr + MIN_BLOCK_SIZE, align) - MIN_BLOCK_SIZE;
+    uint32_t front = start - (uint32_t)curr;
+    if (curr->size >= front + size) {
+      // Split off the block behind, if any
+      alloc_block_t *next = curr->next;
+      uint32_t back = curr->size - front - size;
+      if (back) {
+        alloc_block_t *new_block = (alloc_block_t *)(start + size);
+        new_block->size = back;
+        new_block->next = next;
+        next = new_block;
+      }
+      // Keep the block in front, if any
+      if (front) {
+        curr->size = front;
+        curr->next = next;
+      } else if (prev) {
+        prev->next = next;
+      } else {
+        alloc->first_block = next;
+      }
+      return (void *)start;
+    }
+    prev = curr;
+    curr = curr->next;
+  }
+
+  // There is no free block large enough
+  return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Allocate Memory from Slabs
+// ----------------------------------------------------------------------------
+static inline int32_t size_class(const uint32_t block_size) {
+  for (uint32_t i = 0; i < ALLOC_NUM_CLASSES; ++i) {
+    if (block_size <= (1U << (ALLOC_MIN_CLASS_LOG2 + i))) {
+      return (int32_t)i;
+    }
+  }
+  return -1;
+}
+
+// Block of a slab given by its bit in the bitmap
+static inline void *slab_block(alloc_slab_t *slab, const uint32_t bit) {
+  uint32_t index = (uint32_t)__builtin_ctz(bit);
+  uint32_t offset = SLAB_HEADER_SIZE + (index << slab->log2_block_size);
+  void *block_ptr = (void *)((char *)slab + offset);
+  *((uint32_t *)block_ptr) = canary_encode(block_ptr, offset | SLAB_FLAG);
+  return block_ptr;
+}
+
+// Add a slab to the class with its first block allocated (locked)
+static alloc_slab_t *slab_create(alloc_t *alloc, const uint32_t class_id) {
+  const uint32_t slab_size =
+      ALIGN_UP(SLAB_HEADER_SIZE + ALLOC_SLAB_SIZE, MIN_BLOCK_SIZE);
+  alloc_slab_t *slab = (alloc_slab_t *)allocate_memory(alloc, slab_size);
+  if (!slab && alloc != &alloc_l1) {
+    // Fall back to the interleaved heap
+    alloc_lock(&alloc_l1);
+    slab = (alloc_slab_t *)allocate_memory(&alloc_l1, slab_size);
+    alloc_unlock(&alloc_l1);
+  }
+  if (!slab) {
+    return NULL;
+  }
+
+  // Mark the blocks beyond the slab and the first block as used
+  uint32_t log2_block_size = ALLOC_MIN_CLASS_LOG2 + class_id;
+  uint32_t num_blocks = ALLOC_SLAB_SIZE >> log2_block_size;
+  slab->used = (num_blocks < 32 ? ~0U << num_blocks : 0) | 1;
+  slab->log2_block_size = log2_block_size;
+  slab->next = alloc->slabs[class_id];
+  // Publish the initialized slab to the lock-free readers
+  __sync_synchronize();
+  alloc->slabs[class_id] = slab;
+  return slab;
+}
+
+static void *slab_malloc(alloc_t *alloc, const uint32_t class_id) {
+  while (1) {
+    // Claim the first free block of any slab with an AMO on its bitmap
+    alloc_slab_t *head = alloc->slabs[class_id];
+    for (alloc_slab_t *slab = head; slab; slab = slab->next) {
+      uint32_t used = slab->used;
+      while (~used) {
+        uint32_t bit = ~used & (used + 1);
+        used = __atomic_fetch_or(&slab->used, bit, __ATOMIC_SEQ_CST);
+        if (!(used & bit)) {
+          return slab_block(slab, bit);
+        }
+        used |= bit;
+      }
+    }
+
+    // All slabs are full: Add one, unless another core did in the meantime
+    alloc_lock(alloc);
+    if (alloc->slabs[class_id] == head) {
+      alloc_slab_t *slab = slab_create(alloc, class_id);
+      alloc_unlock(alloc);
+      return slab ? slab_block(slab, 1) : NULL;
+    }
+    alloc_unlock(alloc);
+  }
+}
+
+// ----------------------------------------------------------------------------
+// Allocate Memory
+// ----------------------------------------------------------------------------
 void *domain_malloc(alloc_t *alloc, const uint32_t size) {
   // Calculate actually required block size
   uint32_t data_size = size + sizeof(uint32_t); // add size/metadata
@@ -128,25 +288,70 @@ void *domain_malloc(alloc_t *alloc, const uint32_t size) {
     return NULL;
   }
 
-  // Allocate memory
-  void *block_ptr = allocate_memory(alloc, block_size);
+  // Allocate memory from a slab of the size class, or from the free blocks
+  void *block_ptr;
+  int32_t class_id = size_class(block_size);
+  if (class_id >= 0) {
+    block_ptr = slab_malloc(alloc, (uint32_t)class_id);
+  } else {
+    alloc_lock(alloc);
+    block_ptr = allocate_memory(alloc, block_size);
+    alloc_unlock(alloc);
+    if (block_ptr) {
+      // Store canary and size into first four bytes
+      *((uint32_t *)block_ptr) = canary_encode(block_ptr, block_size);
+    }
+  }
   if (!block_ptr) {
     printf("Memory allocator: No large enough block found (%d)\n", block_size);
     return NULL;
   }
 
-  // Store canary and size into first four bytes
-  *((uint32_t *)block_ptr) = canary_encode(block_ptr, block_size);
-
   // Return data pointer
   void *data_ptr = (void *)((uint32_t *)block_ptr + 1);
   return data_ptr;
 }
 
 void *simple_malloc(const uint32_t size) {
+  // Small blocks from the sequential heap of the own tile
+  if (size + sizeof(uint32_t) <= MAX_CLASS_SIZE) {
+    return domain_malloc(&alloc_tile[mempool_get_tile_id()], size);
+  }
   return domain_malloc(&alloc_l1, size);
 }
 
+void *domain_malloc_aligned(alloc_t *alloc, const uint32_t size,
+                            const uint32_t align) {
+  // Data pointers of regular blocks are aligned to a word
+  if (align <= sizeof(uint32_t)) {
+    return domain_malloc(alloc, size);
+  }
+
+  // Calculate actually required block size with the padding
+  uint32_t data_size = size + MIN_BLOCK_SIZE;
+  uint32_t block_size = ALIGN_UP(data_size, MIN_BLOCK_SIZE);
+  if (block_size >= (1 << (sizeof(uint32_t) * 8 - sizeof(uint8_t) * 8))) {
+    printf("Memory allocator: Requested memory exceeds max block size\n");
+    return NULL;
+  }
+
+  // Allocate memory
+  uint32_t block_align = align > MIN_BLOCK_SIZE ? align : MIN_BLOCK_SIZE;
+  alloc_lock(alloc);
+  void *block_ptr = allocate_memory_aligned(alloc, block_size, block_align);
+  alloc_unlock(alloc);
+  if (!block_ptr) {
+    printf("Memory allocator: No large enough block found (%d)\n", block_size);
+    return NULL;
+  }
+
+  // Store canary and size into the four bytes before the data
+  void *data_ptr = (void *)((char *)block_ptr + MIN_BLOCK_SIZE);
+  uint32_t *metadata_ptr = (uint32_t *)data_ptr - 1;
+  *metadata_ptr = canary_encode(metadata_ptr, block_size | ALIGNED_FLAG);
+  return data_ptr;
+}
+
 // ----------------------------------------------------------------------------
 // Free Memory
 // ----------------------------------------------------------------------------
@@ -188,6 +393,16 @@ static void free_memory(alloc_t *alloc, void *const ptr, const uint32_t size) {
   }
 }
 
+// Free a block of a slab, whichever allocator it belongs to
+static void slab_free(void *const block_ptr, const uint32_t offset) {
+  alloc_slab_t *slab = (alloc_slab_t *)((char *)block_ptr - offset);
+  uint32_t index = (offset - SLAB_HEADER_SIZE) >> slab->log2_block_size;
+  uint32_t bit = 1U << index;
+  if (!(__atomic_fetch_and(&slab->used, ~bit, __ATOMIC_SEQ_CST) & bit)) {
+    printf("Double free at %p\n", block_ptr);
+  }
+}
+
 void domain_free(alloc_t *alloc, void *const ptr) {
   // Get block pointer from data pointer
   void *block_ptr = (void *)((uint32_t *)ptr - 1);
@@ -203,11 +418,45 @@ void domain_free(alloc_t *alloc, void *const ptr) {
   }
 
   // Free memory
-  free_memory(alloc, block_ptr, canary_and_size.size);
+  if (canary_and_size.size & SLAB_FLAG) {
+    slab_free(block_ptr, canary_and_size.size & ~SLAB_FLAG);
+  } else if (canary_and_size.size & ALIGNED_FLAG) {
+    alloc_lock(alloc);
+    free_memory(alloc,
+                (char *)block_ptr + sizeof(uint32_t) - MIN_BLOCK_SIZE,
+                canary_and_size.size & ~ALIGNED_FLAG);
+    alloc_unlock(alloc);
+  } else {
+    alloc_lock(alloc);
+    free_memory(alloc, block_ptr, canary_and_size.size);
+    alloc_unlock(alloc);
+  }
 }
 
 void simple_free(void *const ptr) { domain_free(&alloc_l1, ptr); }
 
+// ----------------------------------------------------------------------------
+// Bank-aware Allocation
+// ----------------------------------------------------------------------------
+void *rows_malloc(const uint32_t num_rows) {
+  return domain_malloc_aligned(&alloc_l1, num_rows * ALLOC_ROW_SIZE,
+                               ALLOC_ROW_SIZE);
+}
+
+void rows_free(void *const rows) { domain_free(&alloc_l1, rows); }
+
+int matrix_malloc(alloc_matrix_t *matrix, const uint32_t num_rows,
+                  const uint32_t num_cols) {
+  matrix->num_cols = num_cols;
+  matrix->rows_per_core = (num_rows + NUM_CORES - 1) / NUM_CORES;
+  matrix->stripes_per_row = (num_cols + BANKING_FACTOR - 1) / BANKING_FACTOR;
+  matrix->rows = (int32_t *)rows_malloc(matrix->rows_per_core *
+                                        matrix->stripes_per_row);
+  return matrix->rows ? 0 : -1;
+}
+
+void matrix_free(alloc_matrix_t *matrix) { rows_free(matrix->rows); }
+
 // ----------------------------------------------------------------------------
 // Debugging Functions
 // ----------------------------------------------------------------------------
@@ -231,6 +480,14 @@ void alloc_dump(alloc_t *alloc) {
     // Go to next block
     curr = curr->next;
   }
+
+  // Print out slabs of the size classes
+  for (uint32_t i = 0; i < ALLOC_NUM_CLASSES; ++i) {
+    for (alloc_slab_t *slab = alloc->slabs[i]; slab; slab = slab->next) {
+      printf("Slab at %08X with block size %4u and used blocks %08X\n",
+             (uint32_t)slab, 1U << slab->log2_block_size, slab->used);
+    }
+  }
 }
 
 // ----------------------------------------------------------------------------
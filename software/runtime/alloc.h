@@ -5,7 +5,11 @@
 // Author: Gua Hao Khov, ETH Zurich
 
 /* Dynamic memory allocation based on linked list of free blocks with
- * first-fit search and coalescing with next and previous block
+ * first-fit search and coalescing with next and previous block, protected by
+ * an AMO lock. Small blocks are served lock-free from size-class slabs of the
+ * allocator, carved from its free blocks (or from the L1 interleaved heap if
+ * a tile's sequential heap is exhausted). simple_malloc serves small blocks
+ * from the sequential heap of the calling core's tile.
  */
 
 #ifndef _ALLOC_H_
@@ -22,9 +26,26 @@ typedef struct alloc_block_s {
   struct alloc_block_s *next;
 } alloc_block_t;
 
+// Size classes of the slabs, as block sizes (data + metadata)
+#define ALLOC_MIN_CLASS_LOG2 4 // 16 bytes
+#define ALLOC_NUM_CLASSES 4    // 16, 32, 64, 128 bytes
+// Bytes of blocks per slab (at most 32 blocks)
+#define ALLOC_SLAB_SIZE 512
+
+// Slab of blocks of one size class, allocated and freed with AMOs on the
+// bitmap of used blocks
+typedef struct alloc_slab_s {
+  volatile uint32_t used;
+  struct alloc_slab_s *volatile next;
+  uint32_t log2_block_size;
+  uint32_t reserved;
+} alloc_slab_t;
+
 // Allocator
 typedef struct {
   alloc_block_t *first_block;
+  uint32_t lock;
+  alloc_slab_t *volatile slabs[ALLOC_NUM_CLASSES];
 } alloc_t;
 
 // Initialization
@@ -51,4 +72,91 @@ alloc_t *get_alloc_l1();
 // Get allocator for L1 local sequential heap memory
 alloc_t *get_alloc_tile(const uint32_t tile_id);
 
+// Malloc with specified allocator and alignment (power of 2)
+void *domain_malloc_aligned(alloc_t *alloc, const uint32_t size,
+                            const uint32_t align);
+
+// ----------------------------------------------------------------------------
+// Bank-aware Allocation in the L1 Interleaved Heap
+// ----------------------------------------------------------------------------
+/* Like address_scrambler.sv, the interleaved region maps consecutive words to
+ * consecutive banks, i.e. an L1 row of ALLOC_ROW_SIZE bytes covers every bank
+ * once: BANKING_FACTOR words in the banks of each core, NUM_BANKS_PER_TILE
+ * words in the banks of each tile, in the order of the core IDs.
+ */
+
+#define ALLOC_NUM_BANKS (NUM_CORES * BANKING_FACTOR)
+#define ALLOC_ROW_SIZE (ALLOC_NUM_BANKS * sizeof(uint32_t))
+
+// Global index of the bank of an L1 address (tile * NUM_BANKS_PER_TILE +
+// bank in the tile), in the sequential or the interleaved region
+static inline uint32_t alloc_bank_of(const void *const ptr) {
+  uint32_t word = (uint32_t)ptr / sizeof(uint32_t);
+  uint32_t banks_per_tile = NUM_CORES_PER_TILE * BANKING_FACTOR;
+  if ((uint32_t)ptr < NUM_CORES * SEQ_MEM_SIZE) {
+    uint32_t tile = (uint32_t)ptr / (NUM_CORES_PER_TILE * SEQ_MEM_SIZE);
+    return tile * banks_per_tile + word % banks_per_tile;
+  }
+  return word % ALLOC_NUM_BANKS;
+}
+
+// Malloc of L1 rows in the interleaved heap, aligned to a row
+void *rows_malloc(const uint32_t num_rows);
+
+// Free of rows_malloc
+void rows_free(void *const rows);
+
+// Stripe of a row in the banks of a core (BANKING_FACTOR words), a tile
+// (NUM_BANKS_PER_TILE words) or a group (ALLOC_NUM_BANKS / NUM_GROUPS words)
+static inline uint32_t *alloc_core_stripe(void *const rows, const uint32_t row,
+                                          const uint32_t core_id) {
+  return (uint32_t *)rows + row * ALLOC_NUM_BANKS + core_id * BANKING_FACTOR;
+}
+
+static inline uint32_t *alloc_tile_stripe(void *const rows, const uint32_t row,
+                                          const uint32_t tile_id) {
+  return alloc_core_stripe(rows, row, tile_id * NUM_CORES_PER_TILE);
+}
+
+static inline uint32_t *alloc_group_stripe(void *const rows, const uint32_t row,
+                                           const uint32_t group_id) {
+  return alloc_core_stripe(rows, row, group_id * (NUM_CORES / NUM_GROUPS));
+}
+
+/* Matrix of words distributed over the cores: core i owns the rows i * k to
+ * i * k + k - 1 with k = rows_per_core, and stores each of them in its own
+ * banks, in stripes of BANKING_FACTOR elements on consecutive L1 rows.
+ */
+typedef struct {
+  int32_t *rows;
+  uint32_t num_cols;
+  uint32_t rows_per_core;
+  uint32_t stripes_per_row;
+} alloc_matrix_t;
+
+// Malloc of a num_rows x num_cols matrix with rows_per_core = ceil(num_rows /
+// NUM_CORES); returns 0 on success
+int matrix_malloc(alloc_matrix_t *matrix, const uint32_t num_rows,
+                  const uint32_t num_cols);
+
+// Free of matrix_malloc
+void matrix_free(alloc_matrix_t *matrix);
+
+// Stripe of elements stripe * BANKING_FACTOR to stripe * BANKING_FACTOR +
+// BANKING_FACTOR - 1 of a row, which are contiguous
+static inline int32_t *matrix_stripe(const alloc_matrix_t *matrix,
+                                     const uint32_t row,
+                                     const uint32_t stripe) {
+  uint32_t core_id = row / matrix->rows_per_core;
+  uint32_t l1_row =
+      (row % matrix->rows_per_core) * matrix->stripes_per_row + stripe;
+  return matrix->rows + l1_row * ALLOC_NUM_BANKS + core_id * BANKING_FACTOR;
+}
+
+static inline int32_t *matrix_element(const alloc_matrix_t *matrix,
+                                      const uint32_t row, const uint32_t col) {
+  return matrix_stripe(matrix, row, col / BANKING_FACTOR) +
+         col % BANKING_FACTOR;
+}
+
 #endif
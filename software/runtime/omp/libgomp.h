@@ -54,10 +54,18 @@ extern void GOMP_critical_start(void);
 extern void GOMP_critical_end(void);
 
 /* loop.c */
+extern int GOMP_loop_static_start(int, int, int, int, int *, int *);
+extern int GOMP_loop_static_next(int *, int *);
 extern int GOMP_loop_dynamic_start(int, int, int, int, int *, int *);
 extern int GOMP_loop_dynamic_next(int *, int *);
+extern int GOMP_loop_guided_start(int, int, int, int, int *, int *);
+extern int GOMP_loop_guided_next(int *, int *);
+extern void GOMP_parallel_loop_static(void (*)(void *), void *, unsigned, long,
+                                      long, long, long);
 extern void GOMP_parallel_loop_dynamic(void (*)(void *), void *, unsigned, long,
                                        long, long, long);
+extern void GOMP_parallel_loop_guided(void (*)(void *), void *, unsigned, long,
+                                      long, long, long);
 extern void GOMP_loop_end(void);
 extern void GOMP_loop_end_nowait(void);
 
@@ -66,6 +74,9 @@ extern void GOMP_parallel(void (*)(void *), void *, unsigned int, unsigned int);
 extern void GOMP_parallel_start(void (*)(void *), void *, unsigned int);
 extern void GOMP_parallel_end(void);
 
+/* reduction.c */
+extern void gomp_reduction_init(void);
+
 /* sections.c */
 extern void GOMP_parallel_sections(void (*)(void *), void *, unsigned int, int);
 extern int GOMP_sections_start(int);
@@ -92,15 +103,17 @@ typedef struct {
   void (*fn)(void *);
   void *data;
   uint32_t nthreads;
-  uint32_t barrier;
   uint8_t thread_pool[NUM_CORES];
 } event_t;
 
 typedef struct {
+  int start;
   int end;
-  int next;
+  int next; // Next chunk (dynamic), iteration (guided) or section
   int chunk_size;
   int incr;
+  uint32_t num_iters;
+  uint32_t num_chunks;
 
   omp_lock_t lock;
 
@@ -10,76 +10,257 @@
 #include "runtime.h"
 #include "synchronization.h"
 
+/* Dynamic chunks are handed out hierarchically: Every group takes blocks of
+   chunks from the global counter and its cores take the chunks of the block
+   from the group's range, in the banks of the group. Blocks shrink with the
+   remaining work and, once the global counter is exhausted, idle groups steal
+   chunks from the ranges of the others. */
+#ifndef GOMP_LOOP_STEAL
+#define GOMP_LOOP_STEAL 1
+#endif
+
+#define CORES_PER_GROUP (NUM_CORES / NUM_GROUPS)
+// A range holds the end and next chunk of a group in its upper/lower half
+#define RANGE_SHIFT 16
+#define RANGE_MASK ((1U << RANGE_SHIFT) - 1)
+// Every core adds at most once to an exhausted range before its next refill
+#define RANGE_MAX_CHUNKS (RANGE_MASK - NUM_CORES)
+
+// Static trip count of every core and, for the first core of every group, the
+// range and refill lock of the group, each in the core's own banks
+uint32_t volatile loop_buffer[NUM_CORES * BANKING_FACTOR]
+    __attribute__((aligned(NUM_CORES * BANKING_FACTOR * 4), section(".l1")));
+
+static inline uint32_t volatile *loop_trip(uint32_t core_id) {
+  return &loop_buffer[core_id * BANKING_FACTOR];
+}
+
+static inline uint32_t volatile *loop_range(uint32_t group_id) {
+  return &loop_buffer[group_id * CORES_PER_GROUP * BANKING_FACTOR + 1];
+}
+
+static inline omp_lock_t *loop_refill_lock(uint32_t group_id) {
+  uint32_t volatile *lock = loop_range(group_id) + 1;
+  return (omp_lock_t *)lock;
+}
+
 void gomp_loop_init(int start, int end, int incr, int chunk_size) {
+  int num_iters;
+
+  if (incr > 0) {
+    num_iters = end > start ? (end - start + incr - 1) / incr : 0;
+  } else {
+    num_iters = start > end ? (start - end - incr - 1) / -incr : 0;
+  }
+
   works.chunk_size = chunk_size;
+  works.start = start;
   works.end = end;
   works.incr = incr;
-  works.next = start;
+  works.next = 0;
+  works.num_iters = (uint32_t)num_iters;
+  works.num_chunks =
+      chunk_size > 0 ? (works.num_iters + (uint32_t)chunk_size - 1) /
+                           (uint32_t)chunk_size
+                     : 0;
+
+  for (uint32_t i = 0; i < NUM_GROUPS; i++) {
+    *loop_range(i) = 0;
+    *loop_refill_lock(i) = 0;
+  }
+}
+
+// Translate num iterations from iteration first on into loop bounds
+static inline int loop_bounds(uint32_t first, uint32_t num, int *istart,
+                              int *iend) {
+  if (first >= works.num_iters) {
+    return 0;
+  }
+
+  *istart = works.start + (int)first * works.incr;
+  if (num >= works.num_iters - first) {
+    *iend = works.end;
+  } else {
+    *iend = *istart + (int)num * works.incr;
+  }
+
+  return 1;
 }
 
+// Take the next chunk from the range of a group
+static inline int loop_take(uint32_t group_id, uint32_t *chunk) {
+  uint32_t volatile *range = loop_range(group_id);
+  uint32_t value = *range;
+
+  // Only read exhausted ranges to keep their banks free
+  if ((value & RANGE_MASK) >= (value >> RANGE_SHIFT)) {
+    return 0;
+  }
+
+  value = __atomic_fetch_add(range, 1, __ATOMIC_SEQ_CST);
+  *chunk = value & RANGE_MASK;
+
+  return *chunk < (value >> RANGE_SHIFT);
+}
+
+// Refill the range of a group with a block from the global counter and take
+// its first chunk
+static int loop_refill(uint32_t group_id, uint32_t *chunk) {
+  uint32_t num_groups =
+      (event.nthreads + CORES_PER_GROUP - 1) / CORES_PER_GROUP;
+  uint32_t next, block, end;
+  int ret;
+
+  gomp_hal_lock(loop_refill_lock(group_id));
+
+  // Another core of the group might have refilled the range meanwhile
+  ret = loop_take(group_id, chunk);
+
+  next = (uint32_t)works.next;
+  if (!ret && next < works.num_chunks) {
+    // Take half of every group's share of the remaining chunks
+    block = (works.num_chunks - next) / (2 * num_groups);
+    block = block ? block : 1;
+
+    next = (uint32_t)__atomic_fetch_add(&works.next, (int)block,
+                                        __ATOMIC_SEQ_CST);
+    if (next < works.num_chunks) {
+      end = next + block;
+      end = end < works.num_chunks ? end : works.num_chunks;
+      __atomic_store_n(loop_range(group_id),
+                       (end << RANGE_SHIFT) | (next + 1), __ATOMIC_SEQ_CST);
+      *chunk = next;
+      ret = 1;
+    }
+  }
+
+  gomp_hal_unlock(loop_refill_lock(group_id));
+
+  return ret;
+}
+
+#if GOMP_LOOP_STEAL
+// Take a chunk from the range of another group
+static int loop_steal(uint32_t group_id, uint32_t *chunk) {
+  for (uint32_t i = 1; i < NUM_GROUPS; i++) {
+    if (loop_take((group_id + i) % NUM_GROUPS, chunk)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif
+
 /*********************** APIs *****************************/
 
-int GOMP_loop_dynamic_start(int start, int end, int incr, int chunk_size,
-                            int *istart, int *iend) {
-  int chunk, left;
-  int ret = 1;
+int GOMP_loop_static_start(int start, int end, int incr, int chunk_size,
+                           int *istart, int *iend) {
+  uint32_t core_id = mempool_get_core_id();
 
   if (gomp_work_share_start()) { // work returns locked
     gomp_loop_init(start, end, incr, chunk_size);
   }
   gomp_hal_unlock(&works.lock);
 
-  chunk = chunk_size * incr;
-
-  start = __atomic_fetch_add(&works.next, chunk, __ATOMIC_SEQ_CST);
+  *loop_trip(core_id) = 0;
 
-  if (start >= works.end) {
-    ret = 0;
-  }
+  return GOMP_loop_static_next(istart, iend);
+}
 
-  if (ret) {
-    left = works.end - start;
+int GOMP_loop_static_next(int *istart, int *iend) {
+  uint32_t core_id = mempool_get_core_id();
+  uint32_t nthreads = event.nthreads;
+  uint32_t trip = *loop_trip(core_id);
+  uint32_t first, num;
+  int ret;
 
-    if (chunk > left) {
-      end = works.end;
+  if (works.chunk_size <= 0) {
+    // One block of about the same size per thread
+    num = works.num_iters / nthreads;
+    first = core_id * num;
+    if (core_id < works.num_iters % nthreads) {
+      first += core_id;
+      num++;
     } else {
-      end = start + chunk;
+      first += works.num_iters % nthreads;
     }
+    ret = !trip && num && loop_bounds(first, num, istart, iend);
+  } else {
+    // Chunks round-robin over the threads
+    first = (trip * nthreads + core_id) * (uint32_t)works.chunk_size;
+    ret = loop_bounds(first, (uint32_t)works.chunk_size, istart, iend);
   }
 
-  *istart = start;
-  *iend = end;
+  *loop_trip(core_id) = trip + 1;
 
   return ret;
 }
 
+int GOMP_loop_dynamic_start(int start, int end, int incr, int chunk_size,
+                            int *istart, int *iend) {
+  if (gomp_work_share_start()) { // work returns locked
+    gomp_loop_init(start, end, incr, chunk_size);
+  }
+  gomp_hal_unlock(&works.lock);
+
+  return GOMP_loop_dynamic_next(istart, iend);
+}
+
 int GOMP_loop_dynamic_next(int *istart, int *iend) {
-  int start, end, chunk, left;
+  uint32_t group_id = mempool_get_group_id();
+  uint32_t chunk;
+  int ret;
 
-  chunk = works.chunk_size * works.incr;
-  start = __atomic_fetch_add(&works.next, chunk, __ATOMIC_SEQ_CST);
+  if (works.num_chunks > RANGE_MAX_CHUNKS) {
+    // Too many chunks for the ranges, take them from the global counter
+    chunk = (uint32_t)__atomic_fetch_add(&works.next, 1, __ATOMIC_SEQ_CST);
+    ret = chunk < works.num_chunks;
+  } else {
+    ret = loop_take(group_id, &chunk) || loop_refill(group_id, &chunk);
+#if GOMP_LOOP_STEAL
+    ret = ret || loop_steal(group_id, &chunk);
+#endif
+  }
 
-  if (start >= works.end) {
+  if (!ret) {
     return 0;
   }
 
-  left = works.end - start;
+  return loop_bounds(chunk * (uint32_t)works.chunk_size,
+                     (uint32_t)works.chunk_size, istart, iend);
+}
 
-  if (chunk > left) {
-    end = works.end;
-  } else {
-    end = start + chunk;
+int GOMP_loop_guided_start(int start, int end, int incr, int chunk_size,
+                           int *istart, int *iend) {
+  if (gomp_work_share_start()) { // work returns locked
+    gomp_loop_init(start, end, incr, chunk_size);
+  }
+  gomp_hal_unlock(&works.lock);
+
+  return GOMP_loop_guided_next(istart, iend);
+}
+
+int GOMP_loop_guided_next(int *istart, int *iend) {
+  uint32_t next = (uint32_t)works.next;
+  uint32_t num;
+
+  if (next >= works.num_iters) {
+    return 0;
   }
 
-  *istart = start;
-  *iend = end;
+  // The chunks shrink with the remaining iterations down to chunk_size
+  num = (works.num_iters - next) / event.nthreads;
+  num = num > (uint32_t)works.chunk_size ? num : (uint32_t)works.chunk_size;
+  num = num ? num : 1;
 
-  return 1;
+  next = (uint32_t)__atomic_fetch_add(&works.next, (int)num, __ATOMIC_SEQ_CST);
+
+  return loop_bounds(next, num, istart, iend);
 }
 
-void GOMP_parallel_loop_dynamic(void (*fn)(void *), void *data,
-                                unsigned num_threads, long start, long end,
-                                long incr, long chunk_size) {
+static void gomp_parallel_loop(void (*fn)(void *), void *data,
+                               unsigned num_threads, long start, long end,
+                               long incr, long chunk_size) {
   uint32_t core_id = mempool_get_core_id();
 
   gomp_new_work_share();
@@ -90,6 +271,28 @@ void GOMP_parallel_loop_dynamic(void (*fn)(void *), void *data,
   GOMP_parallel_end();
 }
 
+void GOMP_parallel_loop_static(void (*fn)(void *), void *data,
+                               unsigned num_threads, long start, long end,
+                               long incr, long chunk_size) {
+  // The threads start with GOMP_loop_static_next
+  for (uint32_t i = 0; i < NUM_CORES; i++) {
+    *loop_trip(i) = 0;
+  }
+  gomp_parallel_loop(fn, data, num_threads, start, end, incr, chunk_size);
+}
+
+void GOMP_parallel_loop_dynamic(void (*fn)(void *), void *data,
+                                unsigned num_threads, long start, long end,
+                                long incr, long chunk_size) {
+  gomp_parallel_loop(fn, data, num_threads, start, end, incr, chunk_size);
+}
+
+void GOMP_parallel_loop_guided(void (*fn)(void *), void *data,
+                               unsigned num_threads, long start, long end,
+                               long incr, long chunk_size) {
+  gomp_parallel_loop(fn, data, num_threads, start, end, incr, chunk_size);
+}
+
 void GOMP_loop_end() {
   uint32_t core_id = mempool_get_core_id();
   mempool_barrier_gomp(core_id, event.nthreads);
@@ -97,6 +300,13 @@ void GOMP_loop_end() {
 
 void GOMP_loop_end_nowait() {}
 
+int GOMP_loop_ull_static_start(int start, int end, int incr, int chunk_size,
+                               int *istart, int *iend) {
+  return GOMP_loop_static_start(start, end, incr, chunk_size, istart, iend);
+}
+int GOMP_loop_ull_static_next(int *istart, int *iend) {
+  return GOMP_loop_static_next(istart, iend);
+}
 int GOMP_loop_ull_dynamic_start(int start, int end, int incr, int chunk_size,
                                 int *istart, int *iend) {
   return GOMP_loop_dynamic_start(start, end, incr, chunk_size, istart, iend);
@@ -104,3 +314,10 @@ int GOMP_loop_ull_dynamic_start(int start, int end, int incr, int chunk_size,
 int GOMP_loop_ull_dynamic_next(int *istart, int *iend) {
   return GOMP_loop_dynamic_next(istart, iend);
 }
+int GOMP_loop_ull_guided_start(int start, int end, int incr, int chunk_size,
+                               int *istart, int *iend) {
+  return GOMP_loop_guided_start(start, end, incr, chunk_size, istart, iend);
+}
+int GOMP_loop_ull_guided_next(int *istart, int *iend) {
+  return GOMP_loop_guided_next(istart, iend);
+}
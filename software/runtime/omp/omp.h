@@ -11,4 +11,24 @@
 extern uint32_t omp_get_num_threads(void);
 extern uint32_t omp_get_thread_num(void);
 
+/* reduction.c */
+/* MemPool extension: Every thread of the team calls omp_reduce_* with its
+   partial value. The values are combined in a tree over the tiles and groups,
+   thread 0 gets the result and the others their partial result. The
+   reduction clause still uses the ATOMIC lock. The bitwise operations are
+   undefined for floats. */
+typedef enum omp_reduce_op_t {
+  omp_reduce_add,
+  omp_reduce_mul,
+  omp_reduce_min,
+  omp_reduce_max,
+  omp_reduce_and,
+  omp_reduce_or,
+  omp_reduce_xor
+} omp_reduce_op_t;
+
+extern int32_t omp_reduce_int(int32_t, omp_reduce_op_t);
+extern uint32_t omp_reduce_uint(uint32_t, omp_reduce_op_t);
+extern float omp_reduce_float(float, omp_reduce_op_t);
+
 #endif /* __OMP_H__ */
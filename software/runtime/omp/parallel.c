@@ -13,16 +13,91 @@
 event_t event;
 work_t works;
 
+#define CORES_PER_GROUP (NUM_CORES / NUM_GROUPS)
+
+// Join counters of the tiles, groups and cluster, each in the banks of its
+// first core
+uint32_t volatile join_buffer[NUM_CORES * BANKING_FACTOR]
+    __attribute__((aligned(NUM_CORES * BANKING_FACTOR * 4), section(".l1")));
+uint32_t volatile join_init __attribute__((section(".l2"))) = 0;
+
+static inline uint32_t min(uint32_t a, uint32_t b) { return a < b ? a : b; }
+
+// Wake up the first nthreads cores but the master. The master gets a wake-up
+// trigger too if it is part of a woken tile.
+static void gomp_fork(uint32_t nthreads) {
+  uint32_t num_groups = nthreads / CORES_PER_GROUP;
+  uint32_t first = num_groups * CORES_PER_GROUP;
+  uint32_t num_tiles = (nthreads - first) / NUM_CORES_PER_TILE;
+
+  if (num_groups) {
+    wake_up_group((1U << num_groups) - 1);
+  }
+  if (num_tiles) {
+    wake_up_tile(num_groups, (1U << num_tiles) - 1);
+  }
+  first += num_tiles * NUM_CORES_PER_TILE;
+  for (uint32_t i = first ? first : 1; i < nthreads; i++) {
+    wake_up(i);
+  }
+}
+
+// Clear the join counters of the uninitialized L1 once, together with the
+// reduction flags. Both are left cleared after every use.
+static void gomp_join_init(void) {
+  if (join_init == 0) {
+    for (uint32_t i = 0; i < NUM_CORES; i += NUM_CORES_PER_TILE) {
+      join_buffer[i * BANKING_FACTOR] = 0;
+      join_buffer[i * BANKING_FACTOR + 1] = 0;
+      join_buffer[i * BANKING_FACTOR + 2] = 0;
+    }
+    gomp_reduction_init();
+    join_init = 1;
+  }
+}
+
+// Combining tree: The last core of a tile arrives at its group, the last tile
+// of a group at the cluster and the last group wakes up the master
+static void gomp_join(uint32_t core_id, uint32_t nthreads) {
+  uint32_t first, arrivals;
+  uint32_t volatile *counter;
+
+  first = core_id - core_id % NUM_CORES_PER_TILE;
+  arrivals = min(NUM_CORES_PER_TILE, nthreads - first);
+  counter = &join_buffer[first * BANKING_FACTOR];
+  if (__atomic_fetch_add(counter, 1, __ATOMIC_SEQ_CST) != arrivals - 1) {
+    return;
+  }
+  *counter = 0;
+
+  first = core_id - core_id % CORES_PER_GROUP;
+  arrivals = (min(CORES_PER_GROUP, nthreads - first) + NUM_CORES_PER_TILE - 1) /
+             NUM_CORES_PER_TILE;
+  counter = &join_buffer[first * BANKING_FACTOR + 1];
+  if (__atomic_fetch_add(counter, 1, __ATOMIC_SEQ_CST) != arrivals - 1) {
+    return;
+  }
+  *counter = 0;
+
+  arrivals = (nthreads + CORES_PER_GROUP - 1) / CORES_PER_GROUP;
+  counter = &join_buffer[2];
+  if (__atomic_fetch_add(counter, 1, __ATOMIC_SEQ_CST) != arrivals - 1) {
+    return;
+  }
+  *counter = 0;
+
+  __sync_synchronize(); // Full memory barrier
+  wake_up(0);
+}
+
 void set_event(void (*fn)(void *), void *data, uint32_t nthreads) {
   uint32_t num_cores = mempool_get_core_count();
   event.fn = fn;
   event.data = data;
-  if (nthreads == 0) {
+  if (nthreads == 0 || nthreads > num_cores) {
     event.nthreads = num_cores;
-    event.barrier = num_cores;
   } else {
     event.nthreads = nthreads;
-    event.barrier = nthreads;
   }
 
   for (uint32_t i = 0; i < num_cores; i++) {
@@ -33,22 +108,24 @@ void set_event(void (*fn)(void *), void *data, uint32_t nthreads) {
 void run_task(uint32_t core_id) {
   if (event.thread_pool[core_id]) {
     event.fn(event.data);
-    __atomic_add_fetch(&event.barrier, -1, __ATOMIC_SEQ_CST);
+    gomp_join(core_id, event.nthreads);
   }
 }
 
 void GOMP_parallel_start(void (*fn)(void *), void *data,
                          unsigned int num_threads) {
+  gomp_join_init();
   set_event(fn, data, num_threads);
-  wake_up_all();
-  mempool_wfi();
+  gomp_fork(event.nthreads);
+  if (event.nthreads >= NUM_CORES_PER_TILE) {
+    // Clear the own wake-up trigger
+    mempool_wfi();
+  }
 }
 
 void GOMP_parallel_end(void) {
-  uint32_t num_cores = mempool_get_core_count();
-  while (event.barrier > 0) {
-    mempool_wait(4 * num_cores);
-  }
+  // Sleep until the last thread of the team joined
+  mempool_wfi();
 }
 
 #pragma GCC diagnostic push
@@ -0,0 +1,175 @@
+// Copyright 2022 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+/* This file handles the reduction of one value per thread of the team with
+   a tree instead of the ATOMIC lock: the cores of a tile combine in the
+   banks of their tile, then the tiles in a binary tree, whose first levels
+   stay within the groups. The reduction clause of GCC does not call into the
+   runtime with the values, so applications use omp_reduce_* explicitly. */
+
+#include "encoding.h"
+#include "libgomp.h"
+#include "printf.h"
+#include "runtime.h"
+#include "synchronization.h"
+
+typedef enum { REDUCE_INT, REDUCE_UINT, REDUCE_FLOAT } reduce_type_t;
+
+typedef union {
+  int32_t i;
+  uint32_t u;
+  float f;
+} reduce_value_t;
+
+// Partial value and full flag of every core, in its own bank
+uint32_t volatile reduction_buffer[NUM_CORES * BANKING_FACTOR]
+    __attribute__((aligned(NUM_CORES * BANKING_FACTOR * 4), section(".l1")));
+
+// Called once by gomp_join_init(), every reduction leaves the flags cleared
+void gomp_reduction_init(void) {
+  for (uint32_t i = 0; i < NUM_CORES; i++) {
+    reduction_buffer[i * BANKING_FACTOR + 1] = 0;
+  }
+}
+
+static inline int32_t combine_int(int32_t a, int32_t b, omp_reduce_op_t op) {
+  switch (op) {
+  case omp_reduce_add:
+    return a + b;
+  case omp_reduce_mul:
+    return a * b;
+  case omp_reduce_min:
+    return a < b ? a : b;
+  case omp_reduce_max:
+    return a > b ? a : b;
+  case omp_reduce_and:
+    return a & b;
+  case omp_reduce_or:
+    return a | b;
+  case omp_reduce_xor:
+    return a ^ b;
+  default:
+    return a;
+  }
+}
+
+static inline uint32_t combine_uint(uint32_t a, uint32_t b,
+                                    omp_reduce_op_t op) {
+  switch (op) {
+  case omp_reduce_min:
+    return a < b ? a : b;
+  case omp_reduce_max:
+    return a > b ? a : b;
+  default:
+    // Same bits as for signed integers
+    return (uint32_t)combine_int((int32_t)a, (int32_t)b, op);
+  }
+}
+
+static inline float combine_float(float a, float b, omp_reduce_op_t op) {
+  switch (op) {
+  case omp_reduce_add:
+    return a + b;
+  case omp_reduce_mul:
+    return a * b;
+  case omp_reduce_min:
+    return a < b ? a : b;
+  case omp_reduce_max:
+    return a > b ? a : b;
+  default:
+    return a;
+  }
+}
+
+static inline reduce_value_t combine(reduce_value_t a, reduce_value_t b,
+                                     omp_reduce_op_t op, reduce_type_t type) {
+  switch (type) {
+  case REDUCE_INT:
+    a.i = combine_int(a.i, b.i, op);
+    break;
+  case REDUCE_UINT:
+    a.u = combine_uint(a.u, b.u, op);
+    break;
+  case REDUCE_FLOAT:
+    a.f = combine_float(a.f, b.f, op);
+    break;
+  }
+  return a;
+}
+
+// Hand the partial value of a core to its parent in the tree
+static inline void reduction_publish(uint32_t core_id, reduce_value_t value) {
+  uint32_t volatile *slot = &reduction_buffer[core_id * BANKING_FACTOR];
+  // Wait until the parent took the value of the previous reduction
+  while (slot[1]) {
+  }
+  slot[0] = value.u;
+  __sync_synchronize(); // Full memory barrier
+  slot[1] = 1;
+}
+
+// Combine the partial value of a child in the tree
+static inline reduce_value_t reduction_gather(uint32_t child_id,
+                                              reduce_value_t value,
+                                              omp_reduce_op_t op,
+                                              reduce_type_t type) {
+  uint32_t volatile *slot = &reduction_buffer[child_id * BANKING_FACTOR];
+  reduce_value_t child;
+  while (!slot[1]) {
+  }
+  child.u = slot[0];
+  slot[1] = 0;
+  return combine(value, child, op, type);
+}
+
+static reduce_value_t reduce(reduce_value_t value, omp_reduce_op_t op,
+                             reduce_type_t type) {
+  uint32_t core_id = mempool_get_core_id();
+  uint32_t nthreads = event.nthreads;
+  uint32_t tile_id = core_id / NUM_CORES_PER_TILE;
+  uint32_t tile_leader = tile_id * NUM_CORES_PER_TILE;
+
+  // Tile level: The leader combines the values in the banks of its tile
+  if (core_id != tile_leader) {
+    reduction_publish(core_id, value);
+    return value;
+  }
+  uint32_t tile_end = tile_leader + NUM_CORES_PER_TILE;
+  tile_end = tile_end < nthreads ? tile_end : nthreads;
+  for (uint32_t i = tile_leader + 1; i < tile_end; i++) {
+    value = reduction_gather(i, value, op, type);
+  }
+
+  // Group and cluster level: Binary tree over the tile leaders
+  uint32_t num_tiles =
+      (nthreads + NUM_CORES_PER_TILE - 1) / NUM_CORES_PER_TILE;
+  for (uint32_t step = 1; step < num_tiles; step <<= 1) {
+    if (tile_id & step) {
+      reduction_publish(core_id, value);
+      return value;
+    }
+    if (tile_id + step < num_tiles) {
+      uint32_t child_id = (tile_id + step) * NUM_CORES_PER_TILE;
+      value = reduction_gather(child_id, value, op, type);
+    }
+  }
+  return value;
+}
+
+/*********************** APIs *****************************/
+
+int32_t omp_reduce_int(int32_t value, omp_reduce_op_t op) {
+  reduce_value_t v = {.i = value};
+  return reduce(v, op, REDUCE_INT).i;
+}
+
+uint32_t omp_reduce_uint(uint32_t value, omp_reduce_op_t op) {
+  reduce_value_t v = {.u = value};
+  return reduce(v, op, REDUCE_UINT).u;
+}
+
+float omp_reduce_float(float value, omp_reduce_op_t op) {
+  reduce_value_t v = {.f = value};
+  return reduce(v, op, REDUCE_FLOAT).f;
+}
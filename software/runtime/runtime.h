@@ -84,6 +84,11 @@ static inline void mempool_init(const uint32_t core_id) {
     seq_heap_offset += NUM_BANKS_PER_TILE * XQUEUE_SIZE * sizeof(uint32_t);
     // The total sequential memory per tile in bytes
     uint32_t seq_total_size = NUM_CORES_PER_TILE * SEQ_MEM_SIZE;
+    // The default stacks fill it, which leaves an empty heap
+    _Static_assert(NUM_CORES_PER_TILE * STACK_SIZE +
+                           NUM_BANKS_PER_TILE * XQUEUE_SIZE * sizeof(uint32_t) <=
+                       NUM_CORES_PER_TILE * SEQ_MEM_SIZE,
+                   "The stacks and queues exceed the sequential memory");
     // The base is the start address + the offset due to the queues and stack
     uint32_t seq_heap_base = (uint32_t)&__seq_start + seq_heap_offset;
     uint32_t seq_heap_size = seq_total_size - seq_heap_offset;
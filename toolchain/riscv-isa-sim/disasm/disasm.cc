@@ -1522,34 +1522,68 @@ disassembler_t::disassembler_t(int xlen)
    add_insn(new disasm_insn_t(#code " (args unknown)", match, mask, {}));
   #include "encoding.h"
   #undef DECLARE_INSN
+
+  build_table();
 }
 
 const disasm_insn_t* disassembler_t::lookup(insn_t insn) const
 {
-  size_t idx = insn.bits() % HASH_SIZE;
-  for (size_t j = 0; j < chain[idx].size(); j++)
-    if(*chain[idx][j] == insn)
-      return chain[idx][j];
-
-  idx = HASH_SIZE;
-  for (size_t j = 0; j < chain[idx].size(); j++)
-    if(*chain[idx][j] == insn)
-      return chain[idx][j];
+  uint32_t k = key(insn.bits());
+  for (uint32_t j = offsets[k]; j < offsets[k+1]; j++)
+    if (*insns[entries[j]] == insn)
+      return insns[entries[j]];
 
   return NULL;
 }
 
 void NOINLINE disassembler_t::add_insn(disasm_insn_t* insn)
 {
-  size_t idx = HASH_SIZE;
-  if (insn->get_mask() % HASH_SIZE == HASH_SIZE - 1)
-    idx = insn->get_match() % HASH_SIZE;
-  chain[idx].push_back(insn);
+  insns.push_back(insn);
+
+  // Instructions added after construction, e.g., by extensions
+  if (!offsets.empty())
+    build_table();
+}
+
+// Call fn for every key an instruction may match, i.e., for all values of
+// the key bits that its mask leaves open
+template <typename F>
+static void for_each_key(const disasm_insn_t* insn, uint32_t key_mask, F fn)
+{
+  uint32_t fixed = key_mask & insn->get_mask();
+  uint32_t open = key_mask & ~insn->get_mask();
+  uint32_t base = insn->get_match() & fixed;
+  uint32_t k = 0;
+  do {
+    fn(base | k);
+    k = (k - open) & open;
+  } while (k);
+}
+
+void disassembler_t::build_table()
+{
+  // Key bits in instruction bit positions
+  const uint32_t key_mask = 0xf07f;
+  assert(insns.size() <= 0x10000);
+
+  offsets.assign(KEY_SIZE + 1, 0);
+  for (auto insn : insns)
+    for_each_key(insn, key_mask, [&](uint32_t bits){ offsets[key(bits)+1]++; });
+  for (size_t k = 0; k < KEY_SIZE; k++)
+    offsets[k+1] += offsets[k];
+
+  // Instructions that fix the whole low byte take precedence, otherwise the
+  // first added instruction wins
+  std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+  entries.resize(offsets[KEY_SIZE]);
+  for (int specific = 1; specific >= 0; specific--)
+    for (size_t i = 0; i < insns.size(); i++)
+      if (((insns[i]->get_mask() & 0xff) == 0xff) == specific)
+        for_each_key(insns[i], key_mask, [&](uint32_t bits){ entries[fill[key(bits)]++] = i; });
 }
 
 disassembler_t::~disassembler_t()
 {
-  for (size_t i = 0; i < HASH_SIZE+1; i++)
-    for (size_t j = 0; j < chain[i].size(); j++)
-      delete chain[i][j];
+  for (size_t i = 0; i < insns.size(); i++)
+    delete insns[i];
 }
@@ -163,6 +163,16 @@ const char* htif_t::get_symbol(uint64_t addr)
   return it->second.c_str();
 }
 
+const char* htif_t::get_enclosing_symbol(uint64_t addr)
+{
+  auto it = addr2symbol.upper_bound(addr);
+
+  if(it == addr2symbol.begin())
+      return nullptr;
+
+  return (--it)->second.c_str();
+}
+
 void htif_t::stop()
 {
   if (!sig_file.empty() && sig_len) // print final torture test signature
@@ -208,7 +218,7 @@ int htif_t::run()
     std::bind(enq_func, &fromhost_queue, std::placeholders::_1);
 
   if (tohost_addr == 0) {
-    while (true)
+    while (exitcode == 0)
       idle();
   }
 
@@ -45,12 +45,17 @@ class htif_t : public chunked_memif_t
 
   reg_t get_entry_point() { return entry; }
 
+  // ends run() with the given exit code, e.g., on a target without tohost
+  void set_exit_code(int code) { exitcode = (code << 1) | 1; }
+
   // indicates that the initial program load can skip writing this address
   // range to memory, because it has already been loaded through a sideband
   virtual bool is_address_preloaded(addr_t taddr, size_t len) { return false; }
 
   // Given an address, return symbol from addr2symbol map
   const char* get_symbol(uint64_t addr);
+  // Given an address, return the closest symbol at or below it
+  const char* get_enclosing_symbol(uint64_t addr);
 
  private:
   void parse_arguments(int argc, char ** argv);
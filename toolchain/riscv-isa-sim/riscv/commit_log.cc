@@ -0,0 +1,317 @@
+// See LICENSE for license details.
+
+#include "commit_log.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <dlfcn.h>
+
+static const char MAGIC[8] = "SPIKECL";
+static const uint32_t VERSION = 1;
+
+static_assert(sizeof(commit_log_record_t) == 16, "records are 16 bytes");
+static_assert(sizeof(commit_log_block_t) == 16, "block headers are 16 bytes");
+
+// The codecs are loaded when they are first used, so that Spike builds
+// without their headers and only needs their libraries to compress a log
+
+static void* codec_symbol(const char* lib, const char* name)
+{
+  void* handle = dlopen(lib, RTLD_LAZY);
+  void* sym = handle ? dlsym(handle, name) : NULL;
+  if (!sym)
+    throw std::runtime_error(std::string("cannot load ") + name + " from " + lib);
+  return sym;
+}
+
+struct lz4_t
+{
+  int (*bound)(int);
+  int (*compress)(const char*, char*, int, int);
+  int (*decompress)(const char*, char*, int, int);
+
+  lz4_t()
+  {
+    const char* lib = "liblz4.so.1";
+    bound = (int (*)(int))codec_symbol(lib, "LZ4_compressBound");
+    compress = (int (*)(const char*, char*, int, int))codec_symbol(lib, "LZ4_compress_default");
+    decompress = (int (*)(const char*, char*, int, int))codec_symbol(lib, "LZ4_decompress_safe");
+  }
+};
+
+struct zstd_t
+{
+  size_t (*bound)(size_t);
+  size_t (*compress)(void*, size_t, const void*, size_t, int);
+  size_t (*decompress)(void*, size_t, const void*, size_t);
+  unsigned (*is_error)(size_t);
+
+  zstd_t()
+  {
+    const char* lib = "libzstd.so.1";
+    bound = (size_t (*)(size_t))codec_symbol(lib, "ZSTD_compressBound");
+    compress = (size_t (*)(void*, size_t, const void*, size_t, int))codec_symbol(lib, "ZSTD_compress");
+    decompress = (size_t (*)(void*, size_t, const void*, size_t))codec_symbol(lib, "ZSTD_decompress");
+    is_error = (unsigned (*)(size_t))codec_symbol(lib, "ZSTD_isError");
+  }
+};
+
+static const lz4_t& lz4()
+{
+  static lz4_t codec;
+  return codec;
+}
+
+static const zstd_t& zstd()
+{
+  static zstd_t codec;
+  return codec;
+}
+
+// Compress src into dst; 0 if it does not get smaller
+static size_t compress(commit_log_codec_t codec, const char* src, size_t size,
+                       std::vector<char>& dst)
+{
+  size_t n = 0;
+  if (codec == CL_CODEC_LZ4) {
+    dst.resize(lz4().bound(size));
+    n = std::max(lz4().compress(src, dst.data(), size, dst.size()), 0);
+  } else if (codec == CL_CODEC_ZSTD) {
+    dst.resize(zstd().bound(size));
+    n = zstd().compress(dst.data(), dst.size(), src, size, 1);
+    if (zstd().is_error(n))
+      n = 0;
+  }
+  return n < size ? n : 0;
+}
+
+static bool decompress(commit_log_codec_t codec, const char* src, size_t size,
+                       char* dst, size_t raw_size)
+{
+  if (codec == CL_CODEC_LZ4)
+    return lz4().decompress(src, dst, size, raw_size) == (int)raw_size;
+  if (codec == CL_CODEC_ZSTD)
+    return zstd().decompress(dst, raw_size, src, size) == raw_size;
+  return false;
+}
+
+bool commit_log_parse_codec(const char* name, commit_log_codec_t* codec)
+{
+  if (!strcmp(name, "none"))
+    *codec = CL_CODEC_NONE;
+  else if (!strcmp(name, "lz4"))
+    *codec = CL_CODEC_LZ4;
+  else if (!strcmp(name, "zstd"))
+    *codec = CL_CODEC_ZSTD;
+  else
+    return false;
+  return true;
+}
+
+commit_log_file_t::commit_log_file_t(const char* path, commit_log_codec_t codec)
+  : codec(codec)
+{
+  if (codec == CL_CODEC_LZ4)
+    lz4();
+  else if (codec == CL_CODEC_ZSTD)
+    zstd();
+
+  file = fopen(path, "wb");
+  if (!file)
+    throw std::runtime_error(std::string("could not open ") + path);
+  commit_log_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  fwrite(&header, sizeof(header), 1, file);
+}
+
+commit_log_file_t::~commit_log_file_t()
+{
+  fclose(file);
+}
+
+void commit_log_file_t::write_block(uint32_t hart, const std::vector<commit_log_record_t>& records)
+{
+  const char* raw = (const char*)records.data();
+  size_t raw_size = records.size() * sizeof(commit_log_record_t);
+
+  std::lock_guard<std::mutex> guard(lock);
+  commit_log_block_t block;
+  memset(&block, 0, sizeof(block));
+  block.hart = hart;
+  block.records = records.size();
+  block.size = codec == CL_CODEC_NONE ? 0 : compress(codec, raw, raw_size, compressed);
+  block.codec = block.size ? codec : CL_CODEC_NONE;
+  if (!block.size)
+    block.size = raw_size;
+  fwrite(&block, sizeof(block), 1, file);
+  fwrite(block.codec == CL_CODEC_NONE ? raw : compressed.data(), block.size, 1, file);
+}
+
+commit_log_writer_t::commit_log_writer_t(commit_log_file_t& file, uint32_t hart)
+  : file(file), hart(hart), insn_record(0), next_pc(0), last_addr(0)
+{
+  records.reserve(BLOCK_RECORDS);
+}
+
+void commit_log_writer_t::push(uint8_t type, uint8_t flags, uint16_t index,
+                               uint32_t data, uint64_t value)
+{
+  records.push_back({type, flags, index, data, value});
+}
+
+void commit_log_writer_t::insn(unsigned priv, unsigned xlen, uint64_t pc,
+                               uint64_t bits, unsigned length)
+{
+  unsigned xlen_code = xlen == 32 ? 0 : xlen == 64 ? 1 : 2;
+  insn_record = records.size();
+  push(CL_INSN, priv | xlen_code << 2 | length << 4, 0, bits, pc - next_pc);
+  if (length > 4)
+    push(CL_EXT, 0, 0, 0, bits >> 32);
+  next_pc = pc + length;
+}
+
+void commit_log_writer_t::reg(commit_log_type_t type, unsigned index,
+                              unsigned width, const uint64_t* value)
+{
+  push(type, 0, index, width, value[0]);
+  for (unsigned i = 1; i < (width + 63) / 64; i++)
+    push(CL_EXT, 0, 0, 0, value[i]);
+}
+
+void commit_log_writer_t::vconfig(unsigned sew, unsigned lmul, uint64_t vl)
+{
+  push(CL_VCONFIG, 0, lmul, sew, vl);
+}
+
+void commit_log_writer_t::load(unsigned xlen, uint64_t addr)
+{
+  push(CL_LOAD, 0, 0, xlen, addr - last_addr);
+  last_addr = addr;
+}
+
+void commit_log_writer_t::store(unsigned xlen, uint64_t addr, uint64_t data, unsigned bytes)
+{
+  push(CL_STORE, bytes, 0, xlen, addr - last_addr);
+  push(CL_EXT, 0, 0, 0, data);
+  last_addr = addr;
+}
+
+void commit_log_writer_t::end_insn()
+{
+  records[insn_record].index = records.size() - insn_record - 1;
+  if (records.size() >= BLOCK_RECORDS)
+    flush();
+}
+
+void commit_log_writer_t::flush()
+{
+  if (records.empty())
+    return;
+  file.write_block(hart, records);
+  records.clear();
+  next_pc = 0;
+  last_addr = 0;
+}
+
+commit_log_reader_t::commit_log_reader_t(const char* path)
+  : path(path), pos(0), next_pc(0), last_addr(0)
+{
+  file = fopen(path, "rb");
+  if (!file)
+    throw std::runtime_error(std::string("could not open ") + path);
+  commit_log_header_t header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, MAGIC, sizeof(MAGIC)) || header.version != VERSION) {
+    fclose(file);
+    throw std::runtime_error(std::string(path) + " is not a commit log");
+  }
+}
+
+commit_log_reader_t::~commit_log_reader_t()
+{
+  fclose(file);
+}
+
+bool commit_log_reader_t::read_block()
+{
+  size_t n = fread(&block, 1, sizeof(block), file);
+  if (n == 0)
+    return false;
+  size_t raw_size = block.records * sizeof(commit_log_record_t);
+  records.resize(block.records);
+  bool ok = n == sizeof(block);
+  if (ok && block.codec == CL_CODEC_NONE) {
+    ok = block.size == raw_size && fread(records.data(), raw_size, 1, file) == 1;
+  } else if (ok) {
+    payload.resize(block.size);
+    ok = fread(payload.data(), block.size, 1, file) == 1 &&
+         decompress((commit_log_codec_t)block.codec, payload.data(), block.size,
+                    (char*)records.data(), raw_size);
+  }
+  if (!ok)
+    throw std::runtime_error(path + ": corrupt block");
+  pos = 0;
+  next_pc = 0;
+  last_addr = 0;
+  return true;
+}
+
+const commit_log_record_t& commit_log_reader_t::record()
+{
+  if (pos == records.size())
+    throw std::runtime_error(path + ": truncated instruction");
+  return records[pos++];
+}
+
+bool commit_log_reader_t::next(commit_log_insn_t& insn)
+{
+  while (pos == records.size())
+    if (!read_block())
+      return false;
+
+  const commit_log_record_t& r = record();
+  if (r.type != CL_INSN || pos + r.index > records.size())
+    throw std::runtime_error(path + ": corrupt instruction");
+  size_t end = pos + r.index;
+  insn.hart = block.hart;
+  insn.priv = r.flags & 3;
+  insn.xlen = 32 << ((r.flags >> 2) & 3);
+  insn.length = r.flags >> 4;
+  insn.pc = next_pc + r.value;
+  insn.bits = r.data;
+  if (insn.length > 4)
+    insn.bits |= record().value << 32;
+  next_pc = insn.pc + insn.length;
+
+  insn.operands.clear();
+  while (pos < end) {
+    const commit_log_record_t& o = record();
+    commit_log_operand_t op;
+    op.type = (commit_log_type_t)o.type;
+    op.index = o.index;
+    op.width = o.data;
+    op.xlen = 0;
+    op.addr = 0;
+    switch (o.type) {
+      case CL_XREG: case CL_FREG: case CL_VREG: case CL_CSR: case CL_VCONFIG:
+        op.value.push_back(o.value);
+        while (pos < end && records[pos].type == CL_EXT)
+          op.value.push_back(records[pos++].value);
+        break;
+      case CL_LOAD: case CL_STORE:
+        op.width = o.flags;
+        op.xlen = o.data;
+        op.addr = last_addr + o.value;
+        last_addr = op.addr;
+        if (o.type == CL_STORE)
+          op.value.push_back(record().value);
+        break;
+      default:
+        throw std::runtime_error(path + ": corrupt operand");
+    }
+    insn.operands.push_back(std::move(op));
+  }
+  return true;
+}
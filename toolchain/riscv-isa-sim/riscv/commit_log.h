@@ -0,0 +1,166 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_COMMIT_LOG_H
+#define _RISCV_COMMIT_LOG_H
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Binary commit log of Spike, with the same information as the text log of
+// --log-commits in fixed-size records that need no formatting or parsing.
+//
+// The file starts with a commit_log_header_t and continues with blocks. A
+// block holds the records of one hart and starts with a commit_log_block_t;
+// its payload is stored as is or compressed with the codec of the block. An
+// instruction is an INSN record followed by the records of its operands, in
+// the order of the text log. PCs and memory addresses are stored as deltas to
+// the previous ones of the hart, which start over in every block so that the
+// blocks can be decoded independently. All fields are in the byte order of
+// the host.
+
+enum commit_log_type_t {
+  CL_INSN,    // flags: privilege | xlen code << 2 | length << 4,
+              // index: operand records, data: bits, value: PC delta
+  CL_XREG,    // index: register, data: width, value: the lowest 64 bits
+  CL_FREG,
+  CL_VREG,
+  CL_CSR,
+  CL_VCONFIG, // index: LMUL (0x8000 | 1/LMUL if fractional), data: SEW, value: vl
+  CL_LOAD,    // data: xlen, value: address delta
+  CL_STORE,   // flags: bytes, data: xlen, value: address delta; then the data
+  CL_EXT,     // value: the next 64 bits of the preceding record
+};
+
+struct commit_log_record_t
+{
+  uint8_t type;
+  uint8_t flags;
+  uint16_t index;
+  uint32_t data;
+  uint64_t value;
+};
+
+enum commit_log_codec_t { CL_CODEC_NONE, CL_CODEC_LZ4, CL_CODEC_ZSTD };
+
+struct commit_log_header_t
+{
+  char magic[8];    // "SPIKECL"
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct commit_log_block_t
+{
+  uint32_t hart;
+  uint32_t records;
+  uint32_t size;    // bytes of the payload
+  uint8_t codec;
+  uint8_t reserved[3];
+};
+
+// Parse the name of a codec (none, lz4, zstd); false if it is unknown
+bool commit_log_parse_codec(const char* name, commit_log_codec_t* codec);
+
+// A binary commit log that the harts write their blocks to
+class commit_log_file_t
+{
+ public:
+  // Throws std::runtime_error if the file cannot be opened or the codec
+  // library cannot be loaded
+  commit_log_file_t(const char* path, commit_log_codec_t codec);
+  ~commit_log_file_t();
+
+  void write_block(uint32_t hart, const std::vector<commit_log_record_t>& records);
+
+ private:
+  FILE* file;
+  commit_log_codec_t codec;
+  std::mutex lock;
+  std::vector<char> compressed;
+};
+
+// The commit log of one hart, which is buffered and written as a block of
+// at most BLOCK_RECORDS records, unless an instruction has more
+class commit_log_writer_t
+{
+ public:
+  static const size_t BLOCK_RECORDS = 1 << 16;
+
+  commit_log_writer_t(commit_log_file_t& file, uint32_t hart);
+  ~commit_log_writer_t() { flush(); }
+
+  // An instruction, followed by its operands and by end_insn()
+  void insn(unsigned priv, unsigned xlen, uint64_t pc, uint64_t bits, unsigned length);
+  void reg(commit_log_type_t type, unsigned index, unsigned width, const uint64_t* value);
+  void vconfig(unsigned sew, unsigned lmul, uint64_t vl);
+  void load(unsigned xlen, uint64_t addr);
+  void store(unsigned xlen, uint64_t addr, uint64_t data, unsigned bytes);
+  void end_insn();
+
+  void flush();
+
+ private:
+  void push(uint8_t type, uint8_t flags, uint16_t index, uint32_t data, uint64_t value);
+
+  commit_log_file_t& file;
+  uint32_t hart;
+  std::vector<commit_log_record_t> records;
+  size_t insn_record;
+  uint64_t next_pc;
+  uint64_t last_addr;
+};
+
+// An operand of an instruction of the commit log
+struct commit_log_operand_t
+{
+  commit_log_type_t type;
+  unsigned index;
+  unsigned width;              // of a register in bits, of a store in bytes
+  unsigned xlen;               // of a load or store
+  uint64_t addr;               // of a load or store
+  std::vector<uint64_t> value; // of a register or store, or SEW and vl
+};
+
+struct commit_log_insn_t
+{
+  uint32_t hart;
+  unsigned priv;
+  unsigned xlen;
+  uint64_t pc;
+  uint64_t bits;
+  unsigned length;
+  std::vector<commit_log_operand_t> operands;
+};
+
+// Streaming reader of a binary commit log, which returns the instructions in
+// the order of the blocks, i.e., those of every hart in order
+class commit_log_reader_t
+{
+ public:
+  // Throws std::runtime_error if the file cannot be opened or is not a
+  // commit log
+  commit_log_reader_t(const char* path);
+  ~commit_log_reader_t();
+
+  // Read the next instruction; false at the end of the log. Throws
+  // std::runtime_error if the log is corrupt.
+  bool next(commit_log_insn_t& insn);
+
+ private:
+  bool read_block();
+  const commit_log_record_t& record();
+
+  FILE* file;
+  std::string path;
+  commit_log_block_t block;
+  std::vector<char> payload;
+  std::vector<commit_log_record_t> records;
+  size_t pos;
+  uint64_t next_pc;
+  uint64_t last_addr;
+};
+
+#endif
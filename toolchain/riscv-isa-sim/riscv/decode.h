@@ -315,6 +315,12 @@ private:
        STATE.pc = __npc; \
      } while(0)
 
+// Let the profiler follow the calls and returns of jal and jalr
+#define profile_jump(rd, rs1, link) \
+  do { if (unlikely(p->get_profiler() != NULL)) \
+         p->get_profiler()->jump(rd, rs1, link); \
+     } while(0)
+
 class wait_for_interrupt_t {};
 
 #define wfi() \
@@ -95,8 +95,18 @@ class disassembler_t
   void add_insn(disasm_insn_t* insn);
 
  private:
-  static const int HASH_SIZE = 256;
-  std::vector<const disasm_insn_t*> chain[HASH_SIZE+1];
+  // All instructions, in the order they were added
+  std::vector<const disasm_insn_t*> insns;
+
+  // The instructions are looked up in a table indexed by the opcode (bits
+  // 6:0) and the function of compressed and uncompressed instructions (bits
+  // 15:12). The candidates of key k are the instructions indexed by
+  // entries[offsets[k]:offsets[k+1]], in lookup order.
+  static const size_t KEY_SIZE = 1 << 11;
+  static uint32_t key(reg_t bits) { return (bits & 0x7f) | ((bits >> 5) & 0x780); }
+  std::vector<uint32_t> offsets;
+  std::vector<uint16_t> entries;
+  void build_table();
 };
 
 #endif
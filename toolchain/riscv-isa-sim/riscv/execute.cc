@@ -3,6 +3,10 @@
 #include "processor.h"
 #include "mmu.h"
 #include "disasm.h"
+#include "commit_log.h"
+#include "mempool_timing.h"
+#include "mempool_perf.h"
+#include "profiler.h"
 #include <cassert>
 
 #ifdef RISCV_ENABLE_COMMITLOG
@@ -64,8 +68,62 @@ const char* processor_t::get_symbol(uint64_t addr)
   return sim->get_symbol(addr);
 }
 
+static void commit_log_write_insn(commit_log_writer_t *log, processor_t *p,
+                                  reg_t pc, insn_t insn)
+{
+  auto& reg = p->get_state()->log_reg_write;
+  auto& load = p->get_state()->log_mem_read;
+  auto& store = p->get_state()->log_mem_write;
+  int xlen = p->get_state()->last_inst_xlen;
+  int flen = p->get_state()->last_inst_flen;
+
+  log->insn(p->get_state()->last_inst_priv, xlen, pc, insn.bits(), insn.length());
+  bool show_vec = false;
+
+  for (auto item : reg) {
+    if (item.first == 0)
+      continue;
+
+    int rd = item.first >> 4;
+    int type = item.first & 0xf;
+    if (!show_vec && (type == 2 || type == 3)) {
+      log->vconfig(p->VU.vsew,
+                   p->VU.vflmul < 1 ? 0x8000 | (reg_t)(1 / p->VU.vflmul) : (reg_t)p->VU.vflmul,
+                   p->VU.vl);
+      show_vec = true;
+    }
+
+    switch (type) {
+    case 0:
+      log->reg(CL_XREG, rd, xlen, item.second.v);
+      break;
+    case 1:
+      log->reg(CL_FREG, rd, flen, item.second.v);
+      break;
+    case 2:
+      log->reg(CL_VREG, rd, p->VU.VLEN, (const uint64_t *)&p->VU.elt<uint8_t>(rd, 0));
+      break;
+    case 4:
+      log->reg(CL_CSR, rd, xlen, item.second.v);
+      break;
+    }
+  }
+
+  for (auto item : load)
+    log->load(xlen, std::get<0>(item));
+
+  for (auto item : store)
+    log->store(xlen, std::get<0>(item), std::get<1>(item), std::get<2>(item));
+  log->end_insn();
+}
+
 static void commit_log_print_insn(processor_t *p, reg_t pc, insn_t insn)
 {
+  if (commit_log_writer_t *log = p->get_commit_log()) {
+    commit_log_write_insn(log, p, pc, insn);
+    return;
+  }
+
   FILE *log_file = p->get_log_file();
 
   auto& reg = p->get_state()->log_reg_write;
@@ -211,12 +269,41 @@ static reg_t execute_insn(processor_t* p, reg_t pc, insn_fetch_t fetch)
 
 bool processor_t::slow_path()
 {
-  return debug || state.single_step != state.STEP_NONE || state.debug_mode;
+  return debug || state.single_step != state.STEP_NONE || state.debug_mode ||
+         timing || perf;
 }
 
-// fetch/decode/execute loop
 void processor_t::step(size_t n)
 {
+  if (unlikely(perf && sleeping())) {
+    perf->idle(n);
+    return;
+  }
+
+  if (likely(profiler == NULL)) {
+    execute(n);
+    return;
+  }
+
+  // Stop at every sample of the profiler, unless the hart stops early
+  while (n > 0) {
+    size_t chunk = std::min(n, profiler->until_sample());
+    reg_t minstret = state.minstret;
+    execute(chunk);
+    size_t retired = state.minstret - minstret;
+    profiler->retire(state.pc, retired);
+    if (retired < chunk)
+      break;
+    n -= chunk;
+  }
+}
+
+// fetch/decode/execute loop
+void processor_t::execute(size_t n)
+{
+  if (unlikely(sleeping() || unhandled_trap))
+    return;
+
   if (!state.debug_mode) {
     if (halt_request == HR_REGULAR) {
       enter_debug_mode(DCSR_CAUSE_DEBUGINT);
@@ -273,9 +360,47 @@ void processor_t::step(size_t n)
           if (debug && !state.serialized)
             disasm(fetch.insn);
           pc = execute_insn(this, pc, fetch);
+          if (timing && pc != PC_SERIALIZE_BEFORE)
+            timing->retire(fetch.insn);
+          if (perf && pc != PC_SERIALIZE_BEFORE)
+            perf->retire(fetch.insn, state.pc, pc);
           advance_pc();
         }
       }
+      else if (likely(_mmu->block_cache_enabled()))
+      {
+        // Execute whole basic blocks, which are chained to the blocks that
+        // follow them, so that the cache of blocks is only looked up when
+        // neither link matches. Like the Duff's device below, every
+        // instruction of a block has its own call site. A taken branch or the
+        // end of the block leaves the block. Instructions that flush the
+        // caches end their blocks.
+        icache_block_t* block = _mmu->access_block(pc);
+        while (true)
+        {
+          #define BLOCK_ACCESS(i) { \
+            insn_fetch_t fetch = block->insns[i].fetch; \
+            pc = execute_insn(this, pc, fetch); \
+            if (unlikely(pc != block->insns[i].next_pc)) break; \
+            if (unlikely(instret+1 == n)) break; \
+            instret++; \
+            state.pc = pc; \
+          }
+
+          static_assert(icache_block_t::MAX_INSNS == 32, "unroll MAX_INSNS times");
+          do {
+          BLOCK_ACCESS(0) BLOCK_ACCESS(1) BLOCK_ACCESS(2) BLOCK_ACCESS(3) BLOCK_ACCESS(4) BLOCK_ACCESS(5) BLOCK_ACCESS(6) BLOCK_ACCESS(7)
+          BLOCK_ACCESS(8) BLOCK_ACCESS(9) BLOCK_ACCESS(10) BLOCK_ACCESS(11) BLOCK_ACCESS(12) BLOCK_ACCESS(13) BLOCK_ACCESS(14) BLOCK_ACCESS(15)
+          BLOCK_ACCESS(16) BLOCK_ACCESS(17) BLOCK_ACCESS(18) BLOCK_ACCESS(19) BLOCK_ACCESS(20) BLOCK_ACCESS(21) BLOCK_ACCESS(22) BLOCK_ACCESS(23)
+          BLOCK_ACCESS(24) BLOCK_ACCESS(25) BLOCK_ACCESS(26) BLOCK_ACCESS(27) BLOCK_ACCESS(28) BLOCK_ACCESS(29) BLOCK_ACCESS(30) BLOCK_ACCESS(31)
+          } while (0);
+
+          advance_pc();
+          if (instret == n)
+            break;
+          block = _mmu->next_block(block, pc);
+        }
+      }
       else while (instret < n)
       {
         // This code uses a modified Duff's Device to improve the performance
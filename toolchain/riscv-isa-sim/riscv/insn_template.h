@@ -2,8 +2,10 @@
 
 #include "arith.h"
 #include "mmu.h"
+#include "profiler.h"
 #include "softfloat.h"
 #include "internals.h"
 #include "specialize.h"
 #include "tracer.h"
+#include "xpulp_simd.h"
 #include <assert.h>
@@ -3,3 +3,4 @@ require(insn.rvc_rs1() != 0);
 reg_t tmp = npc;
 set_pc(RVC_RS1 & ~reg_t(1));
 WRITE_REG(X_RA, tmp);
+profile_jump(X_RA, insn.rvc_rs1(), tmp);
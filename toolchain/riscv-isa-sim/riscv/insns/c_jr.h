@@ -1,3 +1,4 @@
 require_extension('C');
 require(insn.rvc_rs1() != 0);
 set_pc(RVC_RS1 & ~reg_t(1));
+profile_jump(0, insn.rvc_rs1(), 0);
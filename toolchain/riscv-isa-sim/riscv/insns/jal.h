@@ -1,3 +1,4 @@
 reg_t tmp = npc;
 set_pc(JUMP_TARGET);
 WRITE_RD(tmp);
+profile_jump(insn.rd(), 0, tmp);
@@ -1,3 +1,4 @@
 reg_t tmp = npc;
 set_pc((RS1 + insn.i_imm()) & ~reg_t(1));
 WRITE_RD(tmp);
+profile_jump(insn.rd(), insn.rs1(), tmp);
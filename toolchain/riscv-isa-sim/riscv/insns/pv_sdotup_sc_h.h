@@ -1,6 +1 @@
-uint32_t acc = RD;
-
-for(int i = xlen/16 - 1; i >= 0; i--)
-  acc += zext16(RS1_H(i)) * zext16(RS2_H(0));
-
-WRITE_RD(sext_xlen(acc));
+WRITE_RD(sext_xlen(uint32_t(RD) + simd_dotup_sc_h(RS1, RS2)));
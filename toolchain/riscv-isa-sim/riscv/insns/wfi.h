@@ -8,4 +8,5 @@ if (STATE.v && STATE.prv == PRV_U) {
 } else {
   require_privilege(PRV_S);
 }
-wfi();
+if (p->enter_wfi())
+  wfi();
@@ -0,0 +1,251 @@
+// See LICENSE for license details.
+
+#include "mempool.h"
+#include "processor.h"
+#include "byteorder.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+mempool_cfg_t::mempool_cfg_t()
+  : num_cores(256), num_groups(4), num_cores_per_tile(4), banking_factor(4),
+    l1_bank_size(1024), seq_mem_size(512), l2_base(0x80000000),
+    l2_size(0x400000), boot_addr(0xA0000000), remote_group_latency_cycles(7),
+    l2_latency_cycles(20), icache_size_byte(0), icache_sets(0),
+    icache_line_width(0), icache_prefetch(2)
+{
+}
+
+void mempool_cfg_t::parse(const char* s)
+{
+  std::stringstream stream(s);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (item == "mempool") {
+      num_cores = 256;
+      num_cores_per_tile = 4;
+      continue;
+    } else if (item == "minpool") {
+      num_cores = 16;
+      num_cores_per_tile = 4;
+      continue;
+    } else if (item == "terapool") {
+      num_cores = 1024;
+      num_cores_per_tile = 8;
+      continue;
+    }
+
+    size_t eq = item.find('=');
+    if (eq == std::string::npos)
+      throw std::runtime_error("MemPool parameter without value: " + item);
+    std::string key = item.substr(0, eq);
+    char* end;
+    reg_t value = strtoull(item.c_str() + eq + 1, &end, 0);
+    if (eq + 1 == item.size() || *end)
+      throw std::runtime_error("Error parsing MemPool parameter " + item);
+
+    if (key == "num_cores")
+      num_cores = value;
+    else if (key == "num_groups")
+      num_groups = value;
+    else if (key == "num_cores_per_tile")
+      num_cores_per_tile = value;
+    else if (key == "banking_factor")
+      banking_factor = value;
+    else if (key == "l1_bank_size")
+      l1_bank_size = value;
+    else if (key == "seq_mem_size")
+      seq_mem_size = value;
+    else if (key == "l2_base")
+      l2_base = value;
+    else if (key == "l2_size")
+      l2_size = value;
+    else if (key == "boot_addr")
+      boot_addr = value;
+    else if (key == "remote_group_latency_cycles")
+      remote_group_latency_cycles = value;
+    else if (key == "l2_latency_cycles")
+      l2_latency_cycles = value;
+    else if (key == "icache_size_byte")
+      icache_size_byte = value;
+    else if (key == "icache_sets")
+      icache_sets = value;
+    else if (key == "icache_line_width")
+      icache_line_width = value;
+    else if (key == "icache_prefetch")
+      icache_prefetch = value;
+    else
+      throw std::runtime_error("Unknown MemPool parameter " + key);
+  }
+
+  if (!num_cores || !num_groups || !num_cores_per_tile ||
+      num_cores % (num_groups * num_cores_per_tile) != 0)
+    throw std::runtime_error("MemPool needs the same number of tiles in every group");
+  if (seq_size() > l1_size())
+    throw std::runtime_error("MemPool's sequential regions exceed the L1");
+  for (reg_t x : {reg_t(num_cores), reg_t(num_groups), reg_t(num_cores_per_tile),
+                  reg_t(banking_factor), l1_bank_size, seq_mem_size})
+    if (x & (x - 1))
+      throw std::runtime_error("MemPool's parameters must be powers of two");
+  if (icache_line_bytes() < 4 || icache_line_bytes() & (icache_line_bytes() - 1) ||
+      icache_size() % (icache_ways() * icache_line_bytes()) != 0)
+    throw std::runtime_error("MemPool's instruction cache has an invalid geometry");
+  if (icache_prefetch > 2)
+    throw std::runtime_error("icache_prefetch must be 0, 1 or 2");
+}
+
+static unsigned log2(reg_t x)
+{
+  unsigned res = 0;
+  while (x >>= 1)
+    res++;
+  return res;
+}
+
+reg_t mempool_cfg_t::scramble(reg_t addr) const
+{
+  if (num_tiles() < 2 || !is_sequential(addr))
+    return addr;
+  unsigned const_bits = 2 + log2(num_banks_per_tile());
+  unsigned seq_per_tile_bits = log2(seq_tile_size());
+  unsigned seq_total_bits = seq_per_tile_bits + log2(num_tiles());
+  reg_t scramble = (addr & ((reg_t(1) << seq_per_tile_bits) - 1)) >> const_bits;
+  reg_t tile_id = (addr & ((reg_t(1) << seq_total_bits) - 1)) >> seq_per_tile_bits;
+  return (addr >> seq_total_bits << seq_total_bits) |
+         (scramble << (seq_total_bits - (seq_per_tile_bits - const_bits))) |
+         (tile_id << const_bits) |
+         (addr & ((reg_t(1) << const_bits) - 1));
+}
+
+mempool_cfg_t::region_t mempool_cfg_t::region(size_t core, reg_t addr) const
+{
+  if (!is_l1(addr))
+    return L2;
+  size_t tile = tile_of_core(core);
+  size_t target = l1_tile(addr);
+  if (target == tile)
+    return TILE;
+  return group_of_tile(target) == group_of_tile(tile) ? GROUP : REMOTE_GROUP;
+}
+
+mempool_ctrl_t::mempool_ctrl_t(const mempool_cfg_t& cfg,
+                               std::vector<processor_t*>& procs,
+                               std::function<void(reg_t)> eoc)
+  : cfg(cfg), procs(procs), eoc(eoc)
+{
+  // Reset values of ctrl_registers.sv
+  memset(regs, 0, sizeof(regs));
+  regs[TCDM_START] = 0;
+  regs[TCDM_END] = cfg.l1_size();
+  regs[NR_CORES] = cfg.num_cores;
+  regs[RO_CACHE_ENABLE] = 1;
+  regs[RO_CACHE_START_0] = 0x80000000;
+  regs[RO_CACHE_END_0] = 0x80001000;
+  regs[RO_CACHE_START_1] = 0xA0000000;
+  regs[RO_CACHE_END_1] = 0xA0001000;
+  regs[RO_CACHE_START_2] = 0x8;
+  regs[RO_CACHE_END_2] = 0xC;
+  regs[RO_CACHE_START_3] = 0xC;
+  regs[RO_CACHE_END_3] = 0x10;
+}
+
+bool mempool_ctrl_t::load(reg_t addr, size_t len, uint8_t* bytes)
+{
+  if (addr + len > sizeof(regs))
+    return false;
+  memcpy(bytes, (uint8_t*)regs + addr, len);
+  return true;
+}
+
+void mempool_ctrl_t::wake_up(size_t first_core, size_t num_cores)
+{
+  for (size_t i = first_core; i < first_core + num_cores && i < procs.size(); i++)
+    procs[i]->wake_up();
+}
+
+bool mempool_ctrl_t::store(reg_t addr, size_t len, const uint8_t* bytes)
+{
+  size_t reg = addr / sizeof(regs[0]);
+  if (addr + len > sizeof(regs) || (addr + len - 1) / sizeof(regs[0]) != reg)
+    return false;
+  // The TCDM boundaries and the number of cores are read-only
+  if (reg == TCDM_START || reg == TCDM_END || reg == NR_CORES)
+    return true;
+  uint32_t prev = regs[reg];
+  memcpy((uint8_t*)regs + addr, bytes, len);
+
+  // Like the testbench, end the simulation at the first valid EOC
+  uint64_t value = regs[reg];
+  uint64_t all = 0xffffffff;
+  if (reg == EOC) {
+    if ((value & 1) && !(prev & 1))
+      eoc(value);
+  } else if (reg == WAKE_UP) {
+    if (value < cfg.num_cores)
+      wake_up(value, 1);
+    else if (value == all)
+      wake_up(0, cfg.num_cores);
+  } else if (reg == WAKE_UP_GROUP) {
+    if (value < (1ULL << cfg.num_groups)) {
+      for (size_t g = 0; g < cfg.num_groups; g++)
+        if (value & (1ULL << g))
+          wake_up(g * cfg.num_cores_per_group(), cfg.num_cores_per_group());
+    } else if (value == all) {
+      wake_up(0, cfg.num_cores);
+    }
+  } else if (reg >= WAKE_UP_TILE_G0 && reg - WAKE_UP_TILE_G0 < cfg.num_groups) {
+    size_t g = reg - WAKE_UP_TILE_G0;
+    if (value < (1ULL << cfg.num_tiles_per_group())) {
+      for (size_t t = 0; t < cfg.num_tiles_per_group(); t++)
+        if (value & (1ULL << t))
+          wake_up(g * cfg.num_cores_per_group() + t * cfg.num_cores_per_tile,
+                  cfg.num_cores_per_tile);
+    }
+  }
+  return true;
+}
+
+mempool_uart_t::~mempool_uart_t()
+{
+  if (!line.empty())
+    printf("[UART] %s\n", line.c_str());
+}
+
+bool mempool_uart_t::load(reg_t addr, size_t len, uint8_t* bytes)
+{
+  memset(bytes, 0, len);
+  return true;
+}
+
+bool mempool_uart_t::store(reg_t addr, size_t len, const uint8_t* bytes)
+{
+  for (size_t i = 0; i < len; i++) {
+    line += bytes[i];
+    if (bytes[i] == '\n') {
+      printf("[UART] %s", line.c_str());
+      fflush(stdout);
+      line.clear();
+    }
+  }
+  return true;
+}
+
+std::vector<char> mempool_bootrom(const mempool_cfg_t& cfg)
+{
+  // la a0, __l2_start; wfi; jr a0
+  uint32_t hi = (cfg.l2_base + 0x800) >> 12;
+  uint32_t lo = cfg.l2_base - (hi << 12);
+  uint32_t bootrom[] = {
+    (hi << 12) | 0x537,                       // lui    a0, %hi(l2_base)
+    ((lo & 0xfff) << 20) | 0x50513,           // addi   a0, a0, %lo(l2_base)
+    0x10500073,                               // wfi
+    0x00050067,                               // jr     a0
+  };
+  for (auto& insn : bootrom)
+    insn = to_le(insn);
+  std::vector<char> rom((char*)bootrom, (char*)bootrom + sizeof(bootrom));
+  rom.resize(0x1000);
+  return rom;
+}
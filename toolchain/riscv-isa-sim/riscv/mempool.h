@@ -0,0 +1,121 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_MEMPOOL_H
+#define _RISCV_MEMPOOL_H
+
+#include "devices.h"
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+class processor_t;
+
+// Parameters of a MemPool platform, named after and defaulting to the
+// variables of MemPool's config/config.mk and config/mempool.mk.
+struct mempool_cfg_t
+{
+  mempool_cfg_t();
+
+  // Parse a comma-separated list of flavors (mempool, minpool, terapool) and
+  // <parameter>=<value> pairs, e.g., "terapool,seq_mem_size=1024". Throws
+  // std::runtime_error on unknown parameters.
+  void parse(const char* s);
+
+  size_t num_cores;
+  size_t num_groups;
+  size_t num_cores_per_tile;
+  size_t banking_factor;
+  reg_t l1_bank_size;
+  reg_t seq_mem_size;   // per core
+  reg_t l2_base;
+  reg_t l2_size;
+  reg_t boot_addr;
+  // Latencies of the timing model
+  unsigned remote_group_latency_cycles;
+  unsigned l2_latency_cycles;
+  // Instruction cache of a tile, derived from num_cores_per_tile as in
+  // hardware/src/mempool_pkg.sv unless set
+  reg_t icache_size_byte;
+  size_t icache_sets;
+  size_t icache_line_width;  // in bits
+  unsigned icache_prefetch;  // 0: off, 1: next line, 2: Snitch's L0 prefetcher
+
+  size_t num_tiles() const { return num_cores / num_cores_per_tile; }
+  size_t num_cores_per_group() const { return num_cores / num_groups; }
+  size_t num_tiles_per_group() const { return num_tiles() / num_groups; }
+  size_t num_banks() const { return num_cores * banking_factor; }
+  size_t num_banks_per_tile() const { return num_cores_per_tile * banking_factor; }
+  reg_t l1_size() const { return num_banks() * l1_bank_size; }
+
+  // The sequential regions of all tiles are at the beginning of the L1,
+  // followed by the interleaved region
+  reg_t seq_tile_size() const { return num_cores_per_tile * seq_mem_size; }
+  reg_t seq_size() const { return num_cores * seq_mem_size; }
+  bool is_sequential(reg_t addr) const { return addr < seq_size(); }
+  bool is_l1(reg_t addr) const { return addr < l1_size(); }
+
+  // Address of an L1 address after hardware/src/address_scrambler.sv, which
+  // turns the sequential regions into consecutive lines of each tile
+  reg_t scramble(reg_t addr) const;
+  // Global index of the bank and the tile of an L1 address
+  size_t l1_bank(reg_t addr) const { return (scramble(addr) >> 2) % num_banks(); }
+  size_t l1_tile(reg_t addr) const { return l1_bank(addr) / num_banks_per_tile(); }
+  size_t tile_of_core(size_t core) const { return core / num_cores_per_tile; }
+  size_t group_of_tile(size_t tile) const { return tile / num_tiles_per_group(); }
+
+  reg_t icache_size() const { return icache_size_byte ? icache_size_byte : 512 * num_cores_per_tile; }
+  size_t icache_ways() const { return icache_sets ? icache_sets : std::max<size_t>(num_cores_per_tile / 2, 1); }
+  size_t icache_line_bytes() const { return (icache_line_width ? icache_line_width : 64 * num_cores_per_tile) / 8; }
+
+  // Where an address is as seen from a core
+  enum region_t { TILE, GROUP, REMOTE_GROUP, L2, NUM_REGIONS };
+  region_t region(size_t core, reg_t addr) const;
+};
+
+#define MEMPOOL_CTRL_BASE 0x40000000
+#define MEMPOOL_UART_BASE 0xC0000000
+
+// Control registers of MemPool (hardware/src/ctrl_registers.sv)
+class mempool_ctrl_t : public abstract_device_t {
+ public:
+  mempool_ctrl_t(const mempool_cfg_t& cfg, std::vector<processor_t*>& procs,
+                 std::function<void(reg_t)> eoc);
+  bool load(reg_t addr, size_t len, uint8_t* bytes);
+  bool store(reg_t addr, size_t len, const uint8_t* bytes);
+  bool eoc_valid() const { return regs[EOC] & 1; }
+
+ private:
+  enum {
+    EOC, WAKE_UP, WAKE_UP_GROUP, TCDM_START, TCDM_END, NR_CORES,
+    RO_CACHE_ENABLE, RO_CACHE_FLUSH, RO_CACHE_START_0, RO_CACHE_END_0,
+    RO_CACHE_START_1, RO_CACHE_END_1, RO_CACHE_START_2, RO_CACHE_END_2,
+    RO_CACHE_START_3, RO_CACHE_END_3, WAKE_UP_TILE_G0,
+    NUM_REGS = WAKE_UP_TILE_G0 + 8
+  };
+
+  void wake_up(size_t first_core, size_t num_cores);
+
+  const mempool_cfg_t& cfg;
+  std::vector<processor_t*>& procs;
+  std::function<void(reg_t)> eoc;
+  uint32_t regs[NUM_REGS];
+};
+
+// Character output of MemPool's testbench (hardware/tb/axi_uart.sv), which
+// prints each line with a [UART] prefix
+class mempool_uart_t : public abstract_device_t {
+ public:
+  ~mempool_uart_t();
+  bool load(reg_t addr, size_t len, uint8_t* bytes);
+  bool store(reg_t addr, size_t len, const uint8_t* bytes);
+
+ private:
+  std::string line;
+};
+
+// Boot ROM of MemPool (software/runtime/bootrom.S): cores that return to it
+// at the end of the computation go to sleep
+std::vector<char> mempool_bootrom(const mempool_cfg_t& cfg);
+
+#endif
@@ -0,0 +1,190 @@
+// See LICENSE for license details.
+
+#include "mempool_icache.h"
+#include "mempool_timing.h"
+#include "processor.h"
+#include "mmu.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+mempool_icache_t::mempool_icache_t(const mempool_cfg_t& cfg,
+                                   const std::vector<processor_t*>& procs,
+                                   std::function<char*(reg_t)> addr_to_mem)
+  : cfg(cfg), addr_to_mem(addr_to_mem), line_bytes(cfg.icache_line_bytes()),
+    ways(cfg.icache_ways()),
+    lines_per_way(cfg.icache_size() / (cfg.icache_ways() * cfg.icache_line_bytes()))
+{
+  for (size_t i = 0; i < cfg.num_tiles(); i++) {
+    tiles.emplace_back(new tile_t());
+    tiles.back()->tags.resize(ways * lines_per_way);
+    memset(&tiles.back()->count, 0, sizeof(counters_t));
+  }
+  for (size_t i = 0; i < procs.size(); i++) {
+    tracers.emplace_back(new tracer_t(*this, *tiles[cfg.tile_of_core(i)]));
+    procs[i]->get_mmu()->register_memtracer(tracers.back().get());
+  }
+}
+
+void mempool_icache_t::set_timing(size_t hart, mempool_timing_t* timing)
+{
+  tracers.at(hart)->timing = timing;
+}
+
+bool mempool_icache_t::l1_access(tile_t& tile, reg_t line)
+{
+  reg_t* set = &tile.tags[(line % lines_per_way) * ways];
+  if (std::find(set, set + ways, line + 1) != set + ways)
+    return true;
+
+  reg_t* way = std::find(set, set + ways, 0);
+  if (way == set + ways)
+    way = set + tile.lfsr.next() % ways;
+  *way = line + 1;
+  return false;
+}
+
+mempool_icache_t::tracer_t::tracer_t(mempool_icache_t& icache, tile_t& tile)
+  : timing(NULL), fetches(0), l0_hits(0), useful_prefetches(0), icache(icache), tile(tile), l0_next(0)
+{
+  memset(l0, 0, sizeof(l0));
+  memset(l0_prefetched, 0, sizeof(l0_prefetched));
+}
+
+size_t mempool_icache_t::tracer_t::l0_lookup(reg_t line) const
+{
+  return std::find(l0, l0 + L0_LINES, line + 1) - l0;
+}
+
+void mempool_icache_t::tracer_t::l0_insert(reg_t line, bool prefetch)
+{
+  l0[l0_next] = line + 1;
+  l0_prefetched[l0_next] = prefetch;
+  l0_next = (l0_next + 1) % L0_LINES;
+}
+
+reg_t mempool_icache_t::tracer_t::prefetch_target(reg_t addr, reg_t line) const
+{
+  // Snitch's L0 prefetches the target of the first backward branch or jal at
+  // or after the fetch in the line, and the next line otherwise
+  size_t line_bytes = icache.line_bytes;
+  if (icache.cfg.icache_prefetch == 2) {
+    if (const char* host = icache.addr_to_mem(line * line_bytes)) {
+      for (reg_t a = addr & ~reg_t(3); a < (line + 1) * line_bytes; a += 4) {
+        insn_t insn(from_le(*(const uint32_t*)(host + (a - line * line_bytes))));
+        unsigned opcode = insn.bits() & 0x7f;
+        if (opcode == 0x6f)
+          return (a + insn.uj_imm()) / line_bytes;
+        if (opcode == 0x63 && insn.sb_imm() < 0)
+          return (a + insn.sb_imm()) / line_bytes;
+      }
+    }
+  }
+  return line + 1;
+}
+
+void mempool_icache_t::tracer_t::trace(uint64_t addr, size_t bytes, access_type type)
+{
+  reg_t line = addr / icache.line_bytes;
+  size_t l0_index = l0_lookup(line);
+  bool l0_hit = l0_index != L0_LINES;
+  if (l0_hit && l0_prefetched[l0_index]) {
+    useful_prefetches++;
+    l0_prefetched[l0_index] = false;
+  }
+  reg_t prefetch = line;
+  if (l0_hit && icache.cfg.icache_prefetch) {
+    prefetch = prefetch_target(addr, line);
+    if (l0_lookup(prefetch) != L0_LINES)
+      prefetch = line;
+  }
+
+  if (!l0_hit || prefetch != line) {
+    std::lock_guard<std::mutex> guard(tile.lock);
+    if (!l0_hit) {
+      if (icache.l1_access(tile, line)) {
+        tile.count.l1_hits++;
+      } else {
+        tile.count.misses++;
+        tile.misses[addr]++;
+        if (timing)
+          timing->stall_fetch(icache.cfg.l2_latency_cycles);
+      }
+      l0_insert(line, false);
+    }
+    if (prefetch != line) {
+      tile.count.prefetches++;
+      if (!icache.l1_access(tile, prefetch))
+        tile.count.prefetch_refills++;
+      l0_insert(prefetch, true);
+    }
+  }
+
+  fetches++;
+  l0_hits += l0_hit;
+}
+
+bool mempool_icache_t::print(const std::string& prefix,
+                             std::function<const char*(reg_t)> symbolize) const
+{
+  std::string path = prefix + "_tiles.csv";
+  FILE* out = fopen(path.c_str(), "w");
+  if (!out) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+  fprintf(out, "tile,fetches,l0_hits,l1_hits,misses,hit_rate,l1_hit_rate,"
+               "prefetches,prefetch_refills,useful_prefetches,refill_bytes,"
+               "refill_bytes_per_kfetch,stall_cycles\n");
+  for (size_t t = 0; t < tiles.size(); t++) {
+    counters_t c = tiles[t]->count;
+    for (size_t i = t * cfg.num_cores_per_tile; i < (t + 1) * cfg.num_cores_per_tile &&
+                                                i < tracers.size(); i++) {
+      c.fetches += tracers[i]->fetches;
+      c.l0_hits += tracers[i]->l0_hits;
+      c.useful_prefetches += tracers[i]->useful_prefetches;
+    }
+    uint64_t refill_bytes = (c.misses + c.prefetch_refills) * line_bytes;
+    uint64_t l0_misses = c.fetches - c.l0_hits;
+    fprintf(out, "%zu,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.4f,%.4f,%"
+                 PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.1f,%" PRIu64 "\n",
+            t, c.fetches, c.l0_hits, c.l1_hits, c.misses,
+            c.fetches ? 1.0 - double(c.misses) / c.fetches : 0.0,
+            l0_misses ? double(c.l1_hits) / l0_misses : 0.0,
+            c.prefetches, c.prefetch_refills, c.useful_prefetches, refill_bytes,
+            c.fetches ? 1000.0 * refill_bytes / c.fetches : 0.0,
+            c.misses * cfg.l2_latency_cycles);
+  }
+  fclose(out);
+
+  // Sum up the misses of all tiles per enclosing symbol
+  std::map<std::string, uint64_t> symbols;
+  for (auto& t : tiles) {
+    for (auto& miss : t->misses) {
+      const char* symbol = symbolize(miss.first);
+      symbols[symbol ? symbol : "?"] += miss.second;
+    }
+  }
+  std::vector<std::pair<uint64_t, std::string>> hotspots;
+  for (auto& s : symbols)
+    hotspots.emplace_back(s.second, s.first);
+  std::stable_sort(hotspots.begin(), hotspots.end(),
+                   [](const std::pair<uint64_t, std::string>& a,
+                      const std::pair<uint64_t, std::string>& b) {
+                     return a.first > b.first;
+                   });
+
+  path = prefix + "_symbols.csv";
+  out = fopen(path.c_str(), "w");
+  if (!out) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+  fprintf(out, "symbol,misses\n");
+  for (auto& h : hotspots)
+    fprintf(out, "%s,%" PRIu64 "\n", h.second.c_str(), h.first);
+  fclose(out);
+  return true;
+}
@@ -0,0 +1,105 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_MEMPOOL_ICACHE_H
+#define _RISCV_MEMPOOL_ICACHE_H
+
+#include "decode.h"
+#include "memtracer.h"
+#include "cachesim.h"
+#include "mempool.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class processor_t;
+class mempool_timing_t;
+
+// Instruction caches of MemPool's tiles (snitch_icache in mempool_tile.sv):
+// every core has a small, fully-associative L0 with a prefetcher, and the
+// cores of a tile share a set-associative L1 with random replacement, which
+// is refilled from the L2. Every hart has its own memtracer for its fetches;
+// the L1 of a tile is locked as its harts may run on different host threads.
+// Prefetches are assumed to arrive in time.
+class mempool_icache_t
+{
+ public:
+  mempool_icache_t(const mempool_cfg_t& cfg, const std::vector<processor_t*>& procs,
+                   std::function<char*(reg_t)> addr_to_mem);
+
+  // Charge the L1 misses of each hart to its timing model
+  void set_timing(size_t hart, mempool_timing_t* timing);
+
+  // Write <prefix>_tiles.csv, one row per tile, and <prefix>_symbols.csv, the
+  // L1 misses per symbol enclosing the missing fetch
+  bool print(const std::string& prefix,
+             std::function<const char*(reg_t)> symbolize) const;
+
+ private:
+  static const size_t L0_LINES = 4;
+
+  struct counters_t
+  {
+    uint64_t fetches;
+    uint64_t l0_hits;
+    uint64_t l1_hits;
+    uint64_t misses;
+    uint64_t prefetches;        // prefetches looked up in the L1
+    uint64_t prefetch_refills;  // of which missed in the L1
+    uint64_t useful_prefetches; // prefetched lines later hit by a fetch
+  };
+
+  struct tile_t
+  {
+    std::mutex lock;
+    std::vector<reg_t> tags; // line address + 1, 0 if invalid
+    lfsr_t lfsr;
+    counters_t count;
+    std::unordered_map<reg_t, uint64_t> misses; // per fetch address
+  };
+
+  class tracer_t : public memtracer_t
+  {
+   public:
+    tracer_t(mempool_icache_t& icache, tile_t& tile);
+    bool interested_in_range(uint64_t begin, uint64_t end, access_type type)
+    {
+      return type == FETCH;
+    }
+    void trace(uint64_t addr, size_t bytes, access_type type);
+
+    mempool_timing_t* timing;
+    // Counted per hart, so that L0 hits need no lock
+    uint64_t fetches;
+    uint64_t l0_hits;
+    uint64_t useful_prefetches;
+
+   private:
+    // Index of the line in the L0, or L0_LINES
+    size_t l0_lookup(reg_t line) const;
+    void l0_insert(reg_t line, bool prefetch);
+    reg_t prefetch_target(reg_t addr, reg_t line) const;
+
+    mempool_icache_t& icache;
+    tile_t& tile;
+    reg_t l0[L0_LINES];  // line address + 1, 0 if invalid
+    bool l0_prefetched[L0_LINES]; // not yet hit by a fetch
+    size_t l0_next;      // round-robin eviction
+  };
+
+  // Look up a line in the L1 of a tile and refill it on a miss, with the
+  // tile's lock held. Returns whether it hit.
+  bool l1_access(tile_t& tile, reg_t line);
+
+  const mempool_cfg_t& cfg;
+  std::function<char*(reg_t)> addr_to_mem;
+  size_t line_bytes;
+  size_t ways;
+  size_t lines_per_way;
+  std::vector<std::unique_ptr<tile_t>> tiles;
+  std::vector<std::unique_ptr<tracer_t>> tracers;
+};
+
+#endif
@@ -0,0 +1,149 @@
+// See LICENSE for license details.
+
+#include "mempool_perf.h"
+#include "mempool_timing.h"
+#include "encoding.h"
+#include <cinttypes>
+#include <cstring>
+
+mempool_perf_t::mempool_perf_t(const mempool_cfg_t& cfg, size_t hart)
+  : cfg(cfg), hart(hart), timing(NULL), num_accesses(0), access(0)
+{
+  memset(&count, 0, sizeof(count));
+  sections.push_back(count);
+}
+
+static mempool_perf_t::class_t classify(insn_t insn)
+{
+  uint64_t bits = insn.bits();
+  if ((bits & 3) != 3)
+    return mempool_perf_t::OTHER_INSN;
+  unsigned funct7 = bits >> 25;
+  switch (bits & 0x7f) {
+    case 0x13: case 0x17: case 0x37:
+      return mempool_perf_t::ALU;
+    case 0x33:
+      if (funct7 == 0x01)
+        return mempool_perf_t::MULDIV;
+      return funct7 == 0x00 || funct7 == 0x20 ? mempool_perf_t::ALU : mempool_perf_t::XPULP;
+    case 0x03: case 0x0b:
+      return mempool_perf_t::LOAD;
+    case 0x23: case 0x2b:
+      return mempool_perf_t::STORE;
+    case 0x2f:
+      return mempool_perf_t::AMO;
+    case 0x63:
+      return mempool_perf_t::BRANCH;
+    case 0x67: case 0x6f:
+      return mempool_perf_t::JUMP;
+    case 0x0f: case 0x73:
+      return mempool_perf_t::SYSTEM;
+    case 0x57: case 0x5b: case 0x77: case 0x7b:
+      return mempool_perf_t::XPULP;
+    default:
+      return mempool_perf_t::OTHER_INSN;
+  }
+}
+
+void mempool_perf_t::retire(insn_t insn, reg_t pc, reg_t npc)
+{
+  class_t c = classify(insn);
+  count.insns++;
+  count.classes[c]++;
+
+  if (c == LOAD || c == STORE || c == AMO) {
+    // Accesses to I/O space are not traced
+    access_t where = OTHER;
+    if (num_accesses && cfg.is_l1(access)) {
+      bool local = cfg.l1_tile(access) == cfg.tile_of_core(hart);
+      if (cfg.is_sequential(access))
+        where = local ? SEQ_LOCAL : SEQ_GLOBAL;
+      else
+        where = local ? ITL_LOCAL : ITL_GLOBAL;
+    }
+    if (c == STORE)
+      count.stores[where]++;
+    else
+      count.loads[where]++;
+  } else if (c == BRANCH && npc != pc + 4) {
+    count.branches_taken++;
+  } else if (c == SYSTEM && insn.bits() & 0x3000) {
+    reg_t csr = insn.csr();
+    if (csr == CSR_TRACE || csr == CSR_MCYCLE || csr == CSR_MCYCLEH)
+      sections.push_back(snapshot());
+  }
+  num_accesses = 0;
+}
+
+mempool_perf_t::counters_t mempool_perf_t::snapshot() const
+{
+  counters_t c = count;
+  if (timing) {
+    const mempool_timing_t::counters_t& t = timing->get_counters();
+    c.cycles = t.cycles;
+    c.wfi = t.sleep;
+    c.stall_ins = t.stall_fetch;
+    c.stall_raw_lsu = t.stall_load;
+    c.stall_raw_acc = t.stall_acc;
+    c.stall_lsu = t.stall_bank;
+  } else {
+    c.cycles = c.insns + c.wfi;
+  }
+  return c;
+}
+
+void mempool_perf_t::print_header(FILE* out)
+{
+  fprintf(out, "core,section,start,end,cycles,snitch_loads,snitch_stores,"
+               "snitch_avg_load_latency,snitch_occupancy,snitch_load_latency,"
+               "total_ipc,snitch_issues,stall_tot,stall_ins,stall_raw,stall_raw_lsu,"
+               "stall_raw_acc,stall_lsu,stall_acc,stall_wfi,seq_loads_local,"
+               "seq_loads_global,itl_loads_local,itl_loads_global,seq_latency_local,"
+               "seq_latency_global,itl_latency_local,itl_latency_global,"
+               "snitch_load_latency,snitch_load_region,snitch_load_tile,"
+               "snitch_store_region,snitch_store_region,snitch_store_tile,"
+               "seq_stores_local,seq_stores_global,itl_stores_local,itl_stores_global,"
+               "other_loads,other_stores,amos,branches,branches_taken,jumps,"
+               "alu_insns,muldiv_insns,xpulp_insns,system_insns,other_insns\n");
+}
+
+void mempool_perf_t::print(FILE* out) const
+{
+  std::vector<counters_t> bounds = sections;
+  bounds.push_back(snapshot());
+  // Like gen_trace.py, drop the last section if it has no instructions
+  if (bounds.back().insns == bounds[bounds.size() - 2].insns)
+    bounds.pop_back();
+
+  for (size_t i = 0; i + 1 < bounds.size(); i++) {
+    counters_t c;
+    const uint64_t* start = (const uint64_t*)&bounds[i];
+    const uint64_t* end = (const uint64_t*)&bounds[i + 1];
+    uint64_t* diff = (uint64_t*)&c;
+    for (size_t j = 0; j < sizeof(counters_t) / sizeof(uint64_t); j++)
+      diff[j] = end[j] - start[j];
+
+    // The latencies of single loads are not known, and the per-access lists
+    // of gen_trace.py are left empty
+    uint64_t stall_raw = c.stall_raw_lsu + c.stall_raw_acc;
+    uint64_t stall_tot = c.stall_ins + stall_raw + c.stall_lsu + c.wfi;
+    double ipc = c.cycles ? double(c.insns) / c.cycles : 0.0;
+    fprintf(out, "%zu,%zu,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                 ",,%.4f,,%.4f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                 ",%" PRIu64 ",%" PRIu64 ",0,%" PRIu64,
+            hart, i, bounds[i].cycles, bounds[i].cycles + c.cycles - 1, c.cycles,
+            c.classes[LOAD] + c.classes[AMO], c.classes[STORE], ipc, ipc, c.insns,
+            stall_tot, c.stall_ins, stall_raw, c.stall_raw_lsu, c.stall_raw_acc,
+            c.stall_lsu, c.wfi);
+    for (int a = SEQ_LOCAL; a <= ITL_GLOBAL; a++)
+      fprintf(out, ",%" PRIu64, c.loads[a]);
+    fprintf(out, ",,,,,,,,,,");
+    for (int a = SEQ_LOCAL; a <= ITL_GLOBAL; a++)
+      fprintf(out, ",%" PRIu64, c.stores[a]);
+    fprintf(out, ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+            c.loads[OTHER], c.stores[OTHER], c.classes[AMO], c.classes[BRANCH],
+            c.branches_taken, c.classes[JUMP], c.classes[ALU], c.classes[MULDIV],
+            c.classes[XPULP], c.classes[SYSTEM], c.classes[OTHER_INSN]);
+  }
+}
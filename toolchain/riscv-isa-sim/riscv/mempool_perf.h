@@ -0,0 +1,83 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_MEMPOOL_PERF_H
+#define _RISCV_MEMPOOL_PERF_H
+
+#include "decode.h"
+#include "memtracer.h"
+#include "mempool.h"
+#include <cstdio>
+#include <vector>
+
+class mempool_timing_t;
+
+// Performance counters of a core of MemPool per section of its execution, as
+// hardware/scripts/gen_trace.py computes them from the RTL traces: every
+// access to the trace or mcycle CSR ends a section. Without the timing model,
+// a core takes one cycle per instruction and per step of the simulation that
+// it sleeps in wfi.
+class mempool_perf_t : public memtracer_t
+{
+ public:
+  // Where an access is, in the terms of gen_trace.py
+  enum access_t { SEQ_LOCAL, SEQ_GLOBAL, ITL_LOCAL, ITL_GLOBAL, OTHER, NUM_ACCESSES };
+  enum class_t { ALU, MULDIV, LOAD, STORE, AMO, BRANCH, JUMP, SYSTEM, XPULP, OTHER_INSN, NUM_CLASSES };
+
+  struct counters_t
+  {
+    uint64_t cycles;
+    uint64_t insns;
+    uint64_t wfi;
+    uint64_t stall_ins;     // instruction cache misses
+    uint64_t stall_raw_lsu; // RAW and WAW stalls on the result of a load
+    uint64_t stall_raw_acc; // stalls on the multiplier and divider
+    uint64_t stall_lsu;     // bank conflicts
+    uint64_t classes[NUM_CLASSES];
+    uint64_t loads[NUM_ACCESSES];  // including AMOs
+    uint64_t stores[NUM_ACCESSES];
+    uint64_t branches_taken;
+  };
+
+  mempool_perf_t(const mempool_cfg_t& cfg, size_t hart);
+
+  // Take the cycles and stalls from the timing model of the core
+  void set_timing(mempool_timing_t* timing) { this->timing = timing; }
+
+  bool interested_in_range(uint64_t begin, uint64_t end, access_type type)
+  {
+    return type != FETCH;
+  }
+  void trace(uint64_t addr, size_t bytes, access_type type)
+  {
+    // An AMO is traced as a load and a store of the same address
+    if (!num_accesses) {
+      access = addr;
+      num_accesses++;
+    }
+  }
+
+  // Account for the instruction at pc that has just been executed and
+  // continues at npc
+  void retire(insn_t insn, reg_t pc, reg_t npc);
+  // The core sleeps in wfi for the given steps of the simulation
+  void idle(size_t steps) { count.wfi += steps; }
+
+  // Write one CSV row per section, with the columns of gen_trace.py followed
+  // by those it does not have
+  static void print_header(FILE* out);
+  void print(FILE* out) const;
+
+ private:
+  counters_t snapshot() const;
+
+  const mempool_cfg_t& cfg;
+  size_t hart;
+  mempool_timing_t* timing;
+  counters_t count;
+  size_t num_accesses;
+  reg_t access;
+  // Counters at the beginning of every section
+  std::vector<counters_t> sections;
+};
+
+#endif
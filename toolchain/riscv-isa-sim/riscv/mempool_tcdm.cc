@@ -0,0 +1,148 @@
+// See LICENSE for license details.
+
+#include "mempool_tcdm.h"
+#include "processor.h"
+#include "mmu.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+mempool_tcdm_t::tracer_t::tracer_t(const mempool_cfg_t& cfg, processor_t* proc,
+                                   size_t hart)
+  : cfg(cfg), proc(proc), hart(hart), last_pc(-1), last_addr(-1)
+{
+}
+
+void mempool_tcdm_t::tracer_t::trace(uint64_t addr, size_t bytes, access_type type)
+{
+  // The PC is that of the executing instruction, whose AMOs are traced as a
+  // load and a store of the same address
+  unsigned xlen = proc->get_xlen();
+  reg_t pc = zext_xlen(proc->get_state()->pc);
+  bool amo = type == STORE && pc == last_pc && addr == last_addr;
+  last_pc = pc;
+  last_addr = type == LOAD ? addr : -1;
+  if (amo) {
+    if (cfg.is_l1(addr))
+      log.back() = (log.back() & ~3) | AMO_ACCESS;
+    return;
+  }
+
+  pcs[pc].accesses[cfg.region(hart, addr)]++;
+  if (cfg.is_l1(addr))
+    log.push_back(cfg.l1_bank(addr) << 2 | (type == LOAD ? LOAD_ACCESS : STORE_ACCESS));
+}
+
+mempool_tcdm_t::mempool_tcdm_t(const mempool_cfg_t& cfg,
+                               const std::vector<processor_t*>& procs)
+  : cfg(cfg), banks(cfg.num_banks()), quantum_harts(cfg.num_banks()),
+    last_hart(cfg.num_banks())
+{
+  memset(banks.data(), 0, banks.size() * sizeof(bank_counters_t));
+  for (size_t i = 0; i < procs.size(); i++) {
+    tracers.emplace_back(new tracer_t(cfg, procs[i], i));
+    procs[i]->get_mmu()->register_memtracer(tracers.back().get());
+  }
+}
+
+void mempool_tcdm_t::end_quantum()
+{
+  for (size_t hart = 0; hart < tracers.size(); hart++) {
+    size_t tile = cfg.tile_of_core(hart);
+    size_t group = cfg.group_of_tile(tile);
+    for (uint32_t entry : tracers[hart]->log) {
+      size_t bank = entry >> 2;
+      size_t target = bank / cfg.num_banks_per_tile();
+      bank_counters_t& c = banks[bank];
+      c.accesses[entry & 3]++;
+      if (target == tile)
+        c.from[mempool_cfg_t::TILE]++;
+      else if (cfg.group_of_tile(target) == group)
+        c.from[mempool_cfg_t::GROUP]++;
+      else
+        c.from[mempool_cfg_t::REMOTE_GROUP]++;
+      if (last_hart[bank] != hart + 1) {
+        last_hart[bank] = hart + 1;
+        if (quantum_harts[bank]++ == 0)
+          touched.push_back(bank);
+      }
+    }
+    tracers[hart]->log.clear();
+  }
+
+  for (uint32_t bank : touched) {
+    bank_counters_t& c = banks[bank];
+    uint32_t harts = quantum_harts[bank];
+    c.quanta++;
+    c.contended += harts > 1;
+    c.hart_quanta += harts;
+    c.max_harts = std::max<uint64_t>(c.max_harts, harts);
+    quantum_harts[bank] = 0;
+    last_hart[bank] = 0;
+  }
+  touched.clear();
+}
+
+bool mempool_tcdm_t::print(const std::string& prefix,
+                           std::function<const char*(reg_t)> symbolize) const
+{
+  std::string path = prefix + "_banks.csv";
+  FILE* out = fopen(path.c_str(), "w");
+  if (!out) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+  // Banks are numbered globally, tile * banks_per_tile + bank_in_tile
+  fprintf(out, "bank,group,tile,bank_in_tile,accesses,loads,stores,amos,"
+               "from_tile,from_group,from_remote_group,quanta,"
+               "contended_quanta,mean_harts,max_harts\n");
+  for (size_t bank = 0; bank < banks.size(); bank++) {
+    const bank_counters_t& c = banks[bank];
+    size_t tile = bank / cfg.num_banks_per_tile();
+    fprintf(out, "%zu,%zu,%zu,%zu,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                 ",%.4f,%" PRIu64 "\n",
+            bank, cfg.group_of_tile(tile), tile, bank % cfg.num_banks_per_tile(),
+            c.accesses[LOAD_ACCESS] + c.accesses[STORE_ACCESS] + c.accesses[AMO_ACCESS],
+            c.accesses[LOAD_ACCESS], c.accesses[STORE_ACCESS], c.accesses[AMO_ACCESS],
+            c.from[mempool_cfg_t::TILE], c.from[mempool_cfg_t::GROUP],
+            c.from[mempool_cfg_t::REMOTE_GROUP], c.quanta, c.contended,
+            c.quanta ? double(c.hart_quanta) / c.quanta : 0.0, c.max_harts);
+  }
+  fclose(out);
+
+  // Sum up the accesses of all harts per enclosing symbol
+  std::map<std::string, pc_counters_t> regions;
+  for (auto& t : tracers) {
+    for (auto& pc : t->pcs) {
+      const char* symbol = symbolize(pc.first);
+      pc_counters_t& c = regions[symbol ? symbol : "?"];
+      for (size_t i = 0; i < mempool_cfg_t::NUM_REGIONS; i++)
+        c.accesses[i] += pc.second.accesses[i];
+    }
+  }
+
+  path = prefix + "_regions.csv";
+  out = fopen(path.c_str(), "w");
+  if (!out) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+  fprintf(out, "symbol,accesses,tile,group,remote_group,l2,local_fraction,"
+               "remote_fraction\n");
+  for (auto& r : regions) {
+    const uint64_t* n = r.second.accesses;
+    uint64_t total = n[mempool_cfg_t::TILE] + n[mempool_cfg_t::GROUP] +
+                     n[mempool_cfg_t::REMOTE_GROUP] + n[mempool_cfg_t::L2];
+    fprintf(out, "%s,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                 ",%.4f,%.4f\n",
+            r.first.c_str(), total, n[mempool_cfg_t::TILE], n[mempool_cfg_t::GROUP],
+            n[mempool_cfg_t::REMOTE_GROUP], n[mempool_cfg_t::L2],
+            total ? double(n[mempool_cfg_t::TILE]) / total : 0.0,
+            total ? double(n[mempool_cfg_t::GROUP] + n[mempool_cfg_t::REMOTE_GROUP]) / total : 0.0);
+  }
+  fclose(out);
+  return true;
+}
@@ -0,0 +1,82 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_MEMPOOL_TCDM_H
+#define _RISCV_MEMPOOL_TCDM_H
+
+#include "decode.h"
+#include "memtracer.h"
+#include "mempool.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class processor_t;
+
+// Accesses of the harts to MemPool's L1 banks (TCDM). Every hart has its own
+// memtracer, which logs the banks it accesses; at the end of every quantum,
+// when no hart runs, the logs are merged into per-bank statistics.
+class mempool_tcdm_t
+{
+ public:
+  mempool_tcdm_t(const mempool_cfg_t& cfg, const std::vector<processor_t*>& procs);
+
+  // All harts have run one quantum
+  void end_quantum();
+
+  // Write <prefix>_banks.csv, one row per bank, and <prefix>_regions.csv, the
+  // accesses per region of the memory of every code region (the symbol
+  // enclosing the PC of the access)
+  bool print(const std::string& prefix,
+             std::function<const char*(reg_t)> symbolize) const;
+
+ private:
+  enum { LOAD_ACCESS, STORE_ACCESS, AMO_ACCESS, NUM_ACCESS_TYPES };
+
+  struct bank_counters_t
+  {
+    uint64_t accesses[NUM_ACCESS_TYPES];
+    uint64_t from[mempool_cfg_t::NUM_REGIONS - 1]; // tile, group, remote group
+    uint64_t quanta;      // quanta in which any hart accessed the bank
+    uint64_t contended;   // quanta in which several harts accessed the bank
+    uint64_t hart_quanta; // sum of the harts accessing it over all quanta
+    uint64_t max_harts;
+  };
+
+  struct pc_counters_t
+  {
+    uint64_t accesses[mempool_cfg_t::NUM_REGIONS];
+  };
+
+  class tracer_t : public memtracer_t
+  {
+   public:
+    tracer_t(const mempool_cfg_t& cfg, processor_t* proc, size_t hart);
+    bool interested_in_range(uint64_t begin, uint64_t end, access_type type)
+    {
+      return type != FETCH;
+    }
+    void trace(uint64_t addr, size_t bytes, access_type type);
+
+    // Each entry is bank << 2 | access type
+    std::vector<uint32_t> log;
+    std::unordered_map<reg_t, pc_counters_t> pcs;
+
+   private:
+    const mempool_cfg_t& cfg;
+    processor_t* proc;
+    size_t hart;
+    reg_t last_pc;
+    reg_t last_addr;
+  };
+
+  const mempool_cfg_t& cfg;
+  std::vector<std::unique_ptr<tracer_t>> tracers;
+  std::vector<bank_counters_t> banks;
+  std::vector<uint32_t> quantum_harts; // harts per bank in this quantum
+  std::vector<uint32_t> last_hart;     // last hart + 1 counted per bank
+  std::vector<uint32_t> touched;       // banks accessed in this quantum
+};
+
+#endif
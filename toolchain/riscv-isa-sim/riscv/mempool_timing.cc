@@ -0,0 +1,203 @@
+// See LICENSE for license details.
+
+#include "mempool_timing.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <string>
+
+// Round-trip latencies of the L1 in cycles (MemPool's hierarchical
+// interconnect). The result is written back in the cycle after the response.
+static const unsigned TILE_LATENCY = 1;
+static const unsigned GROUP_LATENCY = 3;
+// Snitch's multiplier is pipelined; its divider is iterative and blocks it
+static const unsigned MUL_LATENCY = 2;
+static const unsigned DIV_LATENCY = 32;
+
+mempool_bank_table_t::mempool_bank_table_t(size_t num_banks)
+  : num_banks(num_banks), table(new std::atomic<uint64_t>[1 << LOG2_ENTRIES])
+{
+  for (size_t i = 0; i < (1 << LOG2_ENTRIES); i++)
+    table[i].store(0, std::memory_order_relaxed);
+}
+
+uint64_t mempool_bank_table_t::reserve(size_t bank, uint64_t cycle)
+{
+  while (true) {
+    uint64_t key = cycle * num_banks + bank + 1;
+    std::atomic<uint64_t>& entry = table[(key * 0x9e3779b97f4a7c15ULL) >> (64 - LOG2_ENTRIES)];
+    uint64_t old = entry.load(std::memory_order_relaxed);
+    if (old == key)
+      cycle++;
+    else if (entry.compare_exchange_weak(old, key, std::memory_order_relaxed))
+      return cycle;
+  }
+}
+
+thread_local uint64_t mempool_timing_t::now = 0;
+
+mempool_timing_t::mempool_timing_t(const mempool_cfg_t& cfg,
+                                   mempool_bank_table_t& banks, size_t hart)
+  : cfg(cfg), banks(banks), hart(hart), ipu_free(0), num_accesses(0),
+    asleep(false), wake_cycle(0), tracing(false)
+{
+  memset(&count, 0, sizeof(count));
+  memset(ready, 0, sizeof(ready));
+  memset(ready_from_load, 0, sizeof(ready_from_load));
+}
+
+unsigned mempool_timing_t::latency(unsigned region) const
+{
+  switch (region) {
+    case mempool_cfg_t::TILE: return TILE_LATENCY;
+    case mempool_cfg_t::GROUP: return GROUP_LATENCY;
+    case mempool_cfg_t::REMOTE_GROUP: return cfg.remote_group_latency_cycles;
+    default: return cfg.l2_latency_cycles;
+  }
+}
+
+void mempool_timing_t::trace(uint64_t addr, size_t bytes, access_type type)
+{
+  // An AMO is traced as a load and a store of the same address
+  if (num_accesses == MAX_ACCESSES || (num_accesses && accesses[0] == addr))
+    return;
+  accesses[num_accesses++] = addr;
+}
+
+void mempool_timing_t::retire(insn_t insn)
+{
+  if (asleep) {
+    uint64_t woken = wake_cycle.load(std::memory_order_relaxed);
+    if (woken > count.cycles) {
+      count.sleep += woken - count.cycles;
+      count.cycles = woken;
+    }
+    asleep = false;
+  }
+
+  uint64_t bits = insn.bits();
+  unsigned opcode = bits & 0x7f;
+  unsigned funct3 = (bits >> 12) & 7;
+  unsigned funct7 = bits >> 25;
+
+  bool is_load = opcode == 0x03 || opcode == 0x0b || opcode == 0x2f;
+  bool is_store = opcode == 0x23 || opcode == 0x2b;
+  unsigned funct5 = bits >> 27;
+  bool is_dotp = opcode == 0x57 && funct5 >= 0x10 && funct5 <= 0x17 &&
+                 funct5 != 0x12 && funct5 != 0x16; // pv.dot* and pv.sdot*
+  bool is_mul = (opcode == 0x33 && (funct7 == 0x01 || funct7 == 0x21)) || is_dotp;
+  bool is_div = is_mul && opcode == 0x33 && funct7 == 0x01 && funct3 >= 4;
+  bool writes_rd = !is_store && opcode != 0x63 && opcode != 0x0f &&
+                   !(opcode == 0x73 && funct3 == 0);
+
+  // Registers the instruction waits for: its sources and, like Snitch's
+  // scoreboard, its destination
+  unsigned regs[4];
+  size_t num_regs = 0;
+  if (opcode != 0x37 && opcode != 0x17 && opcode != 0x6f &&
+      !(opcode == 0x73 && funct3 >= 4))
+    regs[num_regs++] = insn.rs1();
+  if (is_store || opcode == 0x63 || opcode == 0x33 || opcode == 0x2f ||
+      opcode == 0x57 || opcode == 0x0b || opcode == 0x5b)
+    regs[num_regs++] = insn.rs2();
+  if (writes_rd)
+    regs[num_regs++] = insn.rd();
+
+  uint64_t issue = count.cycles;
+  bool blocked_by_load = false;
+  for (size_t i = 0; i < num_regs; i++) {
+    unsigned r = regs[i];
+    if (r && ready[r] > issue) {
+      issue = ready[r];
+      blocked_by_load = ready_from_load[r];
+    }
+  }
+  if (blocked_by_load)
+    count.stall_load += issue - count.cycles;
+  else
+    count.stall_acc += issue - count.cycles;
+  if (is_mul && ipu_free > issue) {
+    count.stall_acc += ipu_free - issue;
+    issue = ipu_free;
+  }
+
+  uint64_t result = issue + 1;
+  if (is_load || is_store) {
+    // Accesses to I/O space are not traced; count them as L2 accesses
+    uint64_t addr = num_accesses ? accesses[0] : 0;
+    unsigned region = num_accesses ? cfg.region(hart, addr) : mempool_cfg_t::L2;
+    unsigned lat = latency(region);
+    if (region != mempool_cfg_t::L2) {
+      // The request reaches the bank halfway and the core waits for its grant
+      uint64_t arrival = issue + (lat - 1) / 2;
+      uint64_t granted = banks.reserve(cfg.l1_bank(addr), arrival);
+      count.stall_bank += granted - arrival;
+      issue += granted - arrival;
+    }
+    if (is_load)
+      count.loads[region]++;
+    else
+      count.stores[region]++;
+    result = issue + lat + 1;
+  } else if (is_div) {
+    result = issue + DIV_LATENCY;
+    ipu_free = result;
+  } else if (is_mul) {
+    result = issue + MUL_LATENCY;
+  }
+
+  unsigned rd = insn.rd();
+  if (writes_rd && rd) {
+    ready[rd] = result;
+    ready_from_load[rd] = is_load;
+  }
+
+  num_accesses = 0;
+  count.insns++;
+  count.cycles = issue + 1;
+  now = count.cycles;
+}
+
+void mempool_timing_t::set_trace(bool value)
+{
+  if (value && !tracing) {
+    section_start = count;
+  } else if (!value && tracing) {
+    counters_t section;
+    const uint64_t* start = (const uint64_t*)&section_start;
+    const uint64_t* end = (const uint64_t*)&count;
+    uint64_t* diff = (uint64_t*)&section;
+    for (size_t i = 0; i < sizeof(counters_t) / sizeof(uint64_t); i++)
+      diff[i] = end[i] - start[i];
+    sections.push_back(section);
+  }
+  tracing = value;
+}
+
+void mempool_timing_t::print_header(FILE* out)
+{
+  fprintf(out, "hart,section,cycles,instructions,ipc,stall_load,stall_acc,"
+               "stall_bank,stall_fetch,sleep,loads_tile,loads_group,loads_remote_group,"
+               "loads_l2,stores_tile,stores_group,stores_remote_group,stores_l2\n");
+}
+
+static void print_counters(FILE* out, size_t hart, const char* section,
+                           const mempool_timing_t::counters_t& c)
+{
+  fprintf(out, "%zu,%s,%" PRIu64 ",%" PRIu64 ",%.4f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64,
+          hart, section, c.cycles, c.insns,
+          c.cycles ? double(c.insns) / c.cycles : 0.0,
+          c.stall_load, c.stall_acc, c.stall_bank, c.stall_fetch, c.sleep);
+  for (auto n : c.loads)
+    fprintf(out, ",%" PRIu64, n);
+  for (auto n : c.stores)
+    fprintf(out, ",%" PRIu64, n);
+  fprintf(out, "\n");
+}
+
+void mempool_timing_t::print(FILE* out) const
+{
+  for (size_t i = 0; i < sections.size(); i++)
+    print_counters(out, hart, std::to_string(i).c_str(), sections[i]);
+  print_counters(out, hart, "total", count);
+}
@@ -0,0 +1,104 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_MEMPOOL_TIMING_H
+#define _RISCV_MEMPOOL_TIMING_H
+
+#include "decode.h"
+#include "memtracer.h"
+#include "mempool.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Cycles in which MemPool's L1 banks serve a request, shared by all harts. A
+// lossy hash table of (bank, cycle) pairs: accesses far apart in time may
+// evict each other, which underestimates the conflicts.
+class mempool_bank_table_t
+{
+ public:
+  mempool_bank_table_t(size_t num_banks);
+
+  // Reserve the bank in the first cycle at or after the given one in which
+  // it is free and return that cycle
+  uint64_t reserve(size_t bank, uint64_t cycle);
+
+ private:
+  static const unsigned LOG2_ENTRIES = 22;
+  size_t num_banks;
+  std::unique_ptr<std::atomic<uint64_t>[]> table;
+};
+
+// Cycle-approximate timing of a Snitch core of MemPool: single-issue and in
+// order, with a scoreboard for the results of loads and of the multiplier and
+// divider. Instructions issue once their source and destination registers are
+// ready; loads take the latency of the region they access and wait for the
+// bank. The model observes the addresses as a memtracer of the hart's MMU.
+class mempool_timing_t : public memtracer_t
+{
+ public:
+  struct counters_t
+  {
+    uint64_t cycles;
+    uint64_t insns;
+    uint64_t stall_load;  // RAW and WAW stalls on the result of a load
+    uint64_t stall_acc;   // stalls on the multiplier and divider
+    uint64_t stall_bank;  // bank conflicts
+    uint64_t stall_fetch; // instruction cache misses
+    uint64_t sleep;       // cycles in wfi
+    uint64_t loads[mempool_cfg_t::NUM_REGIONS];
+    uint64_t stores[mempool_cfg_t::NUM_REGIONS];
+  };
+
+  mempool_timing_t(const mempool_cfg_t& cfg, mempool_bank_table_t& banks, size_t hart);
+
+  bool interested_in_range(uint64_t begin, uint64_t end, access_type type)
+  {
+    return type != FETCH;
+  }
+  void trace(uint64_t addr, size_t bytes, access_type type);
+
+  // Account for an instruction that has just been executed
+  void retire(insn_t insn);
+  // A write to the trace CSR starts (1) or ends (0) a section
+  void set_trace(bool value);
+  // The hart goes to sleep in wfi, or another hart wakes it up
+  void sleep() { asleep = true; }
+  void wake_up() { wake_cycle.store(now, std::memory_order_relaxed); }
+  // The fetch of the next instruction waits for a refill
+  void stall_fetch(uint64_t cycles) { count.cycles += cycles; count.stall_fetch += cycles; }
+
+  uint64_t get_cycle() const { return count.cycles; }
+  const counters_t& get_counters() const { return count; }
+
+  // Write one CSV row per section and one with the totals
+  static void print_header(FILE* out);
+  void print(FILE* out) const;
+
+ private:
+  unsigned latency(unsigned region) const;
+
+  const mempool_cfg_t& cfg;
+  mempool_bank_table_t& banks;
+  size_t hart;
+
+  counters_t count;
+  uint64_t ready[NXPR];      // cycle in which each register can be used
+  bool ready_from_load[NXPR];
+  uint64_t ipu_free;         // cycle in which the divider accepts a new operation
+
+  static const size_t MAX_ACCESSES = 2;
+  size_t num_accesses;
+  uint64_t accesses[MAX_ACCESSES];
+
+  bool asleep;
+  std::atomic<uint64_t> wake_cycle;
+  // Cycle of the hart running on this host thread, at which it wakes others
+  static thread_local uint64_t now;
+
+  bool tracing;
+  counters_t section_start;
+  std::vector<counters_t> sections;
+};
+
+#endif
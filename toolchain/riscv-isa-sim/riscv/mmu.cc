@@ -6,6 +6,8 @@
 
 mmu_t::mmu_t(simif_t* sim, processor_t* proc)
  : sim(sim), proc(proc),
+  num_blocks(0),
+  fetch_traced(false),
   check_triggers_fetch(false),
   check_triggers_load(false),
   check_triggers_store(false),
@@ -23,6 +25,67 @@ void mmu_t::flush_icache()
 {
   for (size_t i = 0; i < ICACHE_ENTRIES; i++)
     icache[i].tag = -1;
+
+  for (size_t i = 0; i < num_blocks; i++)
+    block_chunks[i / BLOCK_CHUNK][i % BLOCK_CHUNK].tag = -1;
+  block_map.clear();
+  num_blocks = 0;
+}
+
+static bool ends_block(insn_t insn)
+{
+  insn_bits_t bits = insn.bits();
+  if ((bits & 3) != 3) {
+    // c.jal, c.j, c.beqz, c.bnez; c.jr, c.jalr, c.ebreak and c.mv, c.add
+    unsigned funct3 = (bits >> 13) & 7;
+    return ((bits & 3) == 1 && (funct3 == 1 || funct3 >= 5)) ||
+           ((bits & 3) == 2 && funct3 == 4);
+  }
+  switch (bits & 0x7f) {
+    case 0x63: // branches
+    case 0x67: // jalr
+    case 0x6f: // jal
+    case 0x73: // system instructions, including CSR accesses
+    case 0x0f: // fence.i
+      return true;
+    default:
+      return false;
+  }
+}
+
+icache_block_t* mmu_t::refill_block(reg_t addr)
+{
+  // The first instruction raises its fetch exceptions; later ones end the
+  // block before them, so that they raise them when they are executed
+  insn_fetch_t fetch = load_insn(addr);
+
+  if (num_blocks == MAX_BLOCKS)
+    flush_icache();
+  if (num_blocks / BLOCK_CHUNK == block_chunks.size())
+    block_chunks.emplace_back(new icache_block_t[BLOCK_CHUNK]);
+  icache_block_t* block = &block_chunks[num_blocks / BLOCK_CHUNK][num_blocks % BLOCK_CHUNK];
+  num_blocks++;
+
+  block->tag = addr;
+  block->next[0] = block->next[1] = NULL;
+  size_t length = 0;
+  reg_t pc = addr;
+  while (true) {
+    pc += insn_length(fetch.insn.bits());
+    block->insns[length].fetch = fetch;
+    block->insns[length].next_pc = pc;
+    if (++length == icache_block_t::MAX_INSNS || ends_block(fetch.insn))
+      break;
+    try {
+      fetch = load_insn(pc);
+    } catch (trap_t&) {
+      break;
+    }
+  }
+  block->insns[length - 1].next_pc = -1;
+
+  block_map[addr] = block;
+  return block;
 }
 
 void mmu_t::flush_tlb()
@@ -182,6 +245,30 @@ void mmu_t::store_slow_path(reg_t addr, reg_t len, const uint8_t* bytes, uint32_
   }
 }
 
+// Translate the address of an AMO and return its host address, or NULL if
+// the AMO has to be performed as a load and a store (I/O space, triggers)
+char* mmu_t::amo_slow_path(reg_t addr, reg_t len)
+{
+  if (check_triggers_load || check_triggers_store)
+    return NULL;
+
+  reg_t paddr = translate(addr, len, LOAD, 0);
+  translate(addr, len, STORE, 0);
+  char* host_addr = sim->addr_to_mem(paddr);
+  if (!host_addr)
+    return NULL;
+
+  if (tracer.interested_in_range(paddr, paddr + PGSIZE, LOAD))
+    tracer.trace(paddr, len, LOAD);
+  else
+    refill_tlb(addr, paddr, host_addr, LOAD);
+  if (tracer.interested_in_range(paddr, paddr + PGSIZE, STORE))
+    tracer.trace(paddr, len, STORE);
+  else
+    refill_tlb(addr, paddr, host_addr, STORE);
+  return host_addr;
+}
+
 tlb_entry_t mmu_t::refill_tlb(reg_t vaddr, reg_t paddr, char* host_addr, access_type type)
 {
   reg_t idx = (vaddr >> PGSHIFT) % TLB_ENTRIES;
@@ -441,4 +528,5 @@ void mmu_t::register_memtracer(memtracer_t* t)
 {
   flush_tlb();
   tracer.hook(t);
+  fetch_traced |= t->interested_in_range(0, reg_t(-1), FETCH);
 }
@@ -12,6 +12,8 @@
 #include "memtracer.h"
 #include "byteorder.h"
 #include <stdlib.h>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 // virtual memory configuration
@@ -32,6 +34,21 @@ struct icache_entry_t {
   insn_fetch_t data;
 };
 
+// A decoded basic block: the instructions from its tag up to the first one
+// that may change the control flow, and the blocks that followed it before.
+// Every instruction holds the PC of the next one in the block, or -1 for the
+// last. Blocks are only reused, never freed, so stale links are safe to
+// follow and are validated by their tag.
+struct icache_block_t {
+  static const size_t MAX_INSNS = 32;
+  reg_t tag;
+  struct icache_block_t* next[2];
+  struct {
+    insn_fetch_t fetch;
+    reg_t next_pc;
+  } insns[MAX_INSNS];
+};
+
 struct tlb_entry_t {
   char* host_offset;
   reg_t target_offset;
@@ -185,15 +202,37 @@ public:
         flush_tlb(); \
   }
 
-  // template for functions that perform an atomic memory operation
+  // template for functions that perform an atomic memory operation. AMOs to
+  // main memory are atomic with respect to harts running on other threads.
   #define amo_func(type) \
     template<typename op> \
     type##_t amo_##type(reg_t addr, op f) { \
       if (addr & (sizeof(type##_t)-1)) \
         throw trap_store_address_misaligned(addr, 0, 0); \
       try { \
-        auto lhs = load_##type(addr); \
-        store_##type(addr, f(lhs)); \
+        reg_t vpn = addr >> PGSHIFT; \
+        char* host_addr; \
+        if (likely(tlb_load_tag[vpn % TLB_ENTRIES] == vpn && \
+                   tlb_store_tag[vpn % TLB_ENTRIES] == vpn)) \
+          host_addr = tlb_data[vpn % TLB_ENTRIES].host_offset + addr; \
+        else \
+          host_addr = amo_slow_path(addr, sizeof(type##_t)); \
+        if (!host_addr) { \
+          auto lhs = load_##type(addr); \
+          store_##type(addr, f(lhs)); \
+          return lhs; \
+        } \
+        type##_t* ptr = (type##_t*)host_addr; \
+        type##_t old = __atomic_load_n(ptr, __ATOMIC_RELAXED), lhs, res; \
+        do { \
+          lhs = from_le(old); \
+          res = f(lhs); \
+        } while (!__atomic_compare_exchange_n(ptr, &old, to_le(res), true, \
+                                              __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)); \
+        if (proc) { \
+          READ_MEM(addr, sizeof(type##_t)); \
+          WRITE_MEM(addr, res, sizeof(type##_t)); \
+        } \
         return lhs; \
       } catch (trap_load_page_fault& t) { \
         /* AMO faults should be reported as store faults */ \
@@ -244,26 +283,50 @@ public:
     load_reservation_address = (reg_t)-1;
   }
 
-  inline void acquire_load_reservation(reg_t vaddr)
+  // The reservation remembers the value read by the LR
+  inline void acquire_load_reservation(reg_t vaddr, reg_t value)
   {
     reg_t paddr = translate(vaddr, 1, LOAD, 0);
     if (auto host_addr = sim->addr_to_mem(paddr))
       load_reservation_address = refill_tlb(vaddr, paddr, host_addr, LOAD).target_offset + vaddr;
     else
       throw trap_load_access_fault(vaddr, 0, 0); // disallow LR to I/O space
+    load_reservation_value = value;
   }
 
-  inline bool check_load_reservation(reg_t vaddr, size_t size)
-  {
-    if (vaddr & (size-1))
-      throw trap_store_address_misaligned(vaddr, 0, 0);
+  // template for functions that perform a store-conditional. The store
+  // succeeds if the reservation is held and the memory still holds the value
+  // read by the LR, compared and swapped atomically with respect to harts
+  // running on other threads.
+  #define store_conditional_func(type) \
+    bool store_conditional_##type(reg_t addr, type##_t val) { \
+      if (addr & (sizeof(type##_t)-1)) \
+        throw trap_store_address_misaligned(addr, 0, 0); \
+      reg_t paddr = translate(addr, 1, STORE, 0); \
+      char* host_addr = sim->addr_to_mem(paddr); \
+      if (!host_addr) \
+        throw trap_store_access_fault(addr, 0, 0); /* disallow SC to I/O space */ \
+      if (load_reservation_address != paddr) \
+        return false; \
+      if (!matched_trigger) { \
+        matched_trigger = trigger_exception(OPERATION_STORE, addr, val); \
+        if (matched_trigger) \
+          throw *matched_trigger; \
+      } \
+      type##_t expected = to_le((type##_t)load_reservation_value); \
+      if (!__atomic_compare_exchange_n((type##_t*)host_addr, &expected, to_le(val), false, \
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) \
+        return false; \
+      if (tracer.interested_in_range(paddr, paddr + PGSIZE, STORE)) \
+        tracer.trace(paddr, sizeof(type##_t), STORE); \
+      else \
+        refill_tlb(addr, paddr, host_addr, STORE); \
+      if (proc) WRITE_MEM(addr, val, sizeof(type##_t)); \
+      return true; \
+    }
 
-    reg_t paddr = translate(vaddr, 1, STORE, 0);
-    if (auto host_addr = sim->addr_to_mem(paddr))
-      return load_reservation_address == refill_tlb(vaddr, paddr, host_addr, STORE).target_offset + vaddr;
-    else
-      throw trap_store_access_fault(vaddr, 0, 0); // disallow SC to I/O space
-  }
+  store_conditional_func(uint32)
+  store_conditional_func(uint64)
 
   static const reg_t ICACHE_ENTRIES = 1024;
 
@@ -319,6 +382,30 @@ public:
     return refill_icache(addr, &entry)->data;
   }
 
+  // Basic blocks can be cached unless every fetch is traced or checked for
+  // triggers
+  bool block_cache_enabled() const { return !fetch_traced && !check_triggers_fetch; }
+
+  inline icache_block_t* access_block(reg_t addr)
+  {
+    auto it = block_map.find(addr);
+    if (likely(it != block_map.end() && it->second->tag == addr))
+      return it->second;
+    return refill_block(addr);
+  }
+
+  // The block at addr, which follows the given block
+  inline icache_block_t* next_block(icache_block_t* block, reg_t addr)
+  {
+    if (likely(block->next[0] && block->next[0]->tag == addr))
+      return block->next[0];
+    if (likely(block->next[1] && block->next[1]->tag == addr))
+      return block->next[1];
+    icache_block_t* next = access_block(addr);
+    block->next[block->next[0] && block->next[0]->tag != reg_t(-1)] = next;
+    return next;
+  }
+
   void flush_tlb();
   void flush_icache();
 
@@ -347,11 +434,21 @@ private:
   processor_t* proc;
   memtracer_list_t tracer;
   reg_t load_reservation_address;
+  reg_t load_reservation_value;
   uint16_t fetch_temp;
 
   // implement an instruction cache for simulator performance
   icache_entry_t icache[ICACHE_ENTRIES];
 
+  // and a cache of basic blocks, allocated in chunks up to MAX_BLOCKS
+  static const size_t BLOCK_CHUNK = 64;
+  static const size_t MAX_BLOCKS = 4096;
+  std::vector<std::unique_ptr<icache_block_t[]>> block_chunks;
+  std::unordered_map<reg_t, icache_block_t*> block_map;
+  size_t num_blocks;
+  bool fetch_traced;
+  icache_block_t* refill_block(reg_t addr);
+
   // implement a TLB for simulator performance
   static const reg_t TLB_ENTRIES = 256;
   // If a TLB tag has TLB_CHECK_TRIGGERS set, then the MMU must check for a
@@ -376,6 +473,7 @@ private:
   tlb_entry_t fetch_slow_path(reg_t addr);
   void load_slow_path(reg_t addr, reg_t len, uint8_t* bytes, uint32_t xlate_flags);
   void store_slow_path(reg_t addr, reg_t len, const uint8_t* bytes, uint32_t xlate_flags);
+  char* amo_slow_path(reg_t addr, reg_t len);
   bool mmio_load(reg_t addr, size_t len, uint8_t* bytes);
   bool mmio_store(reg_t addr, size_t len, const uint8_t* bytes);
   bool mmio_ok(reg_t addr, access_type type);
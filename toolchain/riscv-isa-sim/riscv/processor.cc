@@ -8,6 +8,7 @@
 #include "simif.h"
 #include "mmu.h"
 #include "disasm.h"
+#include "mempool_timing.h"
 #include <cinttypes>
 #include <cmath>
 #include <cstdlib>
@@ -26,7 +27,8 @@ processor_t::processor_t(const char* isa, const char* priv, const char* varch,
                          FILE* log_file)
   : debug(false), halt_request(HR_NONE), sim(sim), ext(NULL), id(id), xlen(0),
   histogram_enabled(false), log_commits_enabled(false),
-  log_file(log_file), halt_on_reset(halt_on_reset),
+  log_file(log_file), commit_log(NULL), halt_on_reset(halt_on_reset), wfi_sleep(false),
+  wfi_state(0), unhandled_trap(false), timing(NULL), profiler(NULL), perf(NULL),
   extension_table(256, false), last_pc(1), executions(1)
 {
   VU.p = this;
@@ -308,6 +310,8 @@ void state_t::reset(reg_t max_isa)
   mtvec = 0;
   mcause = 0;
   minstret = 0;
+  trace = 0;
+  stacklimit = 0;
   mie = 0;
   mip = 0;
   medeleg = 0;
@@ -445,6 +449,37 @@ void processor_t::enable_log_commits()
 }
 #endif
 
+// Snitch counts at most 7 outstanding wake-ups
+static const int MAX_WAKE_UPS_PENDING = 7;
+
+bool processor_t::enter_wfi()
+{
+  if (!wfi_sleep)
+    return true;
+  int state = wfi_state.load(std::memory_order_relaxed);
+  do {
+    if (state < 0)
+      return true;
+  } while (!wfi_state.compare_exchange_weak(state, state ? state - 1 : -1,
+                                            std::memory_order_acq_rel));
+  // Sleep unless a wake-up was pending
+  if (state == 0 && timing)
+    timing->sleep();
+  return state == 0;
+}
+
+void processor_t::wake_up()
+{
+  if (timing)
+    timing->wake_up();
+  int state = wfi_state.load(std::memory_order_relaxed);
+  do {
+    if (state == MAX_WAKE_UPS_PENDING)
+      return;
+  } while (!wfi_state.compare_exchange_weak(state, state < 0 ? 0 : state + 1,
+                                            std::memory_order_acq_rel));
+}
+
 void processor_t::reset()
 {
   state.reset(max_isa);
@@ -719,6 +754,15 @@ void processor_t::take_trap(trap_t& t, reg_t epc)
     set_privilege(PRV_S);
   } else {
     // Handle the trap in M-mode
+    // MemPool's runtime installs no trap handler, so stop the hart instead
+    // of executing from address zero
+    if (wfi_sleep && state.mtvec == 0) {
+      fprintf(stderr, "core %3d: %s at pc 0x%08" PRIx64 " (tval 0x%08" PRIx64
+              ") without a trap handler.\n", id, t.name(), zext_xlen(epc),
+              zext_xlen(t.get_tval()));
+      unhandled_trap = true;
+      return;
+    }
     set_virt(false);
     reg_t vector = (state.mtvec & 1) && interrupt ? 4*bit : 0;
     state.pc = (state.mtvec & ~(reg_t)1) + vector;
@@ -934,6 +978,14 @@ void processor_t::set_csr(int which, reg_t val)
       state.minstret = (val << 32) | (state.minstret << 32 >> 32);
       state.minstret--; // See comment above.
       break;
+    case CSR_TRACE:
+      state.trace = val & 1;
+      if (timing)
+        timing->set_trace(state.trace);
+      break;
+    case CSR_STACKLIMIT:
+      state.stacklimit = val;
+      break;
     case CSR_SCOUNTEREN:
       state.scounteren = val;
       break;
@@ -1383,7 +1435,7 @@ reg_t processor_t::get_csr(int which, insn_t insn, bool write, bool peek)
     case CSR_INSTRET:
     case CSR_CYCLE:
       if (ctr_ok)
-        ret(state.minstret);
+        ret(which == CSR_CYCLE && timing ? timing->get_cycle() : state.minstret);
       if (state.v &&
           ((state.mcounteren >> (which & 31)) & 1) &&
           !((state.hcounteren >> (which & 31)) & 1)) {
@@ -1391,12 +1443,13 @@ reg_t processor_t::get_csr(int which, insn_t insn, bool write, bool peek)
       }
       break;
     case CSR_MINSTRET:
-    case CSR_MCYCLE:
       ret(state.minstret);
+    case CSR_MCYCLE:
+      ret(timing ? timing->get_cycle() : state.minstret);
     case CSR_INSTRETH:
     case CSR_CYCLEH:
       if (ctr_ok && xlen == 32)
-        ret(state.minstret >> 32);
+        ret((which == CSR_CYCLEH && timing ? timing->get_cycle() : state.minstret) >> 32);
       if (state.v &&
           ((state.mcounteren >> (which & 31)) & 1) &&
           !((state.hcounteren >> (which & 31)) & 1)) {
@@ -1404,10 +1457,17 @@ reg_t processor_t::get_csr(int which, insn_t insn, bool write, bool peek)
       }
       break;
     case CSR_MINSTRETH:
-    case CSR_MCYCLEH:
       if (xlen == 32)
         ret(state.minstret >> 32);
       break;
+    case CSR_MCYCLEH:
+      if (xlen == 32)
+        ret((timing ? timing->get_cycle() : state.minstret) >> 32);
+      break;
+    case CSR_TRACE:
+      ret(state.trace);
+    case CSR_STACKLIMIT:
+      ret(state.stacklimit);
     case CSR_SCOUNTEREN: ret(state.scounteren);
     case CSR_MCOUNTEREN:
       if (!supports_extension('U'))
@@ -11,6 +11,7 @@
 #include <unordered_map>
 #include <map>
 #include <cassert>
+#include <atomic>
 #include "debug_rom_defines.h"
 
 class processor_t;
@@ -20,6 +21,10 @@ class simif_t;
 class trap_t;
 class extension_t;
 class disassembler_t;
+class mempool_timing_t;
+class hart_profiler_t;
+class mempool_perf_t;
+class commit_log_writer_t;
 
 struct insn_desc_t
 {
@@ -169,6 +174,8 @@ struct state_t
   reg_t mtvec;
   reg_t mcause;
   reg_t minstret;
+  reg_t trace;
+  reg_t stacklimit;
   reg_t mie;
   reg_t mip;
   reg_t medeleg;
@@ -305,6 +312,9 @@ public:
   const disassembler_t* get_disassembler() { return disassembler; }
 
   FILE *get_log_file() { return log_file; }
+  // Write the commit log in the binary format instead of the log file
+  void set_commit_log(commit_log_writer_t* value) { commit_log = value; }
+  commit_log_writer_t* get_commit_log() { return commit_log; }
 
   void register_insn(insn_desc_t);
   void register_extension(extension_t*);
@@ -318,6 +328,22 @@ public:
   // When true, take the slow simulation path.
   bool slow_path();
   bool halted() { return state.debug_mode; }
+  // MemPool's cores sleep in wfi until they are woken up through a control
+  // register. Wake-ups that arrive while a core is awake are counted and let
+  // as many later wfi instructions fall through. Other harts may wake a core
+  // up concurrently.
+  void set_wfi_sleep(bool value) { wfi_sleep = value; }
+  bool sleeping() const { return wfi_state.load(std::memory_order_acquire) < 0; }
+  bool enter_wfi();
+  void wake_up();
+  // In MemPool mode, a trap without a handler stops the hart
+  bool trapped() const { return unhandled_trap; }
+  // Estimate the cycles of the executed instructions, which mcycle returns
+  void set_timing(mempool_timing_t* value) { timing = value; }
+  // Sample the call stack every few instructions
+  void set_profiler(hart_profiler_t* value) { profiler = value; }
+  hart_profiler_t* get_profiler() { return profiler; }
+  void set_perf(mempool_perf_t* value) { perf = value; }
   enum {
     HR_NONE,    /* Halt request is inactive. */
     HR_REGULAR, /* Regular halt request/debug interrupt. */
@@ -425,7 +451,14 @@ private:
   bool histogram_enabled;
   bool log_commits_enabled;
   FILE *log_file;
+  commit_log_writer_t* commit_log;
   bool halt_on_reset;
+  bool wfi_sleep;
+  std::atomic<int> wfi_state; // -1: sleeping, otherwise pending wake-ups
+  bool unhandled_trap;
+  mempool_timing_t* timing;
+  hart_profiler_t* profiler;
+  mempool_perf_t* perf;
   std::vector<bool> extension_table;
   
 
@@ -435,6 +468,7 @@ private:
   static const size_t OPCODE_CACHE_SIZE = 8191;
   insn_desc_t opcode_cache[OPCODE_CACHE_SIZE];
 
+  void execute(size_t n); // run for up to n instructions
   void take_pending_interrupt() { take_interrupt(state.mip & state.mie); }
   void take_interrupt(reg_t mask); // take first enabled interrupt in mask
   void take_trap(trap_t& t, reg_t epc); // take an exception
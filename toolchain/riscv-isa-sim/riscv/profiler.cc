@@ -0,0 +1,67 @@
+// See LICENSE for license details.
+
+#include "profiler.h"
+#include "mempool_timing.h"
+#include <cinttypes>
+#include <cstdio>
+
+hart_profiler_t::hart_profiler_t(size_t interval,
+                                 std::function<const char*(reg_t)> symbolize)
+  : interval(interval), countdown(interval), symbolize(symbolize), timing(NULL),
+    last_cycle(0), lost(0)
+{
+}
+
+void hart_profiler_t::sample(reg_t pc)
+{
+  // A return address lies behind its call, in the caller
+  stack_t stack;
+  stack.reserve(ras.size() + 1);
+  for (reg_t link : ras)
+    stack.push_back(symbolize(link - 1));
+  stack.push_back(symbolize(pc));
+
+  uint64_t weight = interval;
+  if (timing) {
+    weight = timing->get_cycle() - last_cycle;
+    last_cycle = timing->get_cycle();
+  }
+  samples[stack] += weight;
+}
+
+profiler_t::profiler_t(size_t num_harts, size_t interval,
+                       std::function<const char*(reg_t)> symbolize)
+{
+  for (size_t i = 0; i < num_harts; i++)
+    harts.emplace_back(new hart_profiler_t(interval, symbolize));
+}
+
+static bool print_folded(const std::string& path,
+                         const std::map<hart_profiler_t::stack_t, uint64_t>& samples)
+{
+  FILE* out = fopen(path.c_str(), "w");
+  if (!out) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+  for (auto& s : samples) {
+    for (size_t i = 0; i < s.first.size(); i++)
+      fprintf(out, "%s%s", i ? ";" : "", s.first[i] ? s.first[i] : "?");
+    fprintf(out, " %" PRIu64 "\n", s.second);
+  }
+  fclose(out);
+  return true;
+}
+
+bool profiler_t::print(const std::string& prefix) const
+{
+  std::map<hart_profiler_t::stack_t, uint64_t> all;
+  for (size_t i = 0; i < harts.size(); i++) {
+    const auto& samples = harts[i]->get_samples();
+    if (!print_folded(prefix + "_hart" + std::to_string(i) + ".folded", samples))
+      return false;
+    for (auto& s : samples)
+      all[s.first] += s.second;
+  }
+  return print_folded(prefix + ".folded", all);
+}
@@ -0,0 +1,98 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_PROFILER_H
+#define _RISCV_PROFILER_H
+
+#include "decode.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class mempool_timing_t;
+
+// Call stacks of one hart, sampled every interval instructions. The stack is
+// kept in a return-address stack, which follows the calls and returns of the
+// hart by the link-register hints of jal and jalr. Samples are symbolized
+// when they are taken, so that they can be counted per stack of symbols.
+class hart_profiler_t
+{
+ public:
+  hart_profiler_t(size_t interval, std::function<const char*(reg_t)> symbolize);
+
+  // Weigh the samples with the cycles since the last sample instead of the
+  // instructions
+  void set_timing(mempool_timing_t* timing) { this->timing = timing; }
+
+  // Instructions until the next sample
+  size_t until_sample() const { return countdown; }
+
+  // The hart retired insns instructions and will next execute pc
+  void retire(reg_t pc, size_t insns)
+  {
+    if (insns < countdown) {
+      countdown -= insns;
+    } else {
+      sample(pc);
+      countdown = interval;
+    }
+  }
+
+  // A jump that writes link to rd (0 if it links nothing) and jumps to rs1
+  // (0 for a jal)
+  void jump(unsigned rd, unsigned rs1, reg_t link)
+  {
+    bool rd_link = rd == 1 || rd == 5;
+    bool rs1_link = rs1 == 1 || rs1 == 5;
+    if (rs1_link && (!rd_link || rd != rs1)) {
+      if (lost)
+        lost--;
+      else if (!ras.empty())
+        ras.pop_back();
+    }
+    if (rd_link) {
+      if (ras.size() < MAX_DEPTH)
+        ras.push_back(link);
+      else
+        lost++;
+    }
+  }
+
+  // Symbols of the callers and of the sampled PC, nullptr if unknown
+  typedef std::vector<const char*> stack_t;
+  const std::map<stack_t, uint64_t>& get_samples() const { return samples; }
+
+ private:
+  static const size_t MAX_DEPTH = 256;
+
+  void sample(reg_t pc);
+
+  size_t interval;
+  size_t countdown;
+  std::function<const char*(reg_t)> symbolize;
+  mempool_timing_t* timing;
+  uint64_t last_cycle;
+  std::vector<reg_t> ras;
+  size_t lost; // calls beyond MAX_DEPTH
+  std::map<stack_t, uint64_t> samples; // weight per stack
+};
+
+// Profiles of all harts, written as folded stacks for flame graphs
+class profiler_t
+{
+ public:
+  profiler_t(size_t num_harts, size_t interval,
+             std::function<const char*(reg_t)> symbolize);
+
+  hart_profiler_t* get_hart(size_t i) { return harts.at(i).get(); }
+
+  // Write <prefix>_hart<i>.folded per hart and <prefix>.folded for all harts,
+  // one "caller;...;callee weight" line per stack
+  bool print(const std::string& prefix) const;
+
+ private:
+  std::vector<std::unique_ptr<hart_profiler_t>> harts;
+};
+
+#endif
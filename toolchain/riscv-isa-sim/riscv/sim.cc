@@ -9,6 +9,7 @@
 #include <map>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <climits>
 #include <cstdlib>
 #include <cassert>
@@ -35,7 +36,8 @@ sim_t::sim_t(const char* isa, const char* priv, const char* varch,
              std::vector<int> const hartids,
              const debug_module_config_t &dm_config,
              const char *log_path,
-             bool dtb_enabled, const char *dtb_file)
+             bool dtb_enabled, const char *dtb_file,
+             const mempool_cfg_t* mempool_cfg)
   : htif_t(args),
     mems(mems),
     plugin_devices(plugin_devices),
@@ -47,8 +49,10 @@ sim_t::sim_t(const char* isa, const char* priv, const char* varch,
     dtb_file(dtb_file ? dtb_file : ""),
     dtb_enabled(dtb_enabled),
     log_file(log_path),
+    interleave(INTERLEAVE),
     current_step(0),
     current_proc(0),
+    num_threads(1),
     debug(false),
     histogram_enabled(false),
     log(false),
@@ -57,13 +61,18 @@ sim_t::sim_t(const char* isa, const char* priv, const char* varch,
 {
   signal(SIGINT, &handle_signal);
 
+  if (mempool_cfg)
+    mempool.reset(new mempool_cfg_t(*mempool_cfg));
+
   for (auto& x : mems)
     bus.add_device(x.first, x.second);
 
   for (auto& x : plugin_devices)
     bus.add_device(x.first, x.second);
 
-  debug_module.add_device(&bus);
+  // MemPool's L1 starts at address zero, where the debug module would be
+  if (!mempool)
+    debug_module.add_device(&bus);
 
   debug_mmu = new mmu_t(this, NULL);
 
@@ -81,9 +90,14 @@ sim_t::sim_t(const char* isa, const char* priv, const char* varch,
                                log_file.get());
   }
 
+  clint.reset(new clint_t(procs, CPU_HZ / INSNS_PER_RTC_TICK, real_time_clint));
+  if (mempool) {
+    make_mempool();
+    return;
+  }
+
   make_dtb();
 
-  clint.reset(new clint_t(procs, CPU_HZ / INSNS_PER_RTC_TICK, real_time_clint));
   reg_t clint_base;
   if (fdt_parse_clint((void *)dtb.c_str(), &clint_base, "riscv,clint0")) {
     bus.add_device(CLINT_BASE, clint.get());
@@ -118,12 +132,17 @@ void sim_t::main()
   if (!debug && log)
     set_procs_debug(true);
 
+  if (num_threads > 1)
+    workers.reset(new worker_pool_t(std::min(num_threads, procs.size())));
+
   while (!done())
   {
     if (debug || ctrlc_pressed)
       interactive();
+    else if (workers)
+      step_parallel();
     else
-      step(INTERLEAVE);
+      step(interleave);
     if (remote_bitbang) {
       remote_bitbang->tick();
     }
@@ -134,24 +153,116 @@ int sim_t::run()
 {
   host = context_t::current();
   target.init(sim_thread_main, this);
-  return htif_t::run();
+  int exit_code = htif_t::run();
+
+  if (!mempool_timing.empty()) {
+    FILE* out = fopen(mempool_timing_path.c_str(), "w");
+    if (!out) {
+      fprintf(stderr, "could not open %s\n", mempool_timing_path.c_str());
+      return exit_code;
+    }
+    mempool_timing_t::print_header(out);
+    for (auto& t : mempool_timing)
+      t->print(out);
+    fclose(out);
+  }
+  if (!mempool_perf.empty()) {
+    FILE* out = fopen(mempool_perf_path.c_str(), "w");
+    if (!out) {
+      fprintf(stderr, "could not open %s\n", mempool_perf_path.c_str());
+      return exit_code;
+    }
+    mempool_perf_t::print_header(out);
+    for (auto& p : mempool_perf)
+      p->print(out);
+    fclose(out);
+  }
+  if (mempool_tcdm) {
+    mempool_tcdm->end_quantum();
+    mempool_tcdm->print(mempool_tcdm_prefix,
+                        [this](reg_t pc) { return symbolize(pc); });
+  }
+  if (mempool_icache)
+    mempool_icache->print(mempool_icache_prefix,
+                          [this](reg_t pc) { return symbolize(pc); });
+  if (profiler)
+    profiler->print(profiler_prefix);
+  return exit_code;
+}
+
+const char* sim_t::symbolize(reg_t pc)
+{
+  // The PCs of RV32 harts are sign-extended, their symbols are not
+  unsigned xlen = procs[0]->get_max_xlen();
+  return get_enclosing_symbol(zext_xlen(pc));
+}
+
+void sim_t::set_mempool_timing(const char* path)
+{
+  mempool_timing_path = path;
+  mempool_banks.reset(new mempool_bank_table_t(mempool->num_banks()));
+  for (size_t i = 0; i < procs.size(); i++) {
+    mempool_timing.emplace_back(new mempool_timing_t(*mempool, *mempool_banks, i));
+    procs[i]->set_timing(mempool_timing.back().get());
+    procs[i]->get_mmu()->register_memtracer(mempool_timing.back().get());
+  }
+}
+
+void sim_t::set_perf_counters(const char* path)
+{
+  mempool_perf_path = path;
+  for (size_t i = 0; i < procs.size(); i++) {
+    mempool_perf.emplace_back(new mempool_perf_t(*mempool, i));
+    if (i < mempool_timing.size())
+      mempool_perf.back()->set_timing(mempool_timing[i].get());
+    procs[i]->set_perf(mempool_perf.back().get());
+    procs[i]->get_mmu()->register_memtracer(mempool_perf.back().get());
+  }
+}
+
+void sim_t::set_tcdm_model(const char* prefix)
+{
+  mempool_tcdm_prefix = prefix;
+  mempool_tcdm.reset(new mempool_tcdm_t(*mempool, procs));
+}
+
+void sim_t::set_icache_model(const char* prefix)
+{
+  mempool_icache_prefix = prefix;
+  mempool_icache.reset(new mempool_icache_t(*mempool, procs,
+                                            [this](reg_t addr) { return addr_to_mem(addr); }));
+  for (size_t i = 0; i < mempool_timing.size(); i++)
+    mempool_icache->set_timing(i, mempool_timing[i].get());
+}
+
+void sim_t::set_profiler(const char* prefix, size_t interval)
+{
+  profiler_prefix = prefix;
+  // The symbols are loaded before the harts start and never change
+  profiler.reset(new profiler_t(procs.size(), interval,
+                                [this](reg_t pc) { return symbolize(pc); }));
+  for (size_t i = 0; i < procs.size(); i++) {
+    procs[i]->set_profiler(profiler->get_hart(i));
+    if (i < mempool_timing.size())
+      profiler->get_hart(i)->set_timing(mempool_timing[i].get());
+  }
 }
 
 void sim_t::step(size_t n)
 {
   for (size_t i = 0, steps = 0; i < n; i += steps)
   {
-    steps = std::min(n - i, INTERLEAVE - current_step);
+    steps = std::min(n - i, interleave - current_step);
     procs[current_proc]->step(steps);
 
     current_step += steps;
-    if (current_step == INTERLEAVE)
+    if (current_step == interleave)
     {
       current_step = 0;
       procs[current_proc]->get_mmu()->yield_load_reservation();
       if (++current_proc == procs.size()) {
         current_proc = 0;
-        clint->increment(INTERLEAVE / INSNS_PER_RTC_TICK);
+        end_round();
       }
 
       host->switch_to();
@@ -159,6 +270,42 @@ void sim_t::step(size_t n)
   }
 }
 
+void sim_t::step_parallel()
+{
+  // Every worker steps a fixed, contiguous range of harts. The harts of
+  // different workers only interact through memory, host atomics make their
+  // AMOs and LR/SC atomic, and the devices are locked.
+  workers->run([this](size_t w) {
+    size_t first = w * procs.size() / workers->size();
+    size_t last = (w + 1) * procs.size() / workers->size();
+    for (size_t i = first; i < last; i++) {
+      procs[i]->step(interleave);
+      procs[i]->get_mmu()->yield_load_reservation();
+    }
+  });
+  end_round();
+  host->switch_to();
+}
+
+void sim_t::end_round()
+{
+  clint->increment(interleave / INSNS_PER_RTC_TICK);
+  if (mempool_tcdm)
+    mempool_tcdm->end_quantum();
+  // Once all of MemPool's cores sleep, none can wake the others up
+  if (mempool && !mempool_ctrl->eoc_valid() &&
+      std::all_of(procs.begin(), procs.end(),
+                  [](processor_t* p) { return p->sleeping(); })) {
+    fprintf(stderr, "All %zu cores sleep in wfi without a pending wake-up.\n",
+            procs.size());
+    set_exit_code(-1);
+  }
+  // The cores report traps without a handler themselves
+  if (mempool && std::any_of(procs.begin(), procs.end(),
+                             [](processor_t* p) { return p->trapped(); }))
+    set_exit_code(-1);
+}
+
 void sim_t::set_debug(bool value)
 {
   debug = value;
@@ -192,6 +339,15 @@ void sim_t::configure_log(bool enable_log, bool enable_commitlog)
 #endif
 }
 
+void sim_t::set_commit_log(const char* path, commit_log_codec_t codec)
+{
+  commit_log.reset(new commit_log_file_t(path, codec));
+  for (processor_t *proc : procs) {
+    commit_log_writers.emplace_back(new commit_log_writer_t(*commit_log, proc->get_csr(CSR_MHARTID)));
+    proc->set_commit_log(commit_log_writers.back().get());
+  }
+}
+
 void sim_t::set_procs_debug(bool value)
 {
   for (size_t i=0; i< procs.size(); i++)
@@ -207,6 +363,7 @@ bool sim_t::mmio_load(reg_t addr, size_t len, uint8_t* bytes)
 {
   if (addr + len < addr || !paddr_ok(addr + len - 1))
     return false;
+  std::lock_guard<std::mutex> lock(mmio_mutex);
   return bus.load(addr, len, bytes);
 }
 
@@ -214,6 +371,7 @@ bool sim_t::mmio_store(reg_t addr, size_t len, const uint8_t* bytes)
 {
   if (addr + len < addr || !paddr_ok(addr + len - 1))
     return false;
+  std::lock_guard<std::mutex> lock(mmio_mutex);
   return bus.store(addr, len, bytes);
 }
 
@@ -284,6 +442,28 @@ void sim_t::set_rom()
   bus.add_device(DEFAULT_RSTVEC, boot_rom.get());
 }
 
+void sim_t::make_mempool()
+{
+  mempool_ctrl.reset(new mempool_ctrl_t(*mempool, procs,
+                                        [this](reg_t eoc) { mempool_eoc(eoc); }));
+  mempool_uart.reset(new mempool_uart_t());
+  boot_rom.reset(new rom_device_t(mempool_bootrom(*mempool)));
+  bus.add_device(MEMPOOL_CTRL_BASE, mempool_ctrl.get());
+  bus.add_device(MEMPOOL_UART_BASE, mempool_uart.get());
+  bus.add_device(mempool->boot_addr, boot_rom.get());
+
+  for (auto& proc : procs)
+    proc->set_wfi_sleep(true);
+}
+
+void sim_t::mempool_eoc(reg_t eoc)
+{
+  int retval = int32_t(eoc) >> 1;
+  fflush(stdout);
+  fprintf(stderr, "[EOC] Simulation ended (retval = %d).\n", retval);
+  set_exit_code(retval);
+}
+
 char* sim_t::addr_to_mem(reg_t addr) {
   if (!paddr_ok(addr))
     return NULL;
@@ -303,6 +483,15 @@ const char* sim_t::get_symbol(uint64_t addr)
 
 void sim_t::reset()
 {
+  // MemPool's cores start at the entry point, as if the testbench woke them
+  // up in the boot ROM
+  if (mempool) {
+    reg_t pc = start_pc == reg_t(-1) ? get_entry_point() : start_pc;
+    for (auto& proc : procs)
+      proc->get_state()->pc = pc;
+    return;
+  }
+
   if (dtb_enabled)
     set_rom();
 }
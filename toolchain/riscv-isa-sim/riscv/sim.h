@@ -3,17 +3,26 @@
 #ifndef _RISCV_SIM_H
 #define _RISCV_SIM_H
 
+#include "commit_log.h"
 #include "debug_module.h"
 #include "devices.h"
 #include "log_file.h"
+#include "mempool.h"
+#include "mempool_icache.h"
+#include "mempool_perf.h"
+#include "mempool_tcdm.h"
+#include "mempool_timing.h"
 #include "processor.h"
+#include "profiler.h"
 #include "simif.h"
+#include "worker_pool.h"
 
 #include <fesvr/htif.h>
 #include <fesvr/context.h>
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <sys/types.h>
 
 class mmu_t;
@@ -30,7 +39,8 @@ public:
         std::vector<std::pair<reg_t, abstract_device_t*>> plugin_devices,
         const std::vector<std::string>& args, const std::vector<int> hartids,
         const debug_module_config_t &dm_config, const char *log_path,
-        bool dtb_enabled, const char *dtb_file);
+        bool dtb_enabled, const char *dtb_file,
+        const mempool_cfg_t* mempool_cfg);
   ~sim_t();
 
   // run the simulation to completion
@@ -38,6 +48,29 @@ public:
   void set_debug(bool value);
   void set_histogram(bool value);
 
+  // Run the harts on num_threads host threads, which advance all of their
+  // harts by one quantum of instructions and then wait for each other
+  void set_threads(size_t value) { num_threads = value; }
+  void set_quantum(size_t value) { interleave = value; }
+
+  // Estimate the cycles of MemPool's cores and write them per section between
+  // writes to the trace CSR to a CSV file
+  void set_mempool_timing(const char* path);
+  // Count the instructions, accesses and stalls of MemPool's cores and write
+  // them per section between accesses to the trace and mcycle CSRs to a CSV
+  // file with the columns of gen_trace.py
+  void set_perf_counters(const char* path);
+  // Collect the accesses of MemPool's cores to the L1 banks and write them per
+  // bank and per code region to <prefix>_banks.csv and <prefix>_regions.csv
+  void set_tcdm_model(const char* prefix);
+  // Simulate the instruction caches of MemPool's tiles and write their
+  // statistics to <prefix>_tiles.csv and their misses to <prefix>_symbols.csv
+  void set_icache_model(const char* prefix);
+  // Sample the call stack of every hart every interval instructions and write
+  // folded stacks for flame graphs to <prefix>_hart<i>.folded and
+  // <prefix>.folded, weighted with the estimated cycles if they are estimated
+  void set_profiler(const char* prefix, size_t interval);
+
   // Configure logging
   //
   // If enable_log is true, an instruction trace will be generated. If
@@ -45,6 +78,9 @@ public:
   // build was configured without support for commit logging, the
   // function will print an error message and abort).
   void configure_log(bool enable_log, bool enable_commitlog);
+  // Write the commit results to a binary log (commit_log.h) instead, with
+  // a buffer per hart and compressed with the codec
+  void set_commit_log(const char* path, commit_log_codec_t codec);
 
   void set_procs_debug(bool value);
   void set_remote_bitbang(remote_bitbang_t* remote_bitbang) {
@@ -72,16 +108,40 @@ private:
   bool dtb_enabled;
   std::unique_ptr<rom_device_t> boot_rom;
   std::unique_ptr<clint_t> clint;
+  // MemPool platform, without device tree and debug module
+  std::unique_ptr<mempool_cfg_t> mempool;
+  std::unique_ptr<mempool_ctrl_t> mempool_ctrl;
+  std::unique_ptr<mempool_uart_t> mempool_uart;
+  std::unique_ptr<mempool_bank_table_t> mempool_banks;
+  std::vector<std::unique_ptr<mempool_timing_t>> mempool_timing;
+  std::string mempool_timing_path;
+  std::vector<std::unique_ptr<mempool_perf_t>> mempool_perf;
+  std::string mempool_perf_path;
+  std::unique_ptr<mempool_tcdm_t> mempool_tcdm;
+  std::string mempool_tcdm_prefix;
+  std::unique_ptr<mempool_icache_t> mempool_icache;
+  std::string mempool_icache_prefix;
+  std::unique_ptr<profiler_t> profiler;
+  std::string profiler_prefix;
   bus_t bus;
   log_file_t log_file;
+  std::unique_ptr<commit_log_file_t> commit_log;
+  std::vector<std::unique_ptr<commit_log_writer_t>> commit_log_writers;
 
   processor_t* get_core(const std::string& i);
+  const char* symbolize(reg_t pc); // symbol enclosing a PC of the harts
   void step(size_t n); // step through simulation
+  void step_parallel(); // step all harts by one quantum on the worker pool
+  void end_round(); // all harts have run one quantum
   static const size_t INTERLEAVE = 5000;
   static const size_t INSNS_PER_RTC_TICK = 100; // 10 MHz clock for 1 BIPS core
   static const size_t CPU_HZ = 1000000000; // 1GHz CPU
+  size_t interleave;
   size_t current_step;
   size_t current_proc;
+  size_t num_threads;
+  std::unique_ptr<worker_pool_t> workers;
+  std::mutex mmio_mutex;
   bool debug;
   bool histogram_enabled; // provide a histogram of PCs
   bool log;
@@ -93,6 +153,8 @@ private:
   bool mmio_store(reg_t addr, size_t len, const uint8_t* bytes);
   void make_dtb();
   void set_rom();
+  void make_mempool();
+  void mempool_eoc(reg_t eoc);
 
   const char* get_symbol(uint64_t addr);
 
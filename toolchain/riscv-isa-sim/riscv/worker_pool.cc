@@ -0,0 +1,60 @@
+// See LICENSE for license details.
+
+#include "worker_pool.h"
+
+worker_pool_t::worker_pool_t(size_t num_workers)
+  : job(NULL), generation(0), running(0), stop(false)
+{
+  for (size_t w = 1; w < num_workers; w++)
+    threads.emplace_back(&worker_pool_t::worker, this, w);
+}
+
+worker_pool_t::~worker_pool_t()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  start.notify_all();
+  for (auto& t : threads)
+    t.join();
+}
+
+void worker_pool_t::run(const std::function<void(size_t)>& job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->job = &job;
+    running = threads.size();
+    generation++;
+  }
+  start.notify_all();
+
+  job(0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [&]{ return running == 0; });
+  this->job = NULL;
+}
+
+void worker_pool_t::worker(size_t w)
+{
+  uint64_t seen = 0;
+  while (true) {
+    const std::function<void(size_t)>* job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      start.wait(lock, [&]{ return stop || generation != seen; });
+      if (stop)
+        return;
+      seen = generation;
+      job = this->job;
+    }
+
+    (*job)(w);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--running == 0)
+      done.notify_one();
+  }
+}
@@ -0,0 +1,41 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_WORKER_POOL_H
+#define _RISCV_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of host threads that run the same job, e.g., one quantum of
+// their share of the harts, and wait for each other at its end.
+class worker_pool_t
+{
+ public:
+  // Start num_workers - 1 threads, the calling thread is worker 0
+  worker_pool_t(size_t num_workers);
+  ~worker_pool_t();
+
+  size_t size() const { return threads.size() + 1; }
+
+  // Run job(w) on every worker w and return once all of them are done
+  void run(const std::function<void(size_t)>& job);
+
+ private:
+  void worker(size_t w);
+
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable start;
+  std::condition_variable done;
+  const std::function<void(size_t)>* job;
+  uint64_t generation;
+  size_t running;
+  bool stop;
+};
+
+#endif
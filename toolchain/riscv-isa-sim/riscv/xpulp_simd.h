@@ -0,0 +1,202 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_XPULP_SIMD_H
+#define _RISCV_XPULP_SIMD_H
+
+#include <cstdint>
+#include <cstring>
+
+// Packed-SIMD operations of Xpulpimg on the four bytes or two halves of a
+// 32-bit register. The lanes are mapped onto the host's vector types, so that
+// the compiler emits host SIMD (SSE, NEON) or SWAR code instead of a loop over
+// the lanes. Lane-wise operations do not depend on the order of the lanes in
+// the host vector, so they work on hosts of either endianness.
+// All arithmetic wraps around in its lane, as in the Snitch IPU.
+
+typedef int8_t simd_v4i8 __attribute__((vector_size(4)));
+typedef uint8_t simd_v4u8 __attribute__((vector_size(4)));
+typedef int16_t simd_v2i16 __attribute__((vector_size(4)));
+typedef uint16_t simd_v2u16 __attribute__((vector_size(4)));
+
+template <typename V>
+static inline V simd_vec(uint32_t x)
+{
+  V v;
+  memcpy(&v, &x, sizeof(v));
+  return v;
+}
+
+template <typename V>
+static inline uint32_t simd_reg(V v)
+{
+  uint32_t x;
+  memcpy(&x, &v, sizeof(x));
+  return x;
+}
+
+// The lowest byte or half of x in every lane
+static inline uint32_t simd_splat_b(uint32_t x) { return (x & 0xFF) * 0x01010101; }
+static inline uint32_t simd_splat_h(uint32_t x) { return (x & 0xFFFF) * 0x00010001; }
+
+#define SIMD_DEFINE_LANEWISE(name, expr) \
+  static inline uint32_t simd_##name##_b(uint32_t rs1, uint32_t rs2) \
+  { \
+    typedef simd_v4i8 vs_t; \
+    typedef simd_v4u8 vu_t; \
+    vs_t as = simd_vec<vs_t>(rs1), bs = simd_vec<vs_t>(rs2); \
+    vu_t au = simd_vec<vu_t>(rs1), bu = simd_vec<vu_t>(rs2); \
+    (void)as; (void)bs; (void)au; (void)bu; \
+    return simd_reg(expr); \
+  } \
+  static inline uint32_t simd_##name##_h(uint32_t rs1, uint32_t rs2) \
+  { \
+    typedef simd_v2i16 vs_t; \
+    typedef simd_v2u16 vu_t; \
+    vs_t as = simd_vec<vs_t>(rs1), bs = simd_vec<vs_t>(rs2); \
+    vu_t au = simd_vec<vu_t>(rs1), bu = simd_vec<vu_t>(rs2); \
+    (void)as; (void)bs; (void)au; (void)bu; \
+    return simd_reg(expr); \
+  }
+
+// Comparisons yield all ones in the lanes where they hold
+#define SIMD_SELECT(mask, a, b) (((a) & (vu_t)(mask)) | ((b) & ~(vu_t)(mask)))
+
+SIMD_DEFINE_LANEWISE(add, au + bu)
+SIMD_DEFINE_LANEWISE(sub, au - bu)
+// The sum wraps around before it is halved
+SIMD_DEFINE_LANEWISE(avg, (vs_t)(au + bu) >> 1)
+SIMD_DEFINE_LANEWISE(avgu, (vu_t)(au + bu) >> 1)
+SIMD_DEFINE_LANEWISE(max, SIMD_SELECT(as > bs, au, bu))
+SIMD_DEFINE_LANEWISE(maxu, SIMD_SELECT(au > bu, au, bu))
+SIMD_DEFINE_LANEWISE(min, SIMD_SELECT(as <= bs, au, bu))
+SIMD_DEFINE_LANEWISE(minu, SIMD_SELECT(au <= bu, au, bu))
+// Shift amounts are taken modulo the width of the lanes
+SIMD_DEFINE_LANEWISE(sll, au << (bu & (sizeof(au[0]) * 8 - 1)))
+SIMD_DEFINE_LANEWISE(srl, au >> (bu & (sizeof(au[0]) * 8 - 1)))
+SIMD_DEFINE_LANEWISE(sra, as >> (vs_t)(bu & (sizeof(au[0]) * 8 - 1)))
+
+#undef SIMD_SELECT
+#undef SIMD_DEFINE_LANEWISE
+
+static inline uint32_t simd_abs_b(uint32_t rs1)
+{
+  simd_v4u8 a = simd_vec<simd_v4u8>(rs1);
+  simd_v4u8 neg = (simd_v4u8)(simd_vec<simd_v4i8>(rs1) < 0);
+  return simd_reg((-a & neg) | (a & ~neg));
+}
+
+static inline uint32_t simd_abs_h(uint32_t rs1)
+{
+  simd_v2u16 a = simd_vec<simd_v2u16>(rs1);
+  simd_v2u16 neg = (simd_v2u16)(simd_vec<simd_v2i16>(rs1) < 0);
+  return simd_reg((-a & neg) | (a & ~neg));
+}
+
+// Dot products of the lanes, which are summed up in the scalar registers of
+// the host. The products of bytes and their sums fit into an int; those of
+// halves wrap around in 32 bits.
+#define SIMD_B(x, i) ((x) >> (8 * (i)))
+#define SIMD_H(x, i) ((x) >> (16 * (i)))
+
+static inline uint32_t simd_dotsp_b(uint32_t rs1, uint32_t rs2)
+{
+  return int8_t(SIMD_B(rs1, 0)) * int8_t(SIMD_B(rs2, 0)) +
+         int8_t(SIMD_B(rs1, 1)) * int8_t(SIMD_B(rs2, 1)) +
+         int8_t(SIMD_B(rs1, 2)) * int8_t(SIMD_B(rs2, 2)) +
+         int8_t(SIMD_B(rs1, 3)) * int8_t(SIMD_B(rs2, 3));
+}
+
+static inline uint32_t simd_dotup_b(uint32_t rs1, uint32_t rs2)
+{
+  return uint8_t(SIMD_B(rs1, 0)) * uint8_t(SIMD_B(rs2, 0)) +
+         uint8_t(SIMD_B(rs1, 1)) * uint8_t(SIMD_B(rs2, 1)) +
+         uint8_t(SIMD_B(rs1, 2)) * uint8_t(SIMD_B(rs2, 2)) +
+         uint8_t(SIMD_B(rs1, 3)) * uint8_t(SIMD_B(rs2, 3));
+}
+
+static inline uint32_t simd_dotusp_b(uint32_t rs1, uint32_t rs2)
+{
+  return uint8_t(SIMD_B(rs1, 0)) * int8_t(SIMD_B(rs2, 0)) +
+         uint8_t(SIMD_B(rs1, 1)) * int8_t(SIMD_B(rs2, 1)) +
+         uint8_t(SIMD_B(rs1, 2)) * int8_t(SIMD_B(rs2, 2)) +
+         uint8_t(SIMD_B(rs1, 3)) * int8_t(SIMD_B(rs2, 3));
+}
+
+static inline uint32_t simd_dotsp_h(uint32_t rs1, uint32_t rs2)
+{
+  return uint32_t(int16_t(SIMD_H(rs1, 0)) * int16_t(SIMD_H(rs2, 0))) +
+         uint32_t(int16_t(SIMD_H(rs1, 1)) * int16_t(SIMD_H(rs2, 1)));
+}
+
+static inline uint32_t simd_dotup_h(uint32_t rs1, uint32_t rs2)
+{
+  return uint32_t(uint16_t(SIMD_H(rs1, 0))) * uint16_t(SIMD_H(rs2, 0)) +
+         uint32_t(uint16_t(SIMD_H(rs1, 1))) * uint16_t(SIMD_H(rs2, 1));
+}
+
+static inline uint32_t simd_dotusp_h(uint32_t rs1, uint32_t rs2)
+{
+  return uint32_t(int32_t(uint16_t(SIMD_H(rs1, 0))) * int16_t(SIMD_H(rs2, 0))) +
+         uint32_t(int32_t(uint16_t(SIMD_H(rs1, 1))) * int16_t(SIMD_H(rs2, 1)));
+}
+
+// The same with all lanes of rs2 the lowest byte or half of x, factored out
+static inline uint32_t simd_dotsp_sc_b(uint32_t rs1, uint32_t x)
+{
+  return int8_t(x) * (int8_t(SIMD_B(rs1, 0)) + int8_t(SIMD_B(rs1, 1)) +
+                      int8_t(SIMD_B(rs1, 2)) + int8_t(SIMD_B(rs1, 3)));
+}
+
+static inline uint32_t simd_dotup_sc_b(uint32_t rs1, uint32_t x)
+{
+  return uint8_t(x) * (uint8_t(SIMD_B(rs1, 0)) + uint8_t(SIMD_B(rs1, 1)) +
+                       uint8_t(SIMD_B(rs1, 2)) + uint8_t(SIMD_B(rs1, 3)));
+}
+
+static inline uint32_t simd_dotusp_sc_b(uint32_t rs1, uint32_t x)
+{
+  return int8_t(x) * (uint8_t(SIMD_B(rs1, 0)) + uint8_t(SIMD_B(rs1, 1)) +
+                      uint8_t(SIMD_B(rs1, 2)) + uint8_t(SIMD_B(rs1, 3)));
+}
+
+static inline uint32_t simd_dotsp_sc_h(uint32_t rs1, uint32_t x)
+{
+  return uint32_t(int16_t(x)) *
+         uint32_t(int16_t(SIMD_H(rs1, 0)) + int16_t(SIMD_H(rs1, 1)));
+}
+
+static inline uint32_t simd_dotup_sc_h(uint32_t rs1, uint32_t x)
+{
+  return uint32_t(uint16_t(x)) *
+         uint32_t(uint16_t(SIMD_H(rs1, 0)) + uint16_t(SIMD_H(rs1, 1)));
+}
+
+static inline uint32_t simd_dotusp_sc_h(uint32_t rs1, uint32_t x)
+{
+  return uint32_t(int16_t(x)) *
+         uint32_t(uint16_t(SIMD_H(rs1, 0)) + uint16_t(SIMD_H(rs1, 1)));
+}
+
+// Every lane i of rd is a lane of rd (bit 2 of lane i of sel clear) or rs1
+// (set), selected by bits 1:0 of lane i of sel
+static inline uint32_t simd_shuffle2_b(uint32_t rd, uint32_t rs1, uint32_t sel)
+{
+  uint64_t src = uint64_t(rs1) << 32 | rd;
+  return uint32_t(uint8_t(SIMD_B(src, SIMD_B(sel, 0) & 7))) |
+         uint32_t(uint8_t(SIMD_B(src, SIMD_B(sel, 1) & 7))) << 8 |
+         uint32_t(uint8_t(SIMD_B(src, SIMD_B(sel, 2) & 7))) << 16 |
+         uint32_t(uint8_t(SIMD_B(src, SIMD_B(sel, 3) & 7))) << 24;
+}
+
+// The same for halves, selected by bit 1 and bit 0
+static inline uint32_t simd_shuffle2_h(uint32_t rd, uint32_t rs1, uint32_t sel)
+{
+  uint64_t src = uint64_t(rs1) << 32 | rd;
+  return uint32_t(uint16_t(SIMD_H(src, SIMD_H(sel, 0) & 3))) |
+         uint32_t(uint16_t(SIMD_H(src, SIMD_H(sel, 1) & 3))) << 16;
+}
+
+#undef SIMD_B
+#undef SIMD_H
+
+#endif
@@ -0,0 +1,1063 @@
+// See LICENSE for license details.
+
+// Compares the packed-SIMD handlers of Xpulpimg (insns/pv_*.h), which use
+// xpulp_simd.h, with the per-lane handlers they replaced: checks that both
+// give the same results on random and corner-case operands and measures the
+// time per call of each. Build with `make xpulp_simd_bench`.
+//
+// Usage: xpulp_simd_bench [iterations]
+
+#include "decode.h"
+#include "xpulp_simd.h"
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+struct operands_t
+{
+  reg_t rs1;
+  reg_t rs2;
+  reg_t rd;
+};
+
+typedef reg_t (*handler_t)(const operands_t& op, insn_t insn);
+
+// Let the handlers read their operands from op and return their result, on
+// RV32, the only XLEN of Xpulpimg
+#undef RS1
+#undef RS2
+#undef RD
+#undef WRITE_RD
+#define RS1 op.rs1
+#define RS2 op.rs2
+#define RD op.rd
+#define WRITE_RD(value) return (value)
+#define xlen 32
+
+// The per-lane handlers
+#define REF_LANES(name, type, lanes, width, expr) \
+  static reg_t ref_##name(const operands_t& op, insn_t insn) \
+  { \
+    type temp; \
+    uint32_t simd_rd = 0; \
+    for (int i = lanes - 1; i >= 0; i--) { \
+      temp = expr; \
+      simd_rd <<= width; \
+      simd_rd += (uint32_t)temp & ((1u << width) - 1); \
+    } \
+    WRITE_RD(sext_xlen(simd_rd)); \
+  }
+#define REF_LANES_B(name, expr) REF_LANES(name, int8_t, 4, 8, expr)
+#define REF_LANES_H(name, expr) REF_LANES(name, int16_t, 2, 16, expr)
+
+#define REF_DOT(name, lanes, type, init, expr) \
+  static reg_t ref_##name(const operands_t& op, insn_t insn) \
+  { \
+    type acc = init; \
+    for (int i = lanes - 1; i >= 0; i--) \
+      acc += expr; \
+    WRITE_RD(sext_xlen(acc)); \
+  }
+#define REF_DOT_B(name, type, init, expr) REF_DOT(name, 4, type, init, expr)
+#define REF_DOT_H(name, type, init, expr) REF_DOT(name, 2, type, init, expr)
+
+#define REF_SHUFFLE2_B(name) \
+  static reg_t ref_##name(const operands_t& op, insn_t insn) \
+  { \
+    uint32_t simd_rd = 0; \
+    for (int i = 3; i >= 0; i--) { \
+      uint8_t byte_sel = RS2_B(i) & 0x03; \
+      uint8_t src_sel = (RS2_B(i) >> 2) & 0x01; \
+      uint8_t source = src_sel ? RS1_B(byte_sel) : RD_B(byte_sel); \
+      simd_rd <<= 8; \
+      simd_rd += (uint32_t)source & 0x000000FF; \
+    } \
+    WRITE_RD(sext_xlen(simd_rd)); \
+  }
+
+#define REF_SHUFFLE2_H(name) \
+  static reg_t ref_##name(const operands_t& op, insn_t insn) \
+  { \
+    uint32_t simd_rd = 0; \
+    for (int i = 1; i >= 0; i--) { \
+      uint8_t half_sel = RS2_H(i) & 0x01; \
+      uint8_t src_sel = (RS2_H(i) >> 1) & 0x01; \
+      uint16_t source = src_sel ? RS1_H(half_sel) : RD_H(half_sel); \
+      simd_rd <<= 16; \
+      simd_rd += (uint32_t)source & 0x0000FFFF; \
+    } \
+    WRITE_RD(sext_xlen(simd_rd)); \
+  }
+
+REF_LANES_B(pv_abs_b, sext8(RS1_B(i)) > 0 ? RS1_B(i) : -sext8(RS1_B(i)))
+REF_LANES_H(pv_abs_h, sext16(RS1_H(i)) > 0 ? RS1_H(i) : -sext16(RS1_H(i)))
+REF_LANES_B(pv_add_b, sext8(RS1_B(i)) + sext8(RS2_B(i)))
+REF_LANES_H(pv_add_h, sext16(RS1_H(i)) + sext16(RS2_H(i)))
+REF_LANES_B(pv_add_sc_b, sext8(RS1_B(i)) + sext8(RS2_B(0)))
+REF_LANES_H(pv_add_sc_h, sext16(RS1_H(i)) + sext16(RS2_H(0)))
+REF_LANES_B(pv_add_sci_b, sext8(RS1_B(i)) + insn.p_simm6())
+REF_LANES_H(pv_add_sci_h, sext16(RS1_H(i)) + insn.p_simm6())
+REF_LANES_B(pv_and_b, RS1_B(i) & RS2_B(i))
+REF_LANES_H(pv_and_h, RS1_H(i) & RS2_H(i))
+REF_LANES_B(pv_and_sc_b, RS1_B(i) & RS2_B(0))
+REF_LANES_H(pv_and_sc_h, RS1_H(i) & RS2_H(0))
+REF_LANES_B(pv_and_sci_b, RS1_B(i) & insn.p_simm6())
+REF_LANES_H(pv_and_sci_h, RS1_H(i) & insn.p_simm6())
+REF_LANES_B(pv_avg_b, sext8(sext8(RS1_B(i)) + sext8(RS2_B(i))) >> 1)
+REF_LANES_H(pv_avg_h, sext16(sext16(RS1_H(i)) + sext16(RS2_H(i))) >> 1)
+REF_LANES_B(pv_avg_sc_b, sext8(sext8(RS1_B(i)) + sext8(RS2_B(0))) >> 1)
+REF_LANES_H(pv_avg_sc_h, sext16(sext16(RS1_H(i)) + sext16(RS2_H(0))) >> 1)
+REF_LANES_B(pv_avg_sci_b, sext8(sext8(RS1_B(i)) + insn.p_simm6()) >> 1)
+REF_LANES_H(pv_avg_sci_h, sext16(sext16(RS1_H(i)) + insn.p_simm6()) >> 1)
+REF_LANES_B(pv_avgu_b, zext8(zext8(RS1_B(i)) + zext8(RS2_B(i))) >> 1)
+REF_LANES_H(pv_avgu_h, zext16(zext16(RS1_H(i)) + zext16(RS2_H(i))) >> 1)
+REF_LANES_B(pv_avgu_sc_b, zext8(zext8(RS1_B(i)) + zext8(RS2_B(0))) >> 1)
+REF_LANES_H(pv_avgu_sc_h, zext16(zext16(RS1_H(i)) + zext16(RS2_H(0))) >> 1)
+REF_LANES_B(pv_avgu_sci_b, zext8(zext8(RS1_B(i)) + insn.p_zimm6()) >> 1)
+REF_LANES_H(pv_avgu_sci_h, zext16(zext16(RS1_H(i)) + insn.p_zimm6()) >> 1)
+REF_DOT_B(pv_dotsp_b, int32_t, 0, sext8(RS1_B(i)) * sext8(RS2_B(i)))
+REF_DOT_H(pv_dotsp_h, int32_t, 0, sext16(RS1_H(i)) * sext16(RS2_H(i)))
+REF_DOT_B(pv_dotsp_sc_b, int32_t, 0, sext8(RS1_B(i)) * sext8(RS2_B(0)))
+REF_DOT_H(pv_dotsp_sc_h, int32_t, 0, sext16(RS1_H(i)) * sext16(RS2_H(0)))
+REF_DOT_B(pv_dotsp_sci_b, int32_t, 0, sext8(RS1_B(i)) * insn.p_simm6())
+REF_DOT_H(pv_dotsp_sci_h, int32_t, 0, sext16(RS1_H(i)) * insn.p_simm6())
+REF_DOT_B(pv_dotup_b, uint32_t, 0, zext8(RS1_B(i)) * zext8(RS2_B(i)))
+REF_DOT_H(pv_dotup_h, uint32_t, 0, zext16(RS1_H(i)) * zext16(RS2_H(i)))
+REF_DOT_B(pv_dotup_sc_b, uint32_t, 0, zext8(RS1_B(i)) * zext8(RS2_B(0)))
+REF_DOT_H(pv_dotup_sc_h, uint32_t, 0, zext16(RS1_H(i)) * zext16(RS2_H(0)))
+REF_DOT_B(pv_dotup_sci_b, uint32_t, 0, zext8(RS1_B(i)) * insn.p_zimm6())
+REF_DOT_H(pv_dotup_sci_h, uint32_t, 0, zext16(RS1_H(i)) * insn.p_zimm6())
+REF_DOT_B(pv_dotusp_b, int32_t, 0, sreg_t(zext8(RS1_B(i))) * sext8(RS2_B(i)))
+REF_DOT_H(pv_dotusp_h, int32_t, 0, sreg_t(zext16(RS1_H(i))) * sext16(RS2_H(i)))
+REF_DOT_B(pv_dotusp_sc_b, int32_t, 0, sreg_t(zext8(RS1_B(i))) * sext8(RS2_B(0)))
+REF_DOT_H(pv_dotusp_sc_h, int32_t, 0, sreg_t(zext16(RS1_H(i))) * sext16(RS2_H(0)))
+REF_DOT_B(pv_dotusp_sci_b, int32_t, 0, sreg_t(zext8(RS1_B(i))) * insn.p_simm6())
+REF_DOT_H(pv_dotusp_sci_h, int32_t, 0, sreg_t(zext16(RS1_H(i))) * insn.p_simm6())
+REF_LANES_B(pv_max_b, sext8(RS1_B(i)) > sext8(RS2_B(i)) ? RS1_B(i) : RS2_B(i))
+REF_LANES_H(pv_max_h, sext16(RS1_H(i)) > sext16(RS2_H(i)) ? RS1_H(i) : RS2_H(i))
+REF_LANES_B(pv_max_sc_b, sext8(RS1_B(i)) > sext8(RS2_B(0)) ? RS1_B(i) : RS2_B(0))
+REF_LANES_H(pv_max_sc_h, sext16(RS1_H(i)) > sext16(RS2_H(0)) ? RS1_H(i) : RS2_H(0))
+REF_LANES_B(pv_max_sci_b, sext8(RS1_B(i)) > insn.p_simm6() ? RS1_B(i) : insn.p_simm6())
+REF_LANES_H(pv_max_sci_h, sext16(RS1_H(i)) > insn.p_simm6() ? RS1_H(i) : insn.p_simm6())
+REF_LANES_B(pv_maxu_b, zext8(RS1_B(i)) > zext8(RS2_B(i)) ? RS1_B(i) : RS2_B(i))
+REF_LANES_H(pv_maxu_h, zext16(RS1_H(i)) > zext16(RS2_H(i)) ? RS1_H(i) : RS2_H(i))
+REF_LANES_B(pv_maxu_sc_b, zext8(RS1_B(i)) > zext8(RS2_B(0)) ? RS1_B(i) : RS2_B(0))
+REF_LANES_H(pv_maxu_sc_h, zext16(RS1_H(i)) > zext16(RS2_H(0)) ? RS1_H(i) : RS2_H(0))
+REF_LANES_B(pv_maxu_sci_b, zext8(RS1_B(i)) > insn.p_zimm6() ? RS1_B(i) : insn.p_zimm6())
+REF_LANES_H(pv_maxu_sci_h, zext16(RS1_H(i)) > insn.p_zimm6() ? RS1_H(i) : insn.p_zimm6())
+REF_LANES_B(pv_min_b, sext8(RS1_B(i)) <= sext8(RS2_B(i)) ? RS1_B(i) : RS2_B(i))
+REF_LANES_H(pv_min_h, sext16(RS1_H(i)) <= sext16(RS2_H(i)) ? RS1_H(i) : RS2_H(i))
+REF_LANES_B(pv_min_sc_b, sext8(RS1_B(i)) <= sext8(RS2_B(0)) ? RS1_B(i) : RS2_B(0))
+REF_LANES_H(pv_min_sc_h, sext16(RS1_H(i)) <= sext16(RS2_H(0)) ? RS1_H(i) : RS2_H(0))
+REF_LANES_B(pv_min_sci_b, sext8(RS1_B(i)) <= insn.p_simm6() ? RS1_B(i) : insn.p_simm6())
+REF_LANES_H(pv_min_sci_h, sext16(RS1_H(i)) <= insn.p_simm6() ? RS1_H(i) : insn.p_simm6())
+REF_LANES_B(pv_minu_b, zext8(RS1_B(i)) <= zext8(RS2_B(i)) ? RS1_B(i) : RS2_B(i))
+REF_LANES_H(pv_minu_h, zext16(RS1_H(i)) <= zext16(RS2_H(i)) ? RS1_H(i) : RS2_H(i))
+REF_LANES_B(pv_minu_sc_b, zext8(RS1_B(i)) <= zext8(RS2_B(0)) ? RS1_B(i) : RS2_B(0))
+REF_LANES_H(pv_minu_sc_h, zext16(RS1_H(i)) <= zext16(RS2_H(0)) ? RS1_H(i) : RS2_H(0))
+REF_LANES_B(pv_minu_sci_b, zext8(RS1_B(i)) <= insn.p_zimm6() ? RS1_B(i) : insn.p_zimm6())
+REF_LANES_H(pv_minu_sci_h, zext16(RS1_H(i)) <= insn.p_zimm6() ? RS1_H(i) : insn.p_zimm6())
+REF_LANES_B(pv_or_b, RS1_B(i) | RS2_B(i))
+REF_LANES_H(pv_or_h, RS1_H(i) | RS2_H(i))
+REF_LANES_B(pv_or_sc_b, RS1_B(i) | RS2_B(0))
+REF_LANES_H(pv_or_sc_h, RS1_H(i) | RS2_H(0))
+REF_LANES_B(pv_or_sci_b, RS1_B(i) | insn.p_simm6())
+REF_LANES_H(pv_or_sci_h, RS1_H(i) | insn.p_simm6())
+REF_DOT_B(pv_sdotsp_b, int32_t, RD, sext8(RS1_B(i)) * sext8(RS2_B(i)))
+REF_DOT_H(pv_sdotsp_h, int32_t, RD, sext16(RS1_H(i)) * sext16(RS2_H(i)))
+REF_DOT_B(pv_sdotsp_sc_b, int32_t, RD, sext8(RS1_B(i)) * sext8(RS2_B(0)))
+REF_DOT_H(pv_sdotsp_sc_h, int32_t, RD, sext16(RS1_H(i)) * sext16(RS2_H(0)))
+REF_DOT_B(pv_sdotsp_sci_b, int32_t, RD, sext8(RS1_B(i)) * insn.p_simm6())
+REF_DOT_H(pv_sdotsp_sci_h, int32_t, RD, sext16(RS1_H(i)) * insn.p_simm6())
+REF_DOT_B(pv_sdotup_b, uint32_t, RD, zext8(RS1_B(i)) * zext8(RS2_B(i)))
+REF_DOT_H(pv_sdotup_h, uint32_t, RD, zext16(RS1_H(i)) * zext16(RS2_H(i)))
+REF_DOT_B(pv_sdotup_sc_b, uint32_t, RD, zext8(RS1_B(i)) * zext8(RS2_B(0)))
+REF_DOT_H(pv_sdotup_sc_h, uint32_t, RD, zext16(RS1_H(i)) * zext16(RS2_H(0)))
+REF_DOT_B(pv_sdotup_sci_b, uint32_t, RD, zext8(RS1_B(i)) * insn.p_zimm6())
+REF_DOT_H(pv_sdotup_sci_h, uint32_t, RD, zext16(RS1_H(i)) * insn.p_zimm6())
+REF_DOT_B(pv_sdotusp_b, int32_t, RD, sreg_t(zext8(RS1_B(i))) * sext8(RS2_B(i)))
+REF_DOT_H(pv_sdotusp_h, int32_t, RD, sreg_t(zext16(RS1_H(i))) * sext16(RS2_H(i)))
+REF_DOT_B(pv_sdotusp_sc_b, int32_t, RD, sreg_t(zext8(RS1_B(i))) * sext8(RS2_B(0)))
+REF_DOT_H(pv_sdotusp_sc_h, int32_t, RD, sreg_t(zext16(RS1_H(i))) * sext16(RS2_H(0)))
+REF_DOT_B(pv_sdotusp_sci_b, int32_t, RD, sreg_t(zext8(RS1_B(i))) * insn.p_simm6())
+REF_DOT_H(pv_sdotusp_sci_h, int32_t, RD, sreg_t(zext16(RS1_H(i))) * insn.p_simm6())
+REF_SHUFFLE2_B(pv_shuffle2_b)
+REF_SHUFFLE2_H(pv_shuffle2_h)
+REF_LANES_B(pv_sll_b, zext8(RS1_B(i)) << (zext8(RS2_B(i)) & 0x07))
+REF_LANES_H(pv_sll_h, zext16(RS1_H(i)) << (zext16(RS2_H(i)) & 0x0F))
+REF_LANES_B(pv_sll_sc_b, zext8(RS1_B(i)) << (zext8(RS2_B(0)) & 0x07))
+REF_LANES_H(pv_sll_sc_h, zext16(RS1_H(i)) << (zext16(RS2_H(0)) & 0x0F))
+REF_LANES_B(pv_sll_sci_b, zext8(RS1_B(i)) << (insn.p_simm6() & 0x07))
+REF_LANES_H(pv_sll_sci_h, zext16(RS1_H(i)) << (insn.p_simm6() & 0x0F))
+REF_LANES_B(pv_sra_b, sext8(RS1_B(i)) >> (zext8(RS2_B(i)) & 0x07))
+REF_LANES_H(pv_sra_h, sext16(RS1_H(i)) >> (zext16(RS2_H(i)) & 0x0F))
+REF_LANES_B(pv_sra_sc_b, sext8(RS1_B(i)) >> (zext8(RS2_B(0)) & 0x07))
+REF_LANES_H(pv_sra_sc_h, sext16(RS1_H(i)) >> (zext16(RS2_H(0)) & 0x0F))
+REF_LANES_B(pv_sra_sci_b, sext8(RS1_B(i)) >> (insn.p_simm6() & 0x07))
+REF_LANES_H(pv_sra_sci_h, sext16(RS1_H(i)) >> (insn.p_simm6() & 0x0F))
+REF_LANES_B(pv_srl_b, zext8(RS1_B(i)) >> (zext8(RS2_B(i)) & 0x07))
+REF_LANES_H(pv_srl_h, zext16(RS1_H(i)) >> (zext16(RS2_H(i)) & 0x0F))
+REF_LANES_B(pv_srl_sc_b, zext8(RS1_B(i)) >> (zext8(RS2_B(0)) & 0x07))
+REF_LANES_H(pv_srl_sc_h, zext16(RS1_H(i)) >> (zext16(RS2_H(0)) & 0x0F))
+REF_LANES_B(pv_srl_sci_b, zext8(RS1_B(i)) >> (insn.p_simm6() & 0x07))
+REF_LANES_H(pv_srl_sci_h, zext16(RS1_H(i)) >> (insn.p_simm6() & 0x0F))
+REF_LANES_B(pv_sub_b, sext8(RS1_B(i)) - sext8(RS2_B(i)))
+REF_LANES_H(pv_sub_h, sext16(RS1_H(i)) - sext16(RS2_H(i)))
+REF_LANES_B(pv_sub_sc_b, sext8(RS1_B(i)) - sext8(RS2_B(0)))
+REF_LANES_H(pv_sub_sc_h, sext16(RS1_H(i)) - sext16(RS2_H(0)))
+REF_LANES_B(pv_sub_sci_b, sext8(RS1_B(i)) - insn.p_simm6())
+REF_LANES_H(pv_sub_sci_h, sext16(RS1_H(i)) - insn.p_simm6())
+REF_LANES_B(pv_xor_b, RS1_B(i) ^ RS2_B(i))
+REF_LANES_H(pv_xor_h, RS1_H(i) ^ RS2_H(i))
+REF_LANES_B(pv_xor_sc_b, RS1_B(i) ^ RS2_B(0))
+REF_LANES_H(pv_xor_sc_h, RS1_H(i) ^ RS2_H(0))
+REF_LANES_B(pv_xor_sci_b, RS1_B(i) ^ insn.p_simm6())
+REF_LANES_H(pv_xor_sci_h, RS1_H(i) ^ insn.p_simm6())
+
+// The packed-SIMD handlers
+static reg_t new_pv_abs_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_abs_b.h"
+}
+
+static reg_t new_pv_abs_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_abs_h.h"
+}
+
+static reg_t new_pv_add_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_add_b.h"
+}
+
+static reg_t new_pv_add_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_add_h.h"
+}
+
+static reg_t new_pv_add_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_add_sc_b.h"
+}
+
+static reg_t new_pv_add_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_add_sc_h.h"
+}
+
+static reg_t new_pv_add_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_add_sci_b.h"
+}
+
+static reg_t new_pv_add_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_add_sci_h.h"
+}
+
+static reg_t new_pv_and_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_and_b.h"
+}
+
+static reg_t new_pv_and_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_and_h.h"
+}
+
+static reg_t new_pv_and_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_and_sc_b.h"
+}
+
+static reg_t new_pv_and_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_and_sc_h.h"
+}
+
+static reg_t new_pv_and_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_and_sci_b.h"
+}
+
+static reg_t new_pv_and_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_and_sci_h.h"
+}
+
+static reg_t new_pv_avg_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avg_b.h"
+}
+
+static reg_t new_pv_avg_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avg_h.h"
+}
+
+static reg_t new_pv_avg_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avg_sc_b.h"
+}
+
+static reg_t new_pv_avg_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avg_sc_h.h"
+}
+
+static reg_t new_pv_avg_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avg_sci_b.h"
+}
+
+static reg_t new_pv_avg_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avg_sci_h.h"
+}
+
+static reg_t new_pv_avgu_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avgu_b.h"
+}
+
+static reg_t new_pv_avgu_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avgu_h.h"
+}
+
+static reg_t new_pv_avgu_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avgu_sc_b.h"
+}
+
+static reg_t new_pv_avgu_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avgu_sc_h.h"
+}
+
+static reg_t new_pv_avgu_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avgu_sci_b.h"
+}
+
+static reg_t new_pv_avgu_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_avgu_sci_h.h"
+}
+
+static reg_t new_pv_dotsp_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotsp_b.h"
+}
+
+static reg_t new_pv_dotsp_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotsp_h.h"
+}
+
+static reg_t new_pv_dotsp_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotsp_sc_b.h"
+}
+
+static reg_t new_pv_dotsp_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotsp_sc_h.h"
+}
+
+static reg_t new_pv_dotsp_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotsp_sci_b.h"
+}
+
+static reg_t new_pv_dotsp_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotsp_sci_h.h"
+}
+
+static reg_t new_pv_dotup_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotup_b.h"
+}
+
+static reg_t new_pv_dotup_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotup_h.h"
+}
+
+static reg_t new_pv_dotup_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotup_sc_b.h"
+}
+
+static reg_t new_pv_dotup_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotup_sc_h.h"
+}
+
+static reg_t new_pv_dotup_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotup_sci_b.h"
+}
+
+static reg_t new_pv_dotup_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotup_sci_h.h"
+}
+
+static reg_t new_pv_dotusp_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotusp_b.h"
+}
+
+static reg_t new_pv_dotusp_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotusp_h.h"
+}
+
+static reg_t new_pv_dotusp_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotusp_sc_b.h"
+}
+
+static reg_t new_pv_dotusp_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotusp_sc_h.h"
+}
+
+static reg_t new_pv_dotusp_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotusp_sci_b.h"
+}
+
+static reg_t new_pv_dotusp_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_dotusp_sci_h.h"
+}
+
+static reg_t new_pv_max_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_max_b.h"
+}
+
+static reg_t new_pv_max_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_max_h.h"
+}
+
+static reg_t new_pv_max_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_max_sc_b.h"
+}
+
+static reg_t new_pv_max_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_max_sc_h.h"
+}
+
+static reg_t new_pv_max_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_max_sci_b.h"
+}
+
+static reg_t new_pv_max_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_max_sci_h.h"
+}
+
+static reg_t new_pv_maxu_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_maxu_b.h"
+}
+
+static reg_t new_pv_maxu_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_maxu_h.h"
+}
+
+static reg_t new_pv_maxu_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_maxu_sc_b.h"
+}
+
+static reg_t new_pv_maxu_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_maxu_sc_h.h"
+}
+
+static reg_t new_pv_maxu_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_maxu_sci_b.h"
+}
+
+static reg_t new_pv_maxu_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_maxu_sci_h.h"
+}
+
+static reg_t new_pv_min_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_min_b.h"
+}
+
+static reg_t new_pv_min_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_min_h.h"
+}
+
+static reg_t new_pv_min_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_min_sc_b.h"
+}
+
+static reg_t new_pv_min_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_min_sc_h.h"
+}
+
+static reg_t new_pv_min_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_min_sci_b.h"
+}
+
+static reg_t new_pv_min_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_min_sci_h.h"
+}
+
+static reg_t new_pv_minu_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_minu_b.h"
+}
+
+static reg_t new_pv_minu_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_minu_h.h"
+}
+
+static reg_t new_pv_minu_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_minu_sc_b.h"
+}
+
+static reg_t new_pv_minu_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_minu_sc_h.h"
+}
+
+static reg_t new_pv_minu_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_minu_sci_b.h"
+}
+
+static reg_t new_pv_minu_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_minu_sci_h.h"
+}
+
+static reg_t new_pv_or_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_or_b.h"
+}
+
+static reg_t new_pv_or_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_or_h.h"
+}
+
+static reg_t new_pv_or_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_or_sc_b.h"
+}
+
+static reg_t new_pv_or_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_or_sc_h.h"
+}
+
+static reg_t new_pv_or_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_or_sci_b.h"
+}
+
+static reg_t new_pv_or_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_or_sci_h.h"
+}
+
+static reg_t new_pv_sdotsp_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotsp_b.h"
+}
+
+static reg_t new_pv_sdotsp_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotsp_h.h"
+}
+
+static reg_t new_pv_sdotsp_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotsp_sc_b.h"
+}
+
+static reg_t new_pv_sdotsp_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotsp_sc_h.h"
+}
+
+static reg_t new_pv_sdotsp_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotsp_sci_b.h"
+}
+
+static reg_t new_pv_sdotsp_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotsp_sci_h.h"
+}
+
+static reg_t new_pv_sdotup_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotup_b.h"
+}
+
+static reg_t new_pv_sdotup_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotup_h.h"
+}
+
+static reg_t new_pv_sdotup_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotup_sc_b.h"
+}
+
+static reg_t new_pv_sdotup_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotup_sc_h.h"
+}
+
+static reg_t new_pv_sdotup_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotup_sci_b.h"
+}
+
+static reg_t new_pv_sdotup_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotup_sci_h.h"
+}
+
+static reg_t new_pv_sdotusp_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotusp_b.h"
+}
+
+static reg_t new_pv_sdotusp_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotusp_h.h"
+}
+
+static reg_t new_pv_sdotusp_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotusp_sc_b.h"
+}
+
+static reg_t new_pv_sdotusp_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotusp_sc_h.h"
+}
+
+static reg_t new_pv_sdotusp_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotusp_sci_b.h"
+}
+
+static reg_t new_pv_sdotusp_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sdotusp_sci_h.h"
+}
+
+static reg_t new_pv_shuffle2_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_shuffle2_b.h"
+}
+
+static reg_t new_pv_shuffle2_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_shuffle2_h.h"
+}
+
+static reg_t new_pv_sll_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sll_b.h"
+}
+
+static reg_t new_pv_sll_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sll_h.h"
+}
+
+static reg_t new_pv_sll_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sll_sc_b.h"
+}
+
+static reg_t new_pv_sll_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sll_sc_h.h"
+}
+
+static reg_t new_pv_sll_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sll_sci_b.h"
+}
+
+static reg_t new_pv_sll_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sll_sci_h.h"
+}
+
+static reg_t new_pv_sra_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sra_b.h"
+}
+
+static reg_t new_pv_sra_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sra_h.h"
+}
+
+static reg_t new_pv_sra_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sra_sc_b.h"
+}
+
+static reg_t new_pv_sra_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sra_sc_h.h"
+}
+
+static reg_t new_pv_sra_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sra_sci_b.h"
+}
+
+static reg_t new_pv_sra_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sra_sci_h.h"
+}
+
+static reg_t new_pv_srl_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_srl_b.h"
+}
+
+static reg_t new_pv_srl_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_srl_h.h"
+}
+
+static reg_t new_pv_srl_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_srl_sc_b.h"
+}
+
+static reg_t new_pv_srl_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_srl_sc_h.h"
+}
+
+static reg_t new_pv_srl_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_srl_sci_b.h"
+}
+
+static reg_t new_pv_srl_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_srl_sci_h.h"
+}
+
+static reg_t new_pv_sub_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sub_b.h"
+}
+
+static reg_t new_pv_sub_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sub_h.h"
+}
+
+static reg_t new_pv_sub_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sub_sc_b.h"
+}
+
+static reg_t new_pv_sub_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sub_sc_h.h"
+}
+
+static reg_t new_pv_sub_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sub_sci_b.h"
+}
+
+static reg_t new_pv_sub_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_sub_sci_h.h"
+}
+
+static reg_t new_pv_xor_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_xor_b.h"
+}
+
+static reg_t new_pv_xor_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_xor_h.h"
+}
+
+static reg_t new_pv_xor_sc_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_xor_sc_b.h"
+}
+
+static reg_t new_pv_xor_sc_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_xor_sc_h.h"
+}
+
+static reg_t new_pv_xor_sci_b(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_xor_sci_b.h"
+}
+
+static reg_t new_pv_xor_sci_h(const operands_t& op, insn_t insn)
+{
+  #include "insns/pv_xor_sci_h.h"
+}
+
+struct bench_t
+{
+  const char* name;
+  handler_t ref;
+  handler_t simd;
+};
+
+static const bench_t benches[] = {
+  { "pv.abs.b", ref_pv_abs_b, new_pv_abs_b },
+  { "pv.abs.h", ref_pv_abs_h, new_pv_abs_h },
+  { "pv.add.b", ref_pv_add_b, new_pv_add_b },
+  { "pv.add.h", ref_pv_add_h, new_pv_add_h },
+  { "pv.add.sc.b", ref_pv_add_sc_b, new_pv_add_sc_b },
+  { "pv.add.sc.h", ref_pv_add_sc_h, new_pv_add_sc_h },
+  { "pv.add.sci.b", ref_pv_add_sci_b, new_pv_add_sci_b },
+  { "pv.add.sci.h", ref_pv_add_sci_h, new_pv_add_sci_h },
+  { "pv.and.b", ref_pv_and_b, new_pv_and_b },
+  { "pv.and.h", ref_pv_and_h, new_pv_and_h },
+  { "pv.and.sc.b", ref_pv_and_sc_b, new_pv_and_sc_b },
+  { "pv.and.sc.h", ref_pv_and_sc_h, new_pv_and_sc_h },
+  { "pv.and.sci.b", ref_pv_and_sci_b, new_pv_and_sci_b },
+  { "pv.and.sci.h", ref_pv_and_sci_h, new_pv_and_sci_h },
+  { "pv.avg.b", ref_pv_avg_b, new_pv_avg_b },
+  { "pv.avg.h", ref_pv_avg_h, new_pv_avg_h },
+  { "pv.avg.sc.b", ref_pv_avg_sc_b, new_pv_avg_sc_b },
+  { "pv.avg.sc.h", ref_pv_avg_sc_h, new_pv_avg_sc_h },
+  { "pv.avg.sci.b", ref_pv_avg_sci_b, new_pv_avg_sci_b },
+  { "pv.avg.sci.h", ref_pv_avg_sci_h, new_pv_avg_sci_h },
+  { "pv.avgu.b", ref_pv_avgu_b, new_pv_avgu_b },
+  { "pv.avgu.h", ref_pv_avgu_h, new_pv_avgu_h },
+  { "pv.avgu.sc.b", ref_pv_avgu_sc_b, new_pv_avgu_sc_b },
+  { "pv.avgu.sc.h", ref_pv_avgu_sc_h, new_pv_avgu_sc_h },
+  { "pv.avgu.sci.b", ref_pv_avgu_sci_b, new_pv_avgu_sci_b },
+  { "pv.avgu.sci.h", ref_pv_avgu_sci_h, new_pv_avgu_sci_h },
+  { "pv.dotsp.b", ref_pv_dotsp_b, new_pv_dotsp_b },
+  { "pv.dotsp.h", ref_pv_dotsp_h, new_pv_dotsp_h },
+  { "pv.dotsp.sc.b", ref_pv_dotsp_sc_b, new_pv_dotsp_sc_b },
+  { "pv.dotsp.sc.h", ref_pv_dotsp_sc_h, new_pv_dotsp_sc_h },
+  { "pv.dotsp.sci.b", ref_pv_dotsp_sci_b, new_pv_dotsp_sci_b },
+  { "pv.dotsp.sci.h", ref_pv_dotsp_sci_h, new_pv_dotsp_sci_h },
+  { "pv.dotup.b", ref_pv_dotup_b, new_pv_dotup_b },
+  { "pv.dotup.h", ref_pv_dotup_h, new_pv_dotup_h },
+  { "pv.dotup.sc.b", ref_pv_dotup_sc_b, new_pv_dotup_sc_b },
+  { "pv.dotup.sc.h", ref_pv_dotup_sc_h, new_pv_dotup_sc_h },
+  { "pv.dotup.sci.b", ref_pv_dotup_sci_b, new_pv_dotup_sci_b },
+  { "pv.dotup.sci.h", ref_pv_dotup_sci_h, new_pv_dotup_sci_h },
+  { "pv.dotusp.b", ref_pv_dotusp_b, new_pv_dotusp_b },
+  { "pv.dotusp.h", ref_pv_dotusp_h, new_pv_dotusp_h },
+  { "pv.dotusp.sc.b", ref_pv_dotusp_sc_b, new_pv_dotusp_sc_b },
+  { "pv.dotusp.sc.h", ref_pv_dotusp_sc_h, new_pv_dotusp_sc_h },
+  { "pv.dotusp.sci.b", ref_pv_dotusp_sci_b, new_pv_dotusp_sci_b },
+  { "pv.dotusp.sci.h", ref_pv_dotusp_sci_h, new_pv_dotusp_sci_h },
+  { "pv.max.b", ref_pv_max_b, new_pv_max_b },
+  { "pv.max.h", ref_pv_max_h, new_pv_max_h },
+  { "pv.max.sc.b", ref_pv_max_sc_b, new_pv_max_sc_b },
+  { "pv.max.sc.h", ref_pv_max_sc_h, new_pv_max_sc_h },
+  { "pv.max.sci.b", ref_pv_max_sci_b, new_pv_max_sci_b },
+  { "pv.max.sci.h", ref_pv_max_sci_h, new_pv_max_sci_h },
+  { "pv.maxu.b", ref_pv_maxu_b, new_pv_maxu_b },
+  { "pv.maxu.h", ref_pv_maxu_h, new_pv_maxu_h },
+  { "pv.maxu.sc.b", ref_pv_maxu_sc_b, new_pv_maxu_sc_b },
+  { "pv.maxu.sc.h", ref_pv_maxu_sc_h, new_pv_maxu_sc_h },
+  { "pv.maxu.sci.b", ref_pv_maxu_sci_b, new_pv_maxu_sci_b },
+  { "pv.maxu.sci.h", ref_pv_maxu_sci_h, new_pv_maxu_sci_h },
+  { "pv.min.b", ref_pv_min_b, new_pv_min_b },
+  { "pv.min.h", ref_pv_min_h, new_pv_min_h },
+  { "pv.min.sc.b", ref_pv_min_sc_b, new_pv_min_sc_b },
+  { "pv.min.sc.h", ref_pv_min_sc_h, new_pv_min_sc_h },
+  { "pv.min.sci.b", ref_pv_min_sci_b, new_pv_min_sci_b },
+  { "pv.min.sci.h", ref_pv_min_sci_h, new_pv_min_sci_h },
+  { "pv.minu.b", ref_pv_minu_b, new_pv_minu_b },
+  { "pv.minu.h", ref_pv_minu_h, new_pv_minu_h },
+  { "pv.minu.sc.b", ref_pv_minu_sc_b, new_pv_minu_sc_b },
+  { "pv.minu.sc.h", ref_pv_minu_sc_h, new_pv_minu_sc_h },
+  { "pv.minu.sci.b", ref_pv_minu_sci_b, new_pv_minu_sci_b },
+  { "pv.minu.sci.h", ref_pv_minu_sci_h, new_pv_minu_sci_h },
+  { "pv.or.b", ref_pv_or_b, new_pv_or_b },
+  { "pv.or.h", ref_pv_or_h, new_pv_or_h },
+  { "pv.or.sc.b", ref_pv_or_sc_b, new_pv_or_sc_b },
+  { "pv.or.sc.h", ref_pv_or_sc_h, new_pv_or_sc_h },
+  { "pv.or.sci.b", ref_pv_or_sci_b, new_pv_or_sci_b },
+  { "pv.or.sci.h", ref_pv_or_sci_h, new_pv_or_sci_h },
+  { "pv.sdotsp.b", ref_pv_sdotsp_b, new_pv_sdotsp_b },
+  { "pv.sdotsp.h", ref_pv_sdotsp_h, new_pv_sdotsp_h },
+  { "pv.sdotsp.sc.b", ref_pv_sdotsp_sc_b, new_pv_sdotsp_sc_b },
+  { "pv.sdotsp.sc.h", ref_pv_sdotsp_sc_h, new_pv_sdotsp_sc_h },
+  { "pv.sdotsp.sci.b", ref_pv_sdotsp_sci_b, new_pv_sdotsp_sci_b },
+  { "pv.sdotsp.sci.h", ref_pv_sdotsp_sci_h, new_pv_sdotsp_sci_h },
+  { "pv.sdotup.b", ref_pv_sdotup_b, new_pv_sdotup_b },
+  { "pv.sdotup.h", ref_pv_sdotup_h, new_pv_sdotup_h },
+  { "pv.sdotup.sc.b", ref_pv_sdotup_sc_b, new_pv_sdotup_sc_b },
+  { "pv.sdotup.sc.h", ref_pv_sdotup_sc_h, new_pv_sdotup_sc_h },
+  { "pv.sdotup.sci.b", ref_pv_sdotup_sci_b, new_pv_sdotup_sci_b },
+  { "pv.sdotup.sci.h", ref_pv_sdotup_sci_h, new_pv_sdotup_sci_h },
+  { "pv.sdotusp.b", ref_pv_sdotusp_b, new_pv_sdotusp_b },
+  { "pv.sdotusp.h", ref_pv_sdotusp_h, new_pv_sdotusp_h },
+  { "pv.sdotusp.sc.b", ref_pv_sdotusp_sc_b, new_pv_sdotusp_sc_b },
+  { "pv.sdotusp.sc.h", ref_pv_sdotusp_sc_h, new_pv_sdotusp_sc_h },
+  { "pv.sdotusp.sci.b", ref_pv_sdotusp_sci_b, new_pv_sdotusp_sci_b },
+  { "pv.sdotusp.sci.h", ref_pv_sdotusp_sci_h, new_pv_sdotusp_sci_h },
+  { "pv.shuffle2.b", ref_pv_shuffle2_b, new_pv_shuffle2_b },
+  { "pv.shuffle2.h", ref_pv_shuffle2_h, new_pv_shuffle2_h },
+  { "pv.sll.b", ref_pv_sll_b, new_pv_sll_b },
+  { "pv.sll.h", ref_pv_sll_h, new_pv_sll_h },
+  { "pv.sll.sc.b", ref_pv_sll_sc_b, new_pv_sll_sc_b },
+  { "pv.sll.sc.h", ref_pv_sll_sc_h, new_pv_sll_sc_h },
+  { "pv.sll.sci.b", ref_pv_sll_sci_b, new_pv_sll_sci_b },
+  { "pv.sll.sci.h", ref_pv_sll_sci_h, new_pv_sll_sci_h },
+  { "pv.sra.b", ref_pv_sra_b, new_pv_sra_b },
+  { "pv.sra.h", ref_pv_sra_h, new_pv_sra_h },
+  { "pv.sra.sc.b", ref_pv_sra_sc_b, new_pv_sra_sc_b },
+  { "pv.sra.sc.h", ref_pv_sra_sc_h, new_pv_sra_sc_h },
+  { "pv.sra.sci.b", ref_pv_sra_sci_b, new_pv_sra_sci_b },
+  { "pv.sra.sci.h", ref_pv_sra_sci_h, new_pv_sra_sci_h },
+  { "pv.srl.b", ref_pv_srl_b, new_pv_srl_b },
+  { "pv.srl.h", ref_pv_srl_h, new_pv_srl_h },
+  { "pv.srl.sc.b", ref_pv_srl_sc_b, new_pv_srl_sc_b },
+  { "pv.srl.sc.h", ref_pv_srl_sc_h, new_pv_srl_sc_h },
+  { "pv.srl.sci.b", ref_pv_srl_sci_b, new_pv_srl_sci_b },
+  { "pv.srl.sci.h", ref_pv_srl_sci_h, new_pv_srl_sci_h },
+  { "pv.sub.b", ref_pv_sub_b, new_pv_sub_b },
+  { "pv.sub.h", ref_pv_sub_h, new_pv_sub_h },
+  { "pv.sub.sc.b", ref_pv_sub_sc_b, new_pv_sub_sc_b },
+  { "pv.sub.sc.h", ref_pv_sub_sc_h, new_pv_sub_sc_h },
+  { "pv.sub.sci.b", ref_pv_sub_sci_b, new_pv_sub_sci_b },
+  { "pv.sub.sci.h", ref_pv_sub_sci_h, new_pv_sub_sci_h },
+  { "pv.xor.b", ref_pv_xor_b, new_pv_xor_b },
+  { "pv.xor.h", ref_pv_xor_h, new_pv_xor_h },
+  { "pv.xor.sc.b", ref_pv_xor_sc_b, new_pv_xor_sc_b },
+  { "pv.xor.sc.h", ref_pv_xor_sc_h, new_pv_xor_sc_h },
+  { "pv.xor.sci.b", ref_pv_xor_sci_b, new_pv_xor_sci_b },
+  { "pv.xor.sci.h", ref_pv_xor_sci_h, new_pv_xor_sci_h },
+};
+
+// A 32-bit value in a register, sign-extended as on RV32
+static reg_t reg32(uint32_t x)
+{
+  return sext32(x);
+}
+
+static uint64_t xorshift(uint64_t& s)
+{
+  s ^= s << 13;
+  s ^= s >> 7;
+  s ^= s << 17;
+  return s;
+}
+
+// Random operands, with corner-case lanes (0, -1, the most negative and the
+// largest value) mixed in
+static reg_t random_operand(uint64_t& s)
+{
+  static const uint32_t corners[] = {
+    0x00000000, 0xFFFFFFFF, 0x80808080, 0x7F7F7F7F, 0x80007FFF, 0x7FFF8000,
+    0x01FF807F, 0x00010000,
+  };
+  uint64_t r = xorshift(s);
+  if (r % 8 == 0)
+    return reg32(corners[(r >> 3) % (sizeof(corners) / sizeof(corners[0]))]);
+  return reg32(r >> 16);
+}
+
+// An R-type instruction with random imm6 bits (25 and 24:20)
+static insn_t random_insn(uint64_t& s)
+{
+  return insn_t(xorshift(s) & ((1 << 25) | (0x1F << 20)));
+}
+
+// Nanoseconds per call of h, chaining the result into rd as in a kernel
+static double time_handler(handler_t h, size_t iterations)
+{
+  handler_t volatile handler = h;
+  operands_t op = { reg32(0x12345678), reg32(0x9ABCDEF0), 0 };
+  insn_t insn(0x03 << 20);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    op.rd = handler(op, insn);
+    op.rs1 = reg32(op.rs1 + 0x9E3779B9);
+  }
+  auto end = std::chrono::steady_clock::now();
+  static volatile reg_t sink;
+  sink = op.rd;
+  return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char** argv)
+{
+  size_t iterations = argc > 1 ? strtoull(argv[1], NULL, 0) : 10000000;
+  const size_t checks = 1 << 16;
+  size_t failures = 0;
+  double log_speedup = 0;
+
+  printf("%-20s %10s %10s %8s\n", "instruction", "ref_ns", "simd_ns", "speedup");
+  for (const bench_t& b : benches) {
+    uint64_t s = 88172645463325252ull;
+    for (size_t i = 0; i < checks; i++) {
+      operands_t op = { random_operand(s), random_operand(s), random_operand(s) };
+      insn_t insn = random_insn(s);
+      reg_t expected = b.ref(op, insn), actual = b.simd(op, insn);
+      if (expected != actual) {
+        if (failures++ < 16)
+          fprintf(stderr, "%s: rs1=0x%08" PRIx32 " rs2=0x%08" PRIx32
+                  " rd=0x%08" PRIx32 " imm6=%" PRId64 ": expected 0x%016" PRIx64
+                  ", got 0x%016" PRIx64 "\n", b.name, uint32_t(op.rs1),
+                  uint32_t(op.rs2), uint32_t(op.rd), insn.p_simm6(),
+                  expected, actual);
+      }
+    }
+
+    double ref = time_handler(b.ref, iterations);
+    double simd = time_handler(b.simd, iterations);
+    log_speedup += log(ref / simd);
+    printf("%-20s %10.2f %10.2f %7.2fx\n", b.name, ref, simd, ref / simd);
+  }
+
+  size_t n = sizeof(benches) / sizeof(benches[0]);
+  printf("geometric mean speedup over %zu instructions: %.2fx\n", n, exp(log_speedup / n));
+  if (failures) {
+    fprintf(stderr, "%zu mismatches\n", failures);
+    return 1;
+  }
+  return 0;
+}
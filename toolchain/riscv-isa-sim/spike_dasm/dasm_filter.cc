@@ -0,0 +1,85 @@
+// See LICENSE for license details.
+
+#include "dasm_filter.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+// Flush the output once this many bytes are buffered
+static const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+
+dasm_filter_t::dasm_filter_t(const disassembler_t* disassembler)
+  : disassembler(disassembler), line(NULL), line_size(0)
+{
+}
+
+dasm_filter_t::~dasm_filter_t()
+{
+  free(line);
+}
+
+bool dasm_filter_t::process(FILE* in, FILE* out)
+{
+  buf.reserve(OUTPUT_BUFFER_SIZE + 4096);
+
+  ssize_t len;
+  while ((len = getline(&line, &line_size, in)) >= 0)
+  {
+    if (len > 0 && line[len-1] == '\n')
+      line[--len] = '\0';
+    filter_line(line, len, buf);
+    buf += '\n';
+
+    if (buf.size() >= OUTPUT_BUFFER_SIZE && !flush(out))
+      return false;
+  }
+  return flush(out) && !ferror(in);
+}
+
+const std::string& dasm_filter_t::disassemble(int64_t bits)
+{
+  auto it = cache.find(bits);
+  if (it == cache.end())
+    it = cache.emplace(bits, disassembler->disassemble(bits)).first;
+  return it->second;
+}
+
+void dasm_filter_t::filter_line(const char* s, size_t len, std::string& out)
+{
+  const char* end = s + len;
+  const char* copied = s;
+  for (const char* p = s; (p = (const char*)memmem(p, end - p, "DASM(", 5)) != NULL; )
+  {
+    const char* start = p;
+
+    p += strlen("DASM(");
+
+    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+      p += 2;
+
+    if (!isxdigit(*p))
+      continue;
+
+    char* endp;
+    int64_t bits = strtoull(p, &endp, 16);
+    if (*endp != ')')
+      continue;
+
+    size_t nbits = 4 * (endp - p);
+    if (nbits < 64)
+      bits = bits << (64 - nbits) >> (64 - nbits);
+
+    out.append(copied, start - copied);
+    out += disassemble(bits);
+    copied = p = endp + 1;
+  }
+  out.append(copied, end - copied);
+}
+
+bool dasm_filter_t::flush(FILE* out)
+{
+  size_t n = fwrite(buf.data(), 1, buf.size(), out);
+  bool ok = n == buf.size();
+  buf.clear();
+  return ok;
+}
@@ -0,0 +1,40 @@
+// See LICENSE for license details.
+
+#ifndef _DASM_FILTER_H
+#define _DASM_FILTER_H
+
+#include "disasm.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+// Replaces strings like DASM(ffabc013) with the disassembly of the enclosed
+// instruction. Traces execute the same few instructions over and over again,
+// so the disassembly of every instruction word is cached. A filter must only
+// be used by one thread at a time, but several filters may share one
+// disassembler.
+class dasm_filter_t
+{
+ public:
+  dasm_filter_t(const disassembler_t* disassembler);
+  ~dasm_filter_t();
+
+  // Filter a whole stream, returns false on I/O errors
+  bool process(FILE* in, FILE* out);
+
+  // Append a line with all DASM(...) strings replaced to out
+  void filter_line(const char* s, size_t len, std::string& out);
+
+ private:
+  const disassembler_t* disassembler;
+  std::unordered_map<uint64_t, std::string> cache;
+  std::string buf;
+  char* line;
+  size_t line_size;
+
+  const std::string& disassemble(int64_t bits);
+  bool flush(FILE* out);
+};
+
+#endif
@@ -0,0 +1,167 @@
+// See LICENSE for license details.
+
+// This program converts the binary traces written by MemPool's Snitch tracer
+// (trace_hart_0x*.strace) back to the text format of the RTL tracer, i.e.,
+//  <time> <cycle> 0x<pc> DASM(<insn>) #; {'source': 0x..., ...}
+// such that they can be post-processed by gen_trace.py. With --disassemble,
+// the DASM(...) placeholder is replaced by the disassembled instruction, which
+// saves the separate pass through spike-dasm. Gzip-compressed traces are
+// decompressed on the fly.
+
+#include "disasm.h"
+#include "extension.h"
+#include "mempool_trace.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fesvr/option_parser.h>
+
+static void help(int exit_code = 1)
+{
+  fprintf(stderr, "usage: mempool-trace-decode [options] <trace>\n");
+  fprintf(stderr, "  --disassemble        Disassemble the instructions\n");
+  fprintf(stderr, "  --isa=<name>         ISA used for the disassembly [default %s]\n", DEFAULT_ISA);
+#ifdef HAVE_DLOPEN
+  fprintf(stderr, "  --extension=<name>   Disassemble the instructions of an extension\n");
+#endif
+  exit(exit_code);
+}
+
+// Open a trace, piping it through gzip if it is compressed
+static FILE* open_trace(const char* fn, bool* piped)
+{
+  FILE* f = fopen(fn, "rb");
+  if (!f)
+    return NULL;
+
+  unsigned char magic[2] = {0, 0};
+  size_t n = fread(magic, 1, sizeof(magic), f);
+  *piped = n == sizeof(magic) && magic[0] == 0x1f && magic[1] == 0x8b;
+  if (!*piped) {
+    rewind(f);
+    return f;
+  }
+
+  fclose(f);
+  std::string cmd = std::string("gzip -dc '") + fn + "'";
+  return popen(cmd.c_str(), "r");
+}
+
+static void print_record(const mempool_trace_record_t& r, disassembler_t* disassembler)
+{
+  char insn[32];
+  std::string dis;
+  if (disassembler) {
+    dis = disassembler->disassemble((int32_t)r.insn);
+  } else {
+    snprintf(insn, sizeof(insn), "DASM(%08" PRIx32 ")", r.insn);
+    dis = insn;
+  }
+
+  // Same field order and widths as the text tracer of mempool_cc.sv
+  printf("%10" PRIu64 " %8" PRIu64 " 0x%08" PRIx32 " %s #; {"
+         "'source': 0x%08x, 'stall': 0x%1x, 'stall_tot': 0x%08" PRIx32 ", "
+         "'stall_ins': 0x%08" PRIx32 ", 'stall_raw': 0x%08" PRIx32 ", "
+         "'stall_lsu': 0x%08" PRIx32 ", 'stall_acc': 0x%08" PRIx32 ", "
+         "'rs1': 0x%08x, 'rs2': 0x%08x, 'rd': 0x%08x, "
+         "'is_load': 0x%1x, 'is_store': 0x%1x, 'is_branch': 0x%1x, "
+         "'pc_d': 0x%08" PRIx32 ", 'opa': 0x%08" PRIx32 ", 'opb': 0x%08" PRIx32 ", "
+         "'opa_select': 0x%1x, 'opb_select': 0x%1x, 'opc_select': 0x%1x, "
+         "'write_rd': 0x%1x, 'csr_addr': 0x%03x, 'writeback': 0x%08" PRIx32 ", "
+         "'gpr_rdata_1': 0x%08" PRIx32 ", 'gpr_rdata_2': 0x%08" PRIx32 ", "
+         "'ls_size': 0x%1x, 'ld_result_32': 0x%08" PRIx32 ", 'lsu_rd': 0x%02x, "
+         "'retire_load': 0x%1x, 'alu_result': 0x%08" PRIx32 ", 'ls_amo': 0x%1x, "
+         "'retire_acc': 0x%1x, 'acc_pid': 0x%02x, 'acc_pdata_32': 0x%08" PRIx32 ", }\n",
+         r.time, r.cycle, r.pc, dis.c_str(),
+         r.source, !!(r.flags & MEMPOOL_TRACE_STALL), r.stall_tot,
+         r.stall_ins, r.stall_raw, r.stall_lsu, r.stall_acc,
+         r.rs1, r.rs2, r.rd,
+         !!(r.flags & MEMPOOL_TRACE_IS_LOAD), !!(r.flags & MEMPOOL_TRACE_IS_STORE),
+         !!(r.flags & MEMPOOL_TRACE_IS_BRANCH),
+         r.pc_d, r.opa, r.opb,
+         r.opa_select, r.opb_select, r.opc_select,
+         !!(r.flags & MEMPOOL_TRACE_WRITE_RD), r.csr_addr, r.writeback,
+         r.gpr_rdata_1, r.gpr_rdata_2,
+         r.ls_size, r.ld_result_32, r.lsu_rd,
+         !!(r.flags & MEMPOOL_TRACE_RETIRE_LOAD), r.alu_result, r.ls_amo,
+         !!(r.flags & MEMPOOL_TRACE_RETIRE_ACC), r.acc_pid, r.acc_pdata_32);
+}
+
+int main(int argc, char** argv)
+{
+  const char* isa = DEFAULT_ISA;
+  bool disassemble = false;
+
+  std::function<extension_t*()> extension;
+  option_parser_t parser;
+  parser.help([]() { help(); });
+  parser.option('h', 0, 0, [&](const char* s){help(0);});
+  parser.option(0, "disassemble", 0, [&](const char* s){disassemble = true;});
+#ifdef HAVE_DLOPEN
+  parser.option(0, "extension", 1, [&](const char* s){extension = find_extension(s);});
+#endif
+  parser.option(0, "isa", 1, [&](const char* s){isa = s;});
+  const char* const* args = parser.parse(argv);
+  if (!args[0] || args[1])
+    help();
+
+  disassembler_t* disassembler = NULL;
+  if (disassemble) {
+    std::string lowercase;
+    for (const char *p = isa; *p; p++)
+      lowercase += std::tolower(*p);
+
+    int xlen;
+    if (lowercase.compare(0, 4, "rv32") == 0) {
+      xlen = 32;
+    } else if (lowercase.compare(0, 4, "rv64") == 0) {
+      xlen = 64;
+    } else {
+      fprintf(stderr, "bad ISA string: %s\n", isa);
+      return 1;
+    }
+
+    disassembler = new disassembler_t(xlen);
+    if (extension) {
+      for (auto disasm_insn : extension()->get_disasms()) {
+        disassembler->add_insn(disasm_insn);
+      }
+    }
+  }
+
+  bool piped;
+  FILE* f = open_trace(args[0], &piped);
+  if (!f) {
+    fprintf(stderr, "could not open %s\n", args[0]);
+    return 1;
+  }
+
+  mempool_trace_header_t header;
+  if (fread(&header, sizeof(header), 1, f) != 1 ||
+      strncmp(header.magic, MEMPOOL_TRACE_MAGIC, sizeof(header.magic)) != 0) {
+    fprintf(stderr, "%s is not a MemPool binary trace\n", args[0]);
+    return 1;
+  }
+  if (header.version != MEMPOOL_TRACE_VERSION) {
+    fprintf(stderr, "%s has version %" PRIu32 ", expected %d\n", args[0],
+            header.version, MEMPOOL_TRACE_VERSION);
+    return 1;
+  }
+
+  // Decode in chunks, the records of a trace are written back-to-back
+  static mempool_trace_record_t records[4096];
+  size_t n;
+  while ((n = fread(records, sizeof(records[0]), 4096, f)) > 0) {
+    for (size_t i = 0; i < n; i++)
+      print_record(records[i], disassembler);
+  }
+
+  int status = piped ? pclose(f) : fclose(f);
+  if (status != 0) {
+    fprintf(stderr, "error while reading %s\n", args[0]);
+    return 1;
+  }
+  return 0;
+}
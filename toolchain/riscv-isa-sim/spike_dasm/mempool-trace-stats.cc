@@ -0,0 +1,1077 @@
+// See LICENSE for license details.
+
+// This program is a native implementation of MemPool's gen_trace.py. It reads
+// the annotated traces of Snitch harts, i.e., lines like
+//  <time> <cycle> 0x<pc> <insn> #; {'source': 0x..., 'stall': 0x..., ...}
+// and writes the same annotated trace and performance metrics as the script,
+// as well as the same CSV rows. Instructions that are still in the DASM(...)
+// form are disassembled on the fly, so the traces of the RTL tracer can be
+// processed without a separate spike-dasm pass.
+//
+// Each file is written to the --output-dir, named after the file without its
+// extension and with a .trace suffix, and --jobs files are processed
+// concurrently. Without file arguments, stdin is processed to stdout.
+// gen_trace.py remains the reference implementation; values that are not
+// valid hexadecimal numbers (e.g., Xs of the simulation) are read as zero.
+
+#include "dasm_filter.h"
+#include "disasm.h"
+#include "extension.h"
+#include <atomic>
+#include <cctype>
+#include <cinttypes>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <fesvr/option_parser.h>
+using namespace std;
+
+// Write the output once this many bytes are buffered
+static const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+
+// Below this absolute value: use signed int representation. Above: unsigned
+// 32-bit hex
+static const int64_t MAX_SIGNED_INT_LIT = 0xFFFF;
+
+static const char* REG_ABI_NAMES_I[32] = {
+  "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+  "s0", "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+  "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+  "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"
+};
+
+static const char* LS_SIZES[4] = {"Byte", "Half", "Word", "Doub"};
+
+enum { OPER_GPR = 1, OPER_CSR = 8 };
+
+enum { REGION_OTHER = 0, REGION_SEQUENTIAL = 1, REGION_INTERLEAVED = 2 };
+
+// RAW stall types
+enum { RAW_LSU, RAW_ACC, NUM_RAW_TYPES };
+static const char* RAW_TYPES[NUM_RAW_TYPES] = {"lsu", "acc"};
+
+// Keys of the tracer annotations, in the order of the tracer
+enum {
+  X_SOURCE, X_STALL, X_STALL_TOT, X_STALL_INS, X_STALL_RAW, X_STALL_LSU,
+  X_STALL_ACC, X_RS1, X_RS2, X_RD, X_IS_LOAD, X_IS_STORE, X_IS_BRANCH,
+  X_PC_D, X_OPA, X_OPB, X_OPA_SELECT, X_OPB_SELECT, X_OPC_SELECT,
+  X_WRITE_RD, X_CSR_ADDR, X_WRITEBACK, X_GPR_RDATA_1, X_GPR_RDATA_2,
+  X_LS_SIZE, X_LD_RESULT_32, X_LSU_RD, X_RETIRE_LOAD, X_ALU_RESULT,
+  X_LS_AMO, X_RETIRE_ACC, X_ACC_PID, X_ACC_PDATA_32, NUM_EXTRAS
+};
+static const char* EXTRAS_KEYS[NUM_EXTRAS] = {
+  "source", "stall", "stall_tot", "stall_ins", "stall_raw", "stall_lsu",
+  "stall_acc", "rs1", "rs2", "rd", "is_load", "is_store", "is_branch",
+  "pc_d", "opa", "opb", "opa_select", "opb_select", "opc_select",
+  "write_rd", "csr_addr", "writeback", "gpr_rdata_1", "gpr_rdata_2",
+  "ls_size", "ld_result_32", "lsu_rd", "retire_load", "alu_result",
+  "ls_amo", "retire_acc", "acc_pid", "acc_pdata_32"
+};
+
+// Counters of a section
+enum {
+  C_SNITCH_LOADS, C_SNITCH_STORES, C_SNITCH_ISSUES, C_STALL_TOT, C_STALL_INS,
+  C_STALL_RAW, C_STALL_RAW_LSU, C_STALL_RAW_ACC, C_STALL_LSU, C_STALL_ACC,
+  C_STALL_WFI, NUM_COUNTERS
+};
+static const char* COUNTER_KEYS[NUM_COUNTERS] = {
+  "snitch_loads", "snitch_stores", "snitch_issues", "stall_tot", "stall_ins",
+  "stall_raw", "stall_raw_lsu", "stall_raw_acc", "stall_lsu", "stall_acc",
+  "stall_wfi"
+};
+
+// Columns of the CSV file, including the duplicates of gen_trace.py
+static const char* CSV_KEYS[] = {
+  "core", "section", "start", "end", "cycles", "snitch_loads",
+  "snitch_stores", "snitch_avg_load_latency", "snitch_occupancy",
+  "snitch_load_latency", "total_ipc", "snitch_issues", "stall_tot",
+  "stall_ins", "stall_raw", "stall_raw_lsu", "stall_raw_acc", "stall_lsu",
+  "stall_acc", "stall_wfi", "seq_loads_local", "seq_loads_global",
+  "itl_loads_local", "itl_loads_global", "seq_latency_local",
+  "seq_latency_global", "itl_latency_local", "itl_latency_global",
+  "snitch_load_latency", "snitch_load_region", "snitch_load_tile",
+  "snitch_store_region", "snitch_store_region", "snitch_store_tile",
+  "seq_stores_local", "seq_stores_global", "itl_stores_local",
+  "itl_stores_global"
+};
+
+// Metrics only needed to compute others, omitted when printing
+static const char* PERF_EVAL_KEYS_OMIT[] = {
+  "section", "core", "start", "end", "snitch_load_latency",
+  "snitch_load_region", "snitch_load_tile", "snitch_store_region",
+  "snitch_store_tile"
+};
+
+// Architecture, read from the same environment variables as gen_trace.py
+struct arch_t
+{
+  double num_tiles;
+  double seq_mem_size;
+  double tcdm_size;
+};
+static arch_t arch;
+
+// -------------------- Formatting --------------------
+
+static string strprintf(const char* fmt, ...)
+{
+  char buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  return buf;
+}
+
+static string ljust(const string& s, size_t width)
+{
+  return s.size() >= width ? s : s + string(width - s.size(), ' ');
+}
+
+static string rjust(const string& s, size_t width)
+{
+  return s.size() >= width ? s : string(width - s.size(), ' ') + s;
+}
+
+static const char* reg_name(uint64_t reg)
+{
+  return reg < 32 ? REG_ABI_NAMES_I[reg] : "?";
+}
+
+static string int_lit(int64_t num, bool force_hex = false)
+{
+  uint32_t num_unsigned = num;
+  int32_t num_signed = num_unsigned;
+  if (force_hex || llabs(num_signed) > MAX_SIGNED_INT_LIT)
+    return strprintf("0x%08" PRIx32, num_unsigned);
+  return strprintf("%" PRId32, num_signed);
+}
+
+// Python's repr() of a float: the shortest representation that round-trips
+static string float_repr(double v)
+{
+  if (std::isnan(v))
+    return "nan";
+  if (std::isinf(v))
+    return v > 0 ? "inf" : "-inf";
+
+  char buf[32];
+  for (int prec = 1; prec <= 17; prec++) {
+    snprintf(buf, sizeof(buf), "%.*e", prec - 1, v);
+    if (strtod(buf, NULL) == v)
+      break;
+  }
+
+  // Split [-]d.ddde[+-]xx into sign, digits and exponent
+  string s(buf), sign, digits;
+  size_t e = s.find('e');
+  int exp = atoi(s.c_str() + e + 1);
+  for (size_t i = 0; i < e; i++) {
+    if (s[i] == '-')
+      sign = "-";
+    else if (isdigit(s[i]))
+      digits += s[i];
+  }
+
+  if (exp < -4 || exp >= 16) {
+    string mant = digits.substr(0, 1);
+    if (digits.size() > 1)
+      mant += "." + digits.substr(1);
+    return sign + mant + strprintf("e%c%02d", exp < 0 ? '-' : '+', abs(exp));
+  }
+  if (exp < 0)
+    return sign + "0." + string(-exp - 1, '0') + digits;
+  if (digits.size() <= (size_t)exp + 1)
+    return sign + digits + string(exp + 1 - digits.size(), '0') + ".0";
+  return sign + digits.substr(0, exp + 1) + "." + digits.substr(exp + 1);
+}
+
+static string flt_fmt(double v, int width)
+{
+  string s = float_repr(v);
+  if (s.size() - 1 <= (size_t)width)
+    return s;
+  return strprintf("%.*f", width, v);
+}
+
+// -------------------- Performance metrics --------------------
+
+// A metric in one of the types gen_trace.py stores
+struct metric_t
+{
+  enum kind_t { NONE, INT, FLOAT, LIST } kind;
+  int64_t i;
+  double f;
+  vector<int64_t> l;
+
+  metric_t() : kind(NONE), i(0), f(0) {}
+  static metric_t of_int(int64_t v) { metric_t m; m.kind = INT; m.i = v; return m; }
+  static metric_t of_float(double v) { metric_t m; m.kind = FLOAT; m.f = v; return m; }
+  static metric_t of_list(const vector<int64_t>& v) { metric_t m; m.kind = LIST; m.l = v; return m; }
+};
+
+typedef map<string, metric_t> metrics_t;
+
+struct section_t
+{
+  bool has_start;
+  int64_t start;
+  int64_t end;
+  int64_t section;
+  bool has_section;
+  int64_t counters[NUM_COUNTERS];
+  bool has_counter[NUM_COUNTERS];
+  vector<int64_t> load_latency, load_region, load_tile;
+  vector<int64_t> store_region, store_tile;
+
+  section_t() : has_start(false), start(0), end(0), section(0), has_section(false)
+  {
+    memset(counters, 0, sizeof(counters));
+    memset(has_counter, 0, sizeof(has_counter));
+  }
+
+  void add(int counter, int64_t value)
+  {
+    counters[counter] += value;
+    has_counter[counter] = true;
+  }
+};
+
+static void addr_to_meta(uint64_t address, int64_t* region, int64_t* tile)
+{
+  *region = REGION_OTHER;
+  *tile = -1;
+  if (address < arch.seq_mem_size * arch.num_tiles) {
+    *region = REGION_SEQUENTIAL;
+    *tile = address / (uint64_t)arch.seq_mem_size;
+  } else if (address < arch.tcdm_size) {
+    *region = REGION_INTERLEAVED;
+    *tile = (int64_t)fmod((double)(address / 64), arch.num_tiles);
+  }
+}
+
+static double mean(const vector<int64_t>& v, const vector<bool>* select = NULL)
+{
+  int64_t sum = 0;
+  size_t n = 0;
+  for (size_t i = 0; i < v.size(); i++) {
+    if (select && !(*select)[i])
+      continue;
+    sum += v[i];
+    n++;
+  }
+  return n ? (double)sum / n : NAN;
+}
+
+static metrics_t eval_perf_metrics(section_t& seg, int64_t core_id)
+{
+  int64_t tile_id = core_id >= 0 ? core_id / 4 : (core_id - 3) / 4;
+  metrics_t m;
+
+  m["start"] = metric_t::of_int(seg.start);
+  m["end"] = metric_t::of_int(seg.end);
+  if (seg.has_section)
+    m["section"] = metric_t::of_int(seg.section);
+
+  // Counters that are read when computing other metrics always exist
+  seg.has_counter[C_SNITCH_ISSUES] = true;
+  seg.has_counter[C_SNITCH_LOADS] = true;
+  seg.has_counter[C_SNITCH_STORES] = true;
+  for (int c = 0; c < NUM_COUNTERS; c++)
+    if (seg.has_counter[c])
+      m[COUNTER_KEYS[c]] = metric_t::of_int(seg.counters[c]);
+
+  int64_t cycles = seg.end - seg.start + 1;
+  if (seg.load_latency.empty()) {
+    m["snitch_load_latency"] = metric_t::of_int(0);
+    m["snitch_avg_load_latency"] = metric_t::of_float(0);
+  } else {
+    m["snitch_load_latency"] = metric_t::of_list(seg.load_latency);
+    m["snitch_avg_load_latency"] = metric_t::of_float(mean(seg.load_latency));
+  }
+  metric_t occupancy;
+  if (cycles)
+    occupancy = metric_t::of_float((double)seg.counters[C_SNITCH_ISSUES] / cycles);
+  m["snitch_occupancy"] = occupancy;
+  m["cycles"] = metric_t::of_int(cycles);
+  m["total_ipc"] = occupancy;
+
+  if (!seg.load_region.empty())
+    m["snitch_load_region"] = metric_t::of_list(seg.load_region);
+  if (!seg.load_tile.empty())
+    m["snitch_load_tile"] = metric_t::of_list(seg.load_tile);
+  if (!seg.store_region.empty())
+    m["snitch_store_region"] = metric_t::of_list(seg.store_region);
+  if (!seg.store_tile.empty())
+    m["snitch_store_tile"] = metric_t::of_list(seg.store_tile);
+
+  // Detailed load/store info
+  if (seg.counters[C_SNITCH_LOADS] > 0) {
+    size_t n = seg.load_region.size();
+    vector<bool> seq_local(n), seq_global(n), itl_local(n), itl_global(n);
+    int64_t num_seq_local = 0, num_seq_global = 0, num_itl_local = 0, num_itl_global = 0;
+    for (size_t i = 0; i < n; i++) {
+      bool local = seg.load_tile[i] == tile_id;
+      bool seq = seg.load_region[i] == REGION_SEQUENTIAL;
+      bool itl = seg.load_region[i] == REGION_INTERLEAVED;
+      num_seq_local += seq_local[i] = seq && local;
+      num_seq_global += seq_global[i] = seq && !local;
+      num_itl_local += itl_local[i] = itl && local;
+      num_itl_global += itl_global[i] = itl && !local;
+    }
+    m["seq_loads_local"] = metric_t::of_int(num_seq_local);
+    m["seq_loads_global"] = metric_t::of_int(num_seq_global);
+    m["itl_loads_local"] = metric_t::of_int(num_itl_local);
+    m["itl_loads_global"] = metric_t::of_int(num_itl_global);
+    m["seq_latency_local"] = metric_t::of_float(mean(seg.load_latency, &seq_local));
+    m["seq_latency_global"] = metric_t::of_float(mean(seg.load_latency, &seq_global));
+    m["itl_latency_local"] = metric_t::of_float(mean(seg.load_latency, &itl_local));
+    m["itl_latency_global"] = metric_t::of_float(mean(seg.load_latency, &itl_global));
+  }
+  if (seg.counters[C_SNITCH_STORES] > 0) {
+    int64_t num_seq_local = 0, num_seq_global = 0, num_itl_local = 0, num_itl_global = 0;
+    for (size_t i = 0; i < seg.store_region.size(); i++) {
+      bool local = seg.store_tile[i] == tile_id;
+      bool seq = seg.store_region[i] == REGION_SEQUENTIAL;
+      bool itl = seg.store_region[i] == REGION_INTERLEAVED;
+      num_seq_local += seq && local;
+      num_seq_global += seq && !local;
+      num_itl_local += itl && local;
+      num_itl_global += itl && !local;
+    }
+    m["seq_stores_local"] = metric_t::of_int(num_seq_local);
+    m["seq_stores_global"] = metric_t::of_int(num_seq_global);
+    m["itl_stores_local"] = metric_t::of_int(num_itl_local);
+    m["itl_stores_global"] = metric_t::of_int(num_itl_global);
+  }
+
+  m["core"] = metric_t::of_int(core_id);
+  return m;
+}
+
+static string fmt_perf_metrics(const metrics_t& m, size_t idx)
+{
+  string ret = "Performance metrics for section " + to_string(idx) + " @ (" +
+               to_string(m.at("start").i) + ", " + to_string(m.at("end").i) + "):";
+  for (auto& kv : m) {
+    bool omit = false;
+    for (auto key : PERF_EVAL_KEYS_OMIT)
+      omit |= kv.first == key;
+    if (omit)
+      continue;
+    string val;
+    switch (kv.second.kind) {
+      case metric_t::NONE: val = "None"; break;
+      case metric_t::INT: val = int_lit(kv.second.i); break;
+      case metric_t::FLOAT: val = flt_fmt(kv.second.f, 4); break;
+      case metric_t::LIST: val = "[...]"; break;
+    }
+    ret += "\n" + ljust(kv.first, 40) + rjust(val, 10);
+  }
+  return ret;
+}
+
+static string sanity_check_perf_metrics(const metrics_t& m)
+{
+  auto get = [&](const char* key) -> int64_t {
+    auto it = m.find(key);
+    return it != m.end() && it->second.kind == metric_t::INT ? it->second.i : 0;
+  };
+  int64_t sum_raw = get("stall_raw_acc") + get("stall_raw_lsu");
+  int64_t sum_tot = get("stall_ins") + get("stall_lsu") + get("stall_raw") + get("stall_wfi");
+  int64_t sum_cycle = get("stall_tot") + get("snitch_issues");
+
+  string ret;
+  if (sum_raw != get("stall_raw") && sum_raw != 0)
+    ret += "\nraw_stalls do not add up. Sum is " + to_string(sum_raw);
+  if (sum_tot != get("stall_tot") && sum_tot != 0)
+    ret += "\ntotal_stalls do not add up. Sum is " + to_string(sum_tot);
+  if (sum_cycle != get("cycles") && sum_cycle != 0)
+    ret += "\ncycles do not add up. Sum is " + to_string(sum_cycle);
+  return ret.empty() ? ret : "Sanity check failed!" + ret;
+}
+
+// One field of a CSV row, formatted and quoted like Python's csv module
+static string csv_field(const metrics_t& m, const char* key)
+{
+  auto it = m.find(key);
+  if (it == m.end())
+    return "";
+  const metric_t& v = it->second;
+  switch (v.kind) {
+    case metric_t::NONE: return "";
+    case metric_t::INT: return to_string(v.i);
+    case metric_t::FLOAT: return float_repr(v.f);
+    case metric_t::LIST: break;
+  }
+  string s = "[";
+  for (size_t i = 0; i < v.l.size(); i++)
+    s += (i ? ", " : "") + to_string(v.l[i]);
+  s += "]";
+  return v.l.size() > 1 ? "\"" + s + "\"" : s;
+}
+
+static string csv_header()
+{
+  string s;
+  for (size_t i = 0; i < sizeof(CSV_KEYS) / sizeof(CSV_KEYS[0]); i++)
+    s += (i ? "," : "") + string(CSV_KEYS[i]);
+  return s + "\r\n";
+}
+
+static string csv_row(const metrics_t& m)
+{
+  string s;
+  for (size_t i = 0; i < sizeof(CSV_KEYS) / sizeof(CSV_KEYS[0]); i++)
+    s += (i ? "," : "") + csv_field(m, CSV_KEYS[i]);
+  return s + "\r\n";
+}
+
+// -------------------- Parsing --------------------
+
+struct trace_line_t
+{
+  uint64_t time;
+  uint64_t cycle;
+  string pc;
+  string insn;
+  bool has_extras;
+  const char* extras;
+};
+
+static size_t skip_digits(const char* s, size_t i)
+{
+  while (isdigit(s[i]))
+    i++;
+  return i;
+}
+
+static size_t skip_space(const char* s, size_t i)
+{
+  while (s[i] && isspace(s[i]))
+    i++;
+  return i;
+}
+
+// Match TRACE_IN_REGEX of gen_trace.py, i.e.,
+//  (\d+)\s+(\d+)\s+(0x[0-9A-Fa-fz]+)\s+([^#;]*)(\s*#;\s*(.*))?
+// at the first possible position of the line
+static bool parse_line(const char* s, trace_line_t* l)
+{
+  for (size_t i = 0; s[i]; i++) {
+    size_t p = skip_digits(s, i);
+    if (p == i || !isspace(s[p]))
+      continue;
+    size_t q = skip_space(s, p);
+    size_t r = skip_digits(s, q);
+    if (r == q || !isspace(s[r]))
+      continue;
+    size_t pc = skip_space(s, r);
+    if (s[pc] != '0' || s[pc+1] != 'x')
+      continue;
+    size_t pc_end = pc + 2;
+    while (isxdigit(s[pc_end]) || s[pc_end] == 'z')
+      pc_end++;
+    if (pc_end == pc + 2 || !isspace(s[pc_end]))
+      continue;
+    size_t insn = skip_space(s, pc_end);
+    size_t insn_end = insn + strcspn(s + insn, "#;");
+
+    l->time = strtoull(s + i, NULL, 10);
+    l->cycle = strtoull(s + q, NULL, 10);
+    l->pc.assign(s + pc, pc_end - pc);
+    l->insn.assign(s + insn, insn_end - insn);
+    l->has_extras = s[insn_end] == '#' && s[insn_end+1] == ';';
+    l->extras = l->has_extras ? s + skip_space(s, insn_end + 2) : NULL;
+    return true;
+  }
+  return false;
+}
+
+// Read the `'key': 0x...` pairs of the annotations
+static bool read_annotations(const char* s, uint64_t* extras)
+{
+  bool valid = true;
+  memset(extras, 0, NUM_EXTRAS * sizeof(*extras));
+  int hint = 0;
+  for (const char* p = s; (p = strchr(p, '\'')) != NULL; ) {
+    const char* key = ++p;
+    const char* key_end = strchr(key, '\'');
+    if (!key_end)
+      break;
+    const char* v = key_end + 1;
+    while (isspace(*v))
+      v++;
+    if (*v != ':')
+      continue;
+    v++;
+    while (isspace(*v))
+      v++;
+    if (v[0] != '0' || v[1] != 'x')
+      continue;
+    p = key_end + 1;
+
+    // Keys are expected in the order of the tracer
+    size_t len = key_end - key;
+    int k = hint;
+    for (int n = 0; n < NUM_EXTRAS; n++, k = (k + 1) % NUM_EXTRAS)
+      if (strlen(EXTRAS_KEYS[k]) == len && strncmp(EXTRAS_KEYS[k], key, len) == 0)
+        break;
+    if (strlen(EXTRAS_KEYS[k]) != len || strncmp(EXTRAS_KEYS[k], key, len) != 0)
+      continue;
+    hint = (k + 1) % NUM_EXTRAS;
+
+    char* end;
+    extras[k] = strtoull(v + 2, &end, 16);
+    if (end == v + 2 || isalnum(*end))
+      valid = false;
+  }
+  return valid;
+}
+
+// -------------------- Annotation --------------------
+
+struct gpr_wb_t
+{
+  int64_t cycle;
+  uint64_t address;
+};
+
+// State of the annotation of one trace
+struct trace_state_t
+{
+  bool permissive;
+  bool force_hex_addr;
+  bool failed;
+  bool warned_xs;
+  pair<int64_t, int64_t> time_info;
+  int64_t prev_wfi_time;
+  int64_t retired_reg[NUM_RAW_TYPES];
+  // One FIFO per GPR of the loads in flight, and the GPRs in the order they
+  // were first written back to
+  deque<gpr_wb_t> gpr_wb_info[256];
+  vector<int> gpr_wb_order;
+  bool gpr_wb_used[256];
+  vector<section_t> perf_metrics;
+  string err;
+
+  trace_state_t() : permissive(false), force_hex_addr(true), failed(false),
+    warned_xs(false), time_info(0, 0), prev_wfi_time(0)
+  {
+    retired_reg[RAW_LSU] = retired_reg[RAW_ACC] = -1;
+    memset(gpr_wb_used, 0, sizeof(gpr_wb_used));
+    perf_metrics.push_back(section_t());
+  }
+
+  deque<gpr_wb_t>& gpr_wb(uint64_t reg)
+  {
+    reg &= 0xff;
+    if (!gpr_wb_used[reg]) {
+      gpr_wb_used[reg] = true;
+      gpr_wb_order.push_back(reg);
+    }
+    return gpr_wb_info[reg];
+  }
+};
+
+static string annotate_snitch(trace_state_t& st, const uint64_t* x, int64_t cycle,
+                              int64_t last_cycle, uint64_t pc)
+{
+  section_t& seg = st.perf_metrics.back();
+  vector<string> ret;
+  int64_t raw_stall[NUM_RAW_TYPES] = {0, 0};
+  if (!seg.has_start) {
+    seg.has_start = true;
+    seg.start = cycle - x[X_STALL_TOT];
+  }
+  // Regular linear datapath operation
+  if (!x[X_STALL]) {
+    // Check whether a register that is accessed was retired earlier
+    for (int k = 0; k < NUM_RAW_TYPES; k++)
+      for (int reg : {X_RS1, X_RS2, X_RD})
+        if ((int64_t)x[reg] == st.retired_reg[k])
+          raw_stall[k] = st.retired_reg[k];
+    // Operand registers
+    if (x[X_OPC_SELECT] == OPER_GPR && x[X_RD] != 0)
+      ret.push_back(ljust(reg_name(x[X_RD]), 3) + " = " + int_lit(x[X_GPR_RDATA_2]));
+    if (x[X_OPA_SELECT] == OPER_GPR && x[X_RS1] != 0)
+      ret.push_back(ljust(reg_name(x[X_RS1]), 3) + " = " + int_lit(x[X_OPA]));
+    if (x[X_OPB_SELECT] == OPER_GPR && x[X_RS2] != 0)
+      ret.push_back(ljust(reg_name(x[X_RS2]), 3) + " = " + int_lit(x[X_OPB]));
+    // CSR (always operand b)
+    if (x[X_OPB_SELECT] == OPER_CSR) {
+      uint64_t csr_addr = x[X_CSR_ADDR];
+      string csr;
+      switch (csr_addr) {
+        case 0xb00: csr = "mcycle"; break;
+        case 0xb02: csr = "minstret"; break;
+        case 0xf14: csr = "mhartid"; break;
+        case 0x7d0: csr = "trace"; break;
+        case 0x7d1: csr = "stacklimit"; break;
+        default: csr = strprintf("csr@%" PRIx64, csr_addr);
+      }
+      ret.push_back(csr + " = " + int_lit(x[X_OPB]));
+    }
+    // Load / Store
+    if (x[X_IS_LOAD]) {
+      seg.add(C_SNITCH_LOADS, 1);
+      st.gpr_wb(x[X_RD]).push_front(gpr_wb_t{cycle, x[X_ALU_RESULT]});
+      ret.push_back(ljust(reg_name(x[X_RD]), 3) + " <~~ " + LS_SIZES[x[X_LS_SIZE] & 3] +
+                    "[" + int_lit(x[X_ALU_RESULT], st.force_hex_addr) + "]");
+    } else if (x[X_IS_STORE]) {
+      seg.add(C_SNITCH_STORES, 1);
+      ret.push_back(int_lit(x[X_GPR_RDATA_1]) + " ~~> " + LS_SIZES[x[X_LS_SIZE] & 3] +
+                    "[" + int_lit(x[X_ALU_RESULT], st.force_hex_addr) + "]");
+      int64_t region, tile;
+      addr_to_meta(x[X_ALU_RESULT], &region, &tile);
+      seg.store_region.push_back(region);
+      seg.store_tile.push_back(tile);
+    } else if (x[X_IS_BRANCH]) {
+      ret.push_back(x[X_ALU_RESULT] ? "taken" : "not taken");
+    }
+    // Datapath (ALU / Jump Target / Bypass) register writeback
+    if (x[X_WRITE_RD] && x[X_RD] != 0)
+      ret.push_back("(wrb) " + ljust(reg_name(x[X_RD]), 3) + " <-- " + int_lit(x[X_WRITEBACK]));
+  }
+  // Retired loads and accelerator (includes FPU) data: can come back on stall
+  // and during other ops
+  if (x[X_RETIRE_LOAD]) {
+    deque<gpr_wb_t>& wb = st.gpr_wb(x[X_LSU_RD]);
+    if (!wb.empty()) {
+      gpr_wb_t load = wb.back();
+      wb.pop_back();
+      int64_t region, tile;
+      addr_to_meta(load.address, &region, &tile);
+      seg.load_latency.push_back(cycle - load.cycle);
+      seg.load_region.push_back(region);
+      seg.load_tile.push_back(tile);
+    } else {
+      st.err += strprintf("%s: In cycle %" PRId64 ", LSU attempts writeback to %s, "
+                          "but none in flight.\n", st.permissive ? "WARNING" : "FATAL",
+                          cycle, reg_name(x[X_LSU_RD]));
+      if (!st.permissive) {
+        st.failed = true;
+        return "";
+      }
+    }
+    ret.push_back("(lsu) " + ljust(reg_name(x[X_LSU_RD]), 3) + " <-- " + int_lit(x[X_LD_RESULT_32]));
+    st.retired_reg[RAW_LSU] = x[X_LSU_RD];
+  }
+  if (x[X_RETIRE_ACC] && x[X_ACC_PID] != 0) {
+    ret.push_back("(acc) " + ljust(reg_name(x[X_ACC_PID]), 3) + " <-- " + int_lit(x[X_ACC_PDATA_32]));
+    st.retired_reg[RAW_ACC] = x[X_ACC_PID];
+  }
+  // Any kind of PC change: Branch, Jump, etc.
+  if (!x[X_STALL] && x[X_PC_D] != pc + 4)
+    ret.push_back("goto " + int_lit(x[X_PC_D]));
+  // Count stalls, but only in cycles that execute an instruction
+  if (!x[X_STALL]) {
+    if (x[X_STALL_TOT]) {
+      ret.push_back("// stall " + to_string(x[X_STALL_TOT]) + " cycles");
+      seg.add(C_STALL_TOT, x[X_STALL_TOT]);
+      if (x[X_STALL_INS]) {
+        seg.add(C_STALL_INS, x[X_STALL_INS]);
+        ret.push_back("(" + to_string(x[X_STALL_INS]) + " ins)");
+      }
+      if (x[X_STALL_RAW]) {
+        seg.add(C_STALL_RAW, x[X_STALL_RAW]);
+        ret.push_back("(" + to_string(x[X_STALL_RAW]) + " raw");
+        for (int k = 0; k < NUM_RAW_TYPES; k++) {
+          if (raw_stall[k] > 0) {
+            ret.push_back(string(RAW_TYPES[k]) + ":" + reg_name(raw_stall[k]) + ")");
+            seg.add(k == RAW_LSU ? C_STALL_RAW_LSU : C_STALL_RAW_ACC, x[X_STALL_RAW]);
+          }
+        }
+      }
+      if (x[X_STALL_LSU]) {
+        seg.add(C_STALL_LSU, x[X_STALL_LSU]);
+        ret.push_back("(" + to_string(x[X_STALL_LSU]) + " lsu)");
+      }
+      if (x[X_STALL_ACC]) {
+        seg.add(C_STALL_ACC, x[X_STALL_ACC]);
+        ret.push_back("(" + to_string(x[X_STALL_ACC]) + " acc)");
+      }
+      if (st.prev_wfi_time != 0) {
+        seg.add(C_STALL_WFI, cycle - st.prev_wfi_time - 1);
+        ret.push_back("(" + to_string(cycle - st.prev_wfi_time - 1) + " wfi)");
+      }
+    } else if (x[X_STALL_INS] || x[X_STALL_RAW] || x[X_STALL_LSU] || x[X_STALL_ACC]) {
+      ret.push_back("// Missed specific stall!!!");
+    } else if (cycle - last_cycle > 1) {
+      // Check if we did not skip a cycle, otherwise we probably had an
+      // undetected stall
+      ret.push_back("// Potentially missed stall cycle (" + to_string(cycle - last_cycle - 1) +
+                    " cycles)!!!");
+    }
+    // Reset the retired registers, since we executed an instruction
+    st.retired_reg[RAW_LSU] = st.retired_reg[RAW_ACC] = -1;
+  }
+
+  string s;
+  for (size_t i = 0; i < ret.size(); i++)
+    s += (i ? ", " : "") + ret[i];
+  return s;
+}
+
+static string trim(const string& s)
+{
+  size_t b = 0, e = s.size();
+  while (b < e && isspace(s[b]))
+    b++;
+  while (e > b && isspace(s[e-1]))
+    e--;
+  return s.substr(b, e - b);
+}
+
+// Annotate one line, returns false if it is omitted
+static bool annotate_insn(trace_state_t& st, const char* line, string& out)
+{
+  trace_line_t l;
+  if (!parse_line(line, &l)) {
+    st.err += string("Not a valid trace line:\n") + line + "\n";
+    st.failed = true;
+    return false;
+  }
+  pair<int64_t, int64_t> last_time_info = st.time_info;
+  pair<int64_t, int64_t> time_info(l.time, l.cycle);
+  bool show_time_info = time_info != last_time_info;
+  string time_str = show_time_info ? to_string(time_info.first) : "";
+  string cycle_str = show_time_info ? to_string(time_info.second) : "";
+
+  // Vanilla trace
+  if (!l.has_extras) {
+    out += rjust(time_str, 8) + " " + rjust(cycle_str, 8) + " " + rjust(l.pc, 10) + " " +
+           ljust(l.insn, 30) + "\n";
+    st.time_info = time_info;
+    st.prev_wfi_time = 0;
+    return true;
+  }
+
+  // Annotated trace
+  uint64_t x[NUM_EXTRAS];
+  if (!read_annotations(l.extras, x) && !st.warned_xs) {
+    st.err += "WARNING: Trace contains Xs!\n";
+    st.warned_xs = true;
+  }
+  string annot = annotate_snitch(st, x, time_info.second, last_time_info.second,
+                                 strtoull(l.pc.c_str(), NULL, 16));
+  if (st.failed)
+    return false;
+  string insn = l.insn, pc = l.pc;
+  if (x[X_STALL]) {
+    insn = pc = "";
+  } else {
+    st.perf_metrics.back().add(C_SNITCH_ISSUES, 1);
+  }
+  // Omit empty trace lines (due to double stalls, performance measures)
+  bool empty = insn.empty() && annot.empty();
+  if (empty)
+    time_info = last_time_info;
+  // If wfi, remember when we went to sleep
+  st.prev_wfi_time = trim(insn) == "wfi" ? time_info.second : 0;
+  st.time_info = time_info;
+  if (empty)
+    return false;
+  out += rjust(time_str, 8) + " " + rjust(cycle_str, 8) + " " + rjust(pc, 10) + " " +
+         ljust(insn, 30) + " #; " + annot + "\n";
+  return true;
+}
+
+// -------------------- Main --------------------
+
+struct trace_file_t
+{
+  const char* in_path;
+  string out_path;
+  string csv_path;
+  vector<string> csv_rows;
+  bool ok;
+};
+
+static bool write_all(FILE* f, string& buf)
+{
+  bool ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+  buf.clear();
+  return ok;
+}
+
+static void process_trace(trace_file_t& tf, dasm_filter_t& filter, bool permissive,
+                          bool force_hex_addr, const char* csv, mutex& err_lock)
+{
+  trace_state_t st;
+  st.permissive = permissive;
+  st.force_hex_addr = force_hex_addr;
+  tf.ok = false;
+
+  FILE* in = tf.in_path ? fopen(tf.in_path, "r") : stdin;
+  string name = tf.in_path ? tf.in_path : "<stdin>";
+  if (!in) {
+    lock_guard<mutex> guard(err_lock);
+    fprintf(stderr, "could not open %s\n", tf.in_path);
+    return;
+  }
+  FILE* out = tf.out_path.empty() ? stdout : fopen(tf.out_path.c_str(), "w");
+  if (!out) {
+    lock_guard<mutex> guard(err_lock);
+    fprintf(stderr, "could not open %s\n", tf.out_path.c_str());
+    fclose(in);
+    return;
+  }
+
+  // The core is identified by the first hexadecimal or decimal number of the
+  // file name
+  string dir, filename = name;
+  size_t slash = name.find_last_of('/');
+  if (slash != string::npos) {
+    dir = name.substr(0, slash);
+    filename = name.substr(slash + 1);
+  }
+  int64_t core_id = -1;
+  size_t hex = filename.find("0x");
+  while (hex != string::npos && !isxdigit(filename[hex+2]))
+    hex = filename.find("0x", hex + 1);
+  if (hex != string::npos) {
+    core_id = strtoll(filename.c_str() + hex, NULL, 16);
+  } else {
+    size_t dec = filename.find_first_of("0123456789");
+    if (dec != string::npos)
+      core_id = strtoll(filename.c_str() + dec, NULL, 10);
+  }
+
+  string buf, line;
+  buf.reserve(OUTPUT_BUFFER_SIZE + 4096);
+  char* raw = NULL;
+  size_t raw_size = 0;
+  ssize_t len;
+  size_t section = 0;
+  bool io_ok = true;
+  while (!st.failed && (len = getline(&raw, &raw_size, in)) >= 0) {
+    size_t b = 0;
+    while (len > 0 && raw[len-1] == '\n')
+      raw[--len] = '\0';
+    while (raw[b] == '\n')
+      b++;
+    line.clear();
+    filter.filter_line(raw + b, len - b, line);
+
+    bool printed = annotate_insn(st, line.c_str(), buf);
+    if (st.failed)
+      break;
+    section_t& first = st.perf_metrics.front();
+    if (!first.has_start) {
+      first.has_start = true;
+      first.start = st.time_info.second;
+    }
+    // Start a new benchmark section after 'csrw trace' instruction
+    if (line.find("trace") != string::npos || line.find("mcycle") != string::npos) {
+      st.perf_metrics.back().end = st.time_info.second;
+      st.perf_metrics.push_back(section_t());
+      st.perf_metrics.back().section = section++;
+      st.perf_metrics.back().has_section = true;
+    }
+    (void)printed;
+    if (buf.size() >= OUTPUT_BUFFER_SIZE)
+      io_ok &= write_all(out, buf);
+  }
+  free(raw);
+  io_ok &= !ferror(in);
+  if (in != stdin)
+    fclose(in);
+
+  if (!st.failed) {
+    st.perf_metrics.back().end = st.time_info.second;
+    // Remove last empty entry
+    if (!st.perf_metrics.back().has_start)
+      st.perf_metrics.pop_back();
+    if (st.perf_metrics.empty() || !st.perf_metrics.front().has_start) {
+      st.err += "WARNING: Empty trace file (" + name + ").\n";
+    } else {
+      buf += "\n## Performance metrics\n";
+      for (size_t idx = 0; idx < st.perf_metrics.size(); idx++) {
+        metrics_t m = eval_perf_metrics(st.perf_metrics[idx], core_id);
+        buf += "\n" + fmt_perf_metrics(m, idx) + "\n";
+        string sanity = sanity_check_perf_metrics(m);
+        if (!sanity.empty())
+          buf += "\n" + sanity + "\n";
+        m["section"] = metric_t::of_int(idx);
+        tf.csv_rows.push_back(csv_row(m));
+      }
+      if (csv) {
+        tf.csv_path = csv;
+        if (tf.csv_path.find('/') == string::npos && !dir.empty())
+          tf.csv_path = dir + "/" + tf.csv_path;
+        buf += "\nWrote performance metrics to " + tf.csv_path + "\n\n";
+      }
+      // Check for any loose ends and warn before exiting
+      bool warn_trip = false;
+      for (int reg : st.gpr_wb_order) {
+        if (!st.gpr_wb_info[reg].empty()) {
+          warn_trip = true;
+          st.err += strprintf("WARNING: %zu transactions still in flight for %s.\n",
+                              st.gpr_wb_info[reg].size(), reg_name(reg));
+        }
+      }
+      if (warn_trip)
+        st.err += "WARNING: Inconsistent final state; performance metrics may "
+                  "be inaccurate. Is this trace complete?\n\n";
+    }
+  }
+
+  io_ok &= write_all(out, buf);
+  if (out != stdout)
+    io_ok &= fclose(out) == 0;
+  else
+    fflush(out);
+
+  lock_guard<mutex> guard(err_lock);
+  fputs(st.err.c_str(), stderr);
+  if (!io_ok)
+    fprintf(stderr, "error while processing %s\n", name.c_str());
+  tf.ok = io_ok && !st.failed;
+}
+
+static void help()
+{
+  fprintf(stderr, "usage: mempool-trace-stats [options] [<trace>...]\n");
+  fprintf(stderr, "  -p, --permissive     Ignore some state-related issues when they occur\n");
+  fprintf(stderr, "  -s, --saddr          Use signed decimal (not unsigned hex) for small addresses\n");
+  fprintf(stderr, "      --csv=<file>     Append the performance metrics to a CSV file\n");
+  fprintf(stderr, "      --output-dir=<d> Write the annotated traces to <d>/<trace>.trace\n");
+  fprintf(stderr, "      --jobs=<n>       Process <n> traces concurrently\n");
+  fprintf(stderr, "      --isa=<name>     ISA used for the disassembly [default %s]\n", DEFAULT_ISA);
+#ifdef HAVE_DLOPEN
+  fprintf(stderr, "      --extension=<n>  Disassemble the instructions of an extension\n");
+#endif
+  exit(1);
+}
+
+// Output file of an input file: its name without directory and extension
+static string output_path(const string& dir, const string& in)
+{
+  string name = in.substr(in.find_last_of('/') + 1);
+  size_t dot = name.find_last_of('.');
+  if (dot != string::npos && dot != 0)
+    name = name.substr(0, dot);
+  return dir + "/" + name + ".trace";
+}
+
+int main(int argc, char** argv)
+{
+  const char* isa = DEFAULT_ISA;
+  const char* output_dir = NULL;
+  const char* csv = NULL;
+  bool permissive = false;
+  bool saddr = false;
+  unsigned jobs = thread::hardware_concurrency();
+
+  std::function<extension_t*()> extension;
+  option_parser_t parser;
+  parser.help(&help);
+#ifdef HAVE_DLOPEN
+  parser.option(0, "extension", 1, [&](const char* s){extension = find_extension(s);});
+#endif
+  parser.option(0, "isa", 1, [&](const char* s){isa = s;});
+  parser.option('p', "permissive", 0, [&](const char* s){permissive = true;});
+  parser.option('s', "saddr", 0, [&](const char* s){saddr = true;});
+  parser.option(0, "csv", 1, [&](const char* s){csv = s;});
+  parser.option('j', "jobs", 1, [&](const char* s){jobs = atoi(s);});
+  parser.option('o', "output-dir", 1, [&](const char* s){output_dir = s;});
+  const char* const* files = parser.parse(argv);
+
+  std::string lowercase;
+  for (const char *p = isa; *p; p++)
+    lowercase += std::tolower(*p);
+
+  int xlen;
+  if (lowercase.compare(0, 4, "rv32") == 0) {
+    xlen = 32;
+  } else if (lowercase.compare(0, 4, "rv64") == 0) {
+    xlen = 64;
+  } else {
+    fprintf(stderr, "bad ISA string: %s\n", isa);
+    return 1;
+  }
+
+  disassembler_t* disassembler = new disassembler_t(xlen);
+  if (extension) {
+    for (auto disasm_insn : extension()->get_disasms()) {
+      disassembler->add_insn(disasm_insn);
+    }
+  }
+
+  // Same environment variables and defaults as gen_trace.py
+  const char* num_cores = getenv("num_cores");
+  const char* seq_mem_size = getenv("seq_mem_size");
+  arch.num_tiles = (num_cores ? atoi(num_cores) : 256) / 4.0;
+  arch.seq_mem_size = 4 * (seq_mem_size ? atoi(seq_mem_size) : 1024);
+  arch.tcdm_size = 16 * 1024 * arch.num_tiles;
+
+  vector<trace_file_t> traces;
+  for (const char* const* f = files; *f; f++) {
+    trace_file_t tf;
+    tf.in_path = *f;
+    if (output_dir)
+      tf.out_path = output_path(output_dir, *f);
+    traces.push_back(tf);
+  }
+  if (traces.empty()) {
+    trace_file_t tf;
+    tf.in_path = NULL;
+    traces.push_back(tf);
+  }
+
+  // Annotated traces on stdout are processed one after the other
+  if (jobs < 1 || !output_dir)
+    jobs = 1;
+  if (jobs > traces.size())
+    jobs = traces.size();
+
+  atomic<size_t> next_trace(0);
+  mutex err_lock;
+  auto worker = [&]() {
+    dasm_filter_t filter(disassembler);
+    for (size_t i; (i = next_trace.fetch_add(1)) < traces.size(); )
+      process_trace(traces[i], filter, permissive, !saddr, csv, err_lock);
+  };
+
+  vector<thread> workers;
+  for (unsigned i = 1; i < jobs; i++)
+    workers.emplace_back(worker);
+  worker();
+  for (auto& t : workers)
+    t.join();
+
+  // Append the CSV rows in the order of the traces
+  bool ok = true;
+  for (auto& tf : traces) {
+    ok &= tf.ok;
+    if (tf.csv_rows.empty() || tf.csv_path.empty())
+      continue;
+    struct stat st;
+    bool write_header = stat(tf.csv_path.c_str(), &st) != 0;
+    FILE* f = fopen(tf.csv_path.c_str(), "a");
+    if (!f) {
+      fprintf(stderr, "could not open %s\n", tf.csv_path.c_str());
+      ok = false;
+      continue;
+    }
+    if (write_header)
+      fputs(csv_header().c_str(), f);
+    for (auto& row : tf.csv_rows)
+      fputs(row.c_str(), f);
+    ok &= fclose(f) == 0;
+  }
+
+  return ok ? 0 : 1;
+}
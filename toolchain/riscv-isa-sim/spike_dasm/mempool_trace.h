@@ -0,0 +1,70 @@
+// See LICENSE for license details.
+
+#ifndef _MEMPOOL_TRACE_H
+#define _MEMPOOL_TRACE_H
+
+#include <stdint.h>
+
+// Binary trace format of MemPool's Snitch tracer. This mirrors
+// hardware/tb/dpi/snitch_trace.h of the MemPool repository, keep both in sync.
+
+#define MEMPOOL_TRACE_MAGIC "SNTRACE"
+#define MEMPOOL_TRACE_VERSION 1
+
+struct mempool_trace_header_t
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t hart_id;
+};
+
+enum {
+  MEMPOOL_TRACE_STALL = 1 << 0,
+  MEMPOOL_TRACE_IS_LOAD = 1 << 1,
+  MEMPOOL_TRACE_IS_STORE = 1 << 2,
+  MEMPOOL_TRACE_IS_BRANCH = 1 << 3,
+  MEMPOOL_TRACE_WRITE_RD = 1 << 4,
+  MEMPOOL_TRACE_RETIRE_LOAD = 1 << 5,
+  MEMPOOL_TRACE_RETIRE_ACC = 1 << 6,
+};
+
+struct mempool_trace_record_t
+{
+  uint64_t time;
+  uint64_t cycle;
+  uint32_t pc;
+  uint32_t insn;
+  uint32_t pc_d;
+  uint32_t opa;
+  uint32_t opb;
+  uint32_t writeback;
+  uint32_t gpr_rdata_1;
+  uint32_t gpr_rdata_2;
+  uint32_t ld_result_32;
+  uint32_t alu_result;
+  uint32_t acc_pdata_32;
+  uint32_t stall_tot;
+  uint32_t stall_ins;
+  uint32_t stall_raw;
+  uint32_t stall_lsu;
+  uint32_t stall_acc;
+  uint16_t csr_addr;
+  uint8_t rs1;
+  uint8_t rs2;
+  uint8_t rd;
+  uint8_t lsu_rd;
+  uint8_t acc_pid;
+  uint8_t ls_size;
+  uint8_t source;
+  uint8_t opa_select;
+  uint8_t opb_select;
+  uint8_t opc_select;
+  uint8_t ls_amo;
+  uint8_t flags;
+  uint8_t reserved[2];
+};
+
+static_assert(sizeof(mempool_trace_header_t) == 16, "bad trace header size");
+static_assert(sizeof(mempool_trace_record_t) == 96, "bad trace record size");
+
+#endif
@@ -5,19 +5,65 @@
 // in its input, then replaces them with the disassembly
 // enclosed hexadecimal number, interpreted as a RISC-V
 // instruction.
+//
+// Without file arguments, it filters stdin to stdout. Otherwise, each file
+// is disassembled to the --output-dir, named after the file without its
+// extension, and --jobs files are processed concurrently.
 
+#include "dasm_filter.h"
 #include "disasm.h"
 #include "extension.h"
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
 #include <fesvr/option_parser.h>
 using namespace std;
 
+// Output file of an input file: its name without directory and extension
+static string output_path(const string& dir, const string& in)
+{
+  string name = in.substr(in.find_last_of('/') + 1);
+  size_t dot = name.find_last_of('.');
+  if (dot != string::npos && dot != 0)
+    name = name.substr(0, dot);
+  return dir + "/" + name;
+}
+
+static bool process_file(dasm_filter_t& filter, const char* in_path, const string& out_path)
+{
+  FILE* in = fopen(in_path, "r");
+  if (!in) {
+    fprintf(stderr, "could not open %s\n", in_path);
+    return false;
+  }
+
+  FILE* out = out_path.empty() ? stdout : fopen(out_path.c_str(), "w");
+  if (!out) {
+    fprintf(stderr, "could not open %s\n", out_path.c_str());
+    fclose(in);
+    return false;
+  }
+
+  bool ok = filter.process(in, out);
+  fclose(in);
+  if (out != stdout)
+    ok = fclose(out) == 0 && ok;
+  if (!ok)
+    fprintf(stderr, "error while disassembling %s\n", in_path);
+  return ok;
+}
+
 int main(int argc, char** argv)
 {
-  string s;
   const char* isa = DEFAULT_ISA;
+  const char* output_dir = NULL;
+  unsigned jobs = thread::hardware_concurrency();
 
   std::function<extension_t*()> extension;
   option_parser_t parser;
@@ -25,7 +71,9 @@ int main(int argc, char** argv)
   parser.option(0, "extension", 1, [&](const char* s){extension = find_extension(s);});
 #endif
   parser.option(0, "isa", 1, [&](const char* s){isa = s;});
-  parser.parse(argv);
+  parser.option('j', "jobs", 1, [&](const char* s){jobs = atoi(s);});
+  parser.option('o', "output-dir", 1, [&](const char* s){output_dir = s;});
+  const char* const* files = parser.parse(argv);
 
   std::string lowercase;
   for (const char *p = isa; *p; p++)
@@ -48,36 +96,46 @@ int main(int argc, char** argv)
     }
   }
 
-  while (getline(cin, s))
-  {
-    for (size_t pos = 0; (pos = s.find("DASM(", pos)) != string::npos; )
-    {
-      size_t start = pos;
-
-      pos += strlen("DASM(");
-
-      if (s[pos] == '0' && (s[pos+1] == 'x' || s[pos+1] == 'X'))
-        pos += 2;
-
-      if (!isxdigit(s[pos]))
-        continue;
-
-      char* endp;
-      int64_t bits = strtoull(&s[pos], &endp, 16);
-      if (*endp != ')')
-        continue;
-
-      size_t nbits = 4 * (endp - &s[pos]);
-      if (nbits < 64)
-        bits = bits << (64 - nbits) >> (64 - nbits);
-
-      string dis = disassembler->disassemble(bits);
-      s = s.substr(0, start) + dis + s.substr(endp - &s[0] + 1);
-      pos = start + dis.length();
-    }
+  // Filter stdin to stdout
+  if (!files[0]) {
+    dasm_filter_t filter(disassembler);
+    return filter.process(stdin, stdout) ? 0 : 1;
+  }
 
-    cout << s << '\n';
+  // Concatenate the files on stdout
+  if (!output_dir) {
+    dasm_filter_t filter(disassembler);
+    bool ok = true;
+    for (const char* const* f = files; *f; f++)
+      ok = process_file(filter, *f, "") && ok;
+    return ok ? 0 : 1;
   }
 
-  return 0;
+  // Disassemble the files concurrently. The disassembler is only read, every
+  // worker has its own cache and output buffer.
+  size_t num_files = 0;
+  while (files[num_files])
+    num_files++;
+  if (jobs < 1)
+    jobs = 1;
+  if (jobs > num_files)
+    jobs = num_files;
+
+  atomic<size_t> next_file(0);
+  atomic<bool> ok(true);
+  auto worker = [&]() {
+    dasm_filter_t filter(disassembler);
+    for (size_t i; (i = next_file.fetch_add(1)) < num_files; )
+      if (!process_file(filter, files[i], output_path(output_dir, files[i])))
+        ok = false;
+  };
+
+  vector<thread> workers;
+  for (unsigned i = 1; i < jobs; i++)
+    workers.emplace_back(worker);
+  worker();
+  for (auto& t : workers)
+    t.join();
+
+  return ok ? 0 : 1;
 }
@@ -0,0 +1,113 @@
+// See LICENSE for license details.
+
+// This little program converts a binary commit log of
+//   spike --log-commits-binary=<file>
+// into the text log of --log-commits, i.e., lines like
+//   core   0: 3 0x0000000080000000 (0xf14022f3) x 5 0x0000000000000000
+// optionally only those of one hart.
+
+#include "commit_log.h"
+#include "disasm.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <fesvr/option_parser.h>
+
+static void help(int exit_code = 1)
+{
+  fprintf(stderr, "usage: spike-commit-log [--hart=<n>] <file>\n");
+  exit(exit_code);
+}
+
+// Like commit_log_print_value of riscv/execute.cc
+static void print_value(FILE* out, int width, const uint64_t* data)
+{
+  switch (width) {
+    case 8:
+      fprintf(out, "0x%01" PRIx8, (uint8_t)data[0]);
+      break;
+    case 16:
+      fprintf(out, "0x%04" PRIx16, (uint16_t)data[0]);
+      break;
+    case 32:
+      fprintf(out, "0x%08" PRIx32, (uint32_t)data[0]);
+      break;
+    case 64:
+      fprintf(out, "0x%016" PRIx64, data[0]);
+      break;
+    default:
+      fprintf(out, "0x");
+      for (int idx = width / 64 - 1; idx >= 0; --idx)
+        fprintf(out, "%016" PRIx64, data[idx]);
+      break;
+  }
+}
+
+static void print_value(FILE* out, int width, uint64_t data)
+{
+  print_value(out, width, &data);
+}
+
+static void print_insn(FILE* out, const commit_log_insn_t& insn)
+{
+  fprintf(out, "core%4" PRIu32 ": ", insn.hart);
+  fprintf(out, "%1d ", insn.priv);
+  print_value(out, insn.xlen, insn.pc);
+  fprintf(out, " (");
+  print_value(out, insn.length * 8, insn.bits);
+  fprintf(out, ")");
+
+  for (auto& op : insn.operands) {
+    switch (op.type) {
+      case CL_VCONFIG:
+        fprintf(out, " e%u %s%u l%" PRIu64, op.width,
+                op.index & 0x8000 ? "mf" : "m", op.index & 0x7fff, op.value[0]);
+        break;
+      case CL_CSR:
+        fprintf(out, " c%u_%s ", op.index, csr_name(op.index));
+        print_value(out, op.width, op.value.data());
+        break;
+      case CL_XREG: case CL_FREG: case CL_VREG:
+        fprintf(out, " %c%2u ", op.type == CL_XREG ? 'x' : op.type == CL_FREG ? 'f' : 'v',
+                op.index);
+        print_value(out, op.width, op.value.data());
+        break;
+      case CL_LOAD: case CL_STORE:
+        fprintf(out, " mem ");
+        print_value(out, op.xlen, op.addr);
+        if (op.type == CL_STORE) {
+          fprintf(out, " ");
+          print_value(out, op.width * 8, op.value[0]);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  fprintf(out, "\n");
+}
+
+int main(int argc, char** argv)
+{
+  long hart = -1;
+  option_parser_t parser;
+  parser.help([]{ help(); });
+  parser.option('h', "help", 0, [&](const char* s){help(0);});
+  parser.option(0, "hart", 1, [&](const char* s){hart = strtol(s, 0, 0);});
+  auto argv1 = parser.parse(argv);
+  if (!argv1[0] || argv1[1])
+    help();
+
+  try {
+    commit_log_reader_t reader(argv1[0]);
+    commit_log_insn_t insn;
+    while (reader.next(insn))
+      if (hart < 0 || insn.hart == (uint32_t)hart)
+        print_insn(stdout, insn);
+  } catch (std::runtime_error& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -13,6 +13,7 @@
 #include <string>
 #include <memory>
 #include <fstream>
+#include <stdexcept>
 #include "../VERSION"
 
 static void help(int exit_code = 1)
@@ -20,13 +21,26 @@ static void help(int exit_code = 1)
   fprintf(stderr, "Spike RISC-V ISA Simulator " SPIKE_VERSION "\n\n");
   fprintf(stderr, "usage: spike [host options] <target program> [target options]\n");
   fprintf(stderr, "Host Options:\n");
-  fprintf(stderr, "  -p<n>                 Simulate <n> processors [default 1]\n");
+  fprintf(stderr, "  -p<n>                 Simulate <n> processors [default 1, or num_cores with --mempool]\n");
+  fprintf(stderr, "  --threads=<n>         Step the processors on <n> host threads [default 1]\n");
+  fprintf(stderr, "  --quantum=<n>         Run <n> instructions per processor between switches [default 5000]\n");
   fprintf(stderr, "  -m<n>                 Provide <n> MiB of target memory [default 2048]\n");
   fprintf(stderr, "  -m<a:m,b:n,...>       Provide memory regions of size m and n bytes\n");
   fprintf(stderr, "                          at base addresses a and b (with 4 KiB alignment)\n");
   fprintf(stderr, "  -d                    Interactive debug mode\n");
   fprintf(stderr, "  -g                    Track histogram of PCs\n");
+  fprintf(stderr, "  --profile=<prefix>    Sample the call stacks of the processors and write them\n");
+  fprintf(stderr, "                          for flame graphs to <prefix>_hart<i>.folded and\n");
+  fprintf(stderr, "                          <prefix>.folded\n");
+  fprintf(stderr, "  --profile-interval=<n>\n");
+  fprintf(stderr, "                        Sample every <n> instructions per processor [default 1000]\n");
   fprintf(stderr, "  -l                    Generate a log of execution\n");
+  fprintf(stderr, "  --log-commits-binary=<file>\n");
+  fprintf(stderr, "                        Write the commit log to <file> in a binary format,\n");
+  fprintf(stderr, "                          which spike-commit-log converts to text\n");
+  fprintf(stderr, "  --log-commits-codec=<codec>\n");
+  fprintf(stderr, "                        Compress the binary commit log with none, lz4\n");
+  fprintf(stderr, "                          or zstd [default none]\n");
   fprintf(stderr, "  -h, --help            Print this help message\n");
   fprintf(stderr, "  -H                    Start halted, allowing a debugger to connect\n");
   fprintf(stderr, "  --isa=<name>          RISC-V ISA string [default %s]\n", DEFAULT_ISA);
@@ -66,6 +80,24 @@ static void help(int exit_code = 1)
   fprintf(stderr, "  --dm-no-abstract-csr  Debug module won't support abstract to authenticate\n");
   fprintf(stderr, "  --dm-no-halt-groups   Debug module won't support halt groups\n");
   fprintf(stderr, "  --dm-no-impebreak     Debug module won't support implicit ebreak in program buffer\n");
+  fprintf(stderr, "  --mempool=<cfg>       Simulate MemPool's memory map, control registers and UART.\n");
+  fprintf(stderr, "                          <cfg> is a comma-separated list of a flavor (mempool,\n");
+  fprintf(stderr, "                          minpool, terapool) and parameters of config/config.mk,\n");
+  fprintf(stderr, "                          e.g., terapool,seq_mem_size=1024\n");
+  fprintf(stderr, "  --mempool-timing=<file>\n");
+  fprintf(stderr, "                        Estimate the cycles of MemPool's cores and write\n");
+  fprintf(stderr, "                          them per trace CSR section to a CSV file\n");
+  fprintf(stderr, "  --perf-counters=<file>\n");
+  fprintf(stderr, "                        Count the instructions, accesses and stalls of\n");
+  fprintf(stderr, "                          MemPool's cores per trace CSR section and write\n");
+  fprintf(stderr, "                          them to a CSV file like gen_trace.py\n");
+  fprintf(stderr, "  --tcdm-model=<prefix> Count the accesses of MemPool's cores to the L1 banks\n");
+  fprintf(stderr, "                          and write them per bank and per code region to\n");
+  fprintf(stderr, "                          <prefix>_banks.csv and <prefix>_regions.csv\n");
+  fprintf(stderr, "  --icache-model=<prefix>\n");
+  fprintf(stderr, "                        Simulate the instruction caches of MemPool's tiles and\n");
+  fprintf(stderr, "                          write their statistics and misses to\n");
+  fprintf(stderr, "                          <prefix>_tiles.csv and <prefix>_symbols.csv\n");
 
   exit(exit_code);
 }
@@ -182,6 +214,15 @@ static std::vector<std::pair<reg_t, mem_t*>> make_mems(const char* arg)
   return res;
 }
 
+static std::vector<std::pair<reg_t, mem_t*>> make_mempool_mems(const mempool_cfg_t& cfg)
+{
+  // L1 at address zero and L2
+  std::vector<std::pair<reg_t, mem_t*>> res;
+  res.push_back(std::make_pair(reg_t(0), new mem_t(cfg.l1_size())));
+  res.push_back(std::make_pair(cfg.l2_base, new mem_t(cfg.l2_size)));
+  return res;
+}
+
 int main(int argc, char** argv)
 {
   bool debug = false;
@@ -191,7 +232,9 @@ int main(int argc, char** argv)
   bool dump_dts = false;
   bool dtb_enabled = true;
   bool real_time_clint = false;
-  size_t nprocs = 1;
+  size_t nprocs = 0;
+  size_t nthreads = 1;
+  size_t quantum = 0;
   const char* kernel = NULL;
   reg_t kernel_offset, kernel_size;
   size_t initrd_size;
@@ -206,6 +249,8 @@ int main(int argc, char** argv)
   bool log_cache = false;
   bool log_commits = false;
   const char *log_path = nullptr;
+  const char* commit_log_path = NULL;
+  commit_log_codec_t commit_log_codec = CL_CODEC_NONE;
   std::function<extension_t*()> extension;
   const char* initrd = NULL;
   const char* isa = DEFAULT_ISA;
@@ -226,6 +271,13 @@ int main(int argc, char** argv)
     .support_impebreak = true
   };
   std::vector<int> hartids;
+  std::unique_ptr<mempool_cfg_t> mempool;
+  const char* mempool_timing = NULL;
+  const char* perf_counters = NULL;
+  const char* tcdm_model = NULL;
+  const char* icache_model = NULL;
+  const char* profile = NULL;
+  size_t profile_interval = 1000;
 
   auto const hartids_parser = [&](const char *s) {
     std::string const str(s);
@@ -287,9 +339,17 @@ int main(int argc, char** argv)
   parser.option('h', "help", 0, [&](const char* s){help(0);});
   parser.option('d', 0, 0, [&](const char* s){debug = true;});
   parser.option('g', 0, 0, [&](const char* s){histogram = true;});
+  parser.option(0, "profile", 1, [&](const char* s){profile = s;});
+  parser.option(0, "profile-interval", 1, [&](const char* s){profile_interval = strtoull(s, 0, 0);});
   parser.option('l', 0, 0, [&](const char* s){log = true;});
   parser.option('p', 0, 1, [&](const char* s){nprocs = atoi(s);});
   parser.option('m', 0, 1, [&](const char* s){mems = make_mems(s);});
+  parser.option(0, "mempool-timing", 1, [&](const char* s){mempool_timing = s;});
+  parser.option(0, "perf-counters", 1, [&](const char* s){perf_counters = s;});
+  parser.option(0, "tcdm-model", 1, [&](const char* s){tcdm_model = s;});
+  parser.option(0, "icache-model", 1, [&](const char* s){icache_model = s;});
+  parser.option(0, "threads", 1, [&](const char* s){nthreads = atoi(s);});
+  parser.option(0, "quantum", 1, [&](const char* s){quantum = strtoull(s, 0, 0);});
   // I wanted to use --halted, but for some reason that doesn't work.
   parser.option('H', 0, 0, [&](const char* s){halted = true;});
   parser.option(0, "rbb-port", 1, [&](const char* s){use_rbb = true; rbb_port = atoi(s);});
@@ -340,11 +400,30 @@ int main(int argc, char** argv)
                 [&](const char* s){log_commits = true;});
   parser.option(0, "log", 1,
                 [&](const char* s){log_path = s;});
+  parser.option(0, "log-commits-binary", 1,
+                [&](const char* s){commit_log_path = s;});
+  parser.option(0, "log-commits-codec", 1, [&](const char* s){
+    if (!commit_log_parse_codec(s, &commit_log_codec)) {
+      fprintf(stderr, "unknown codec %s\n", s);
+      exit(1);
+    }
+  });
+  parser.option(0, "mempool", 1, [&](const char* s){
+    mempool.reset(new mempool_cfg_t());
+    try {
+      mempool->parse(s);
+    } catch (std::runtime_error& e) {
+      fprintf(stderr, "%s\n", e.what());
+      exit(1);
+    }
+  });
 
   auto argv1 = parser.parse(argv);
   std::vector<std::string> htif_args(argv1, (const char*const*)argv + argc);
+  if (!nprocs)
+    nprocs = mempool ? mempool->num_cores : 1;
   if (mems.empty())
-    mems = make_mems("2048");
+    mems = mempool ? make_mempool_mems(*mempool) : make_mems("2048");
 
   if (!*argv1)
     help();
@@ -377,7 +456,8 @@ int main(int argc, char** argv)
 
   sim_t s(isa, priv, varch, nprocs, halted, real_time_clint,
       initrd_start, initrd_end, bootargs, start_pc, mems, plugin_devices, htif_args,
-      std::move(hartids), dm_config, log_path, dtb_enabled, dtb_file);
+      std::move(hartids), dm_config, log_path, dtb_enabled, dtb_file,
+      mempool.get());
   std::unique_ptr<remote_bitbang_t> remote_bitbang((remote_bitbang_t *) NULL);
   std::unique_ptr<jtag_dtm_t> jtag_dtm(
       new jtag_dtm_t(&s.debug_module, dmi_rti));
@@ -391,6 +471,17 @@ int main(int argc, char** argv)
     return 0;
   }
 
+  // The cache models are shared by all processors
+  if (nthreads > 1 && (ic || dc || l2)) {
+    fprintf(stderr, "--ic, --dc and --l2 cannot be combined with --threads\n");
+    return 1;
+  }
+  // The text logs of all processors go to the same file
+  if (nthreads > 1 && (log || log_commits)) {
+    fprintf(stderr, "-l and --log-commits cannot be combined with --threads, "
+            "use --log-commits-binary instead\n");
+    return 1;
+  }
   if (ic && l2) ic->set_miss_handler(&*l2);
   if (dc && l2) dc->set_miss_handler(&*l2);
   if (ic) ic->set_log(log_cache);
@@ -402,9 +493,60 @@ int main(int argc, char** argv)
     if (extension) s.get_core(i)->register_extension(extension());
   }
 
+  // A processor writes its commits to only one of the logs
+  if (log_commits && commit_log_path) {
+    fprintf(stderr, "--log-commits cannot be combined with --log-commits-binary\n");
+    return 1;
+  }
   s.set_debug(debug);
-  s.configure_log(log, log_commits);
+  s.configure_log(log, log_commits || commit_log_path);
+  if (commit_log_path) {
+    try {
+      s.set_commit_log(commit_log_path, commit_log_codec);
+    } catch (std::runtime_error& e) {
+      fprintf(stderr, "%s\n", e.what());
+      return 1;
+    }
+  }
   s.set_histogram(histogram);
+  s.set_threads(nthreads);
+  if (mempool_timing) {
+    if (!mempool) {
+      fprintf(stderr, "--mempool-timing requires --mempool\n");
+      return 1;
+    }
+    s.set_mempool_timing(mempool_timing);
+  }
+  if (perf_counters) {
+    if (!mempool) {
+      fprintf(stderr, "--perf-counters requires --mempool\n");
+      return 1;
+    }
+    s.set_perf_counters(perf_counters);
+  }
+  if (tcdm_model) {
+    if (!mempool) {
+      fprintf(stderr, "--tcdm-model requires --mempool\n");
+      return 1;
+    }
+    s.set_tcdm_model(tcdm_model);
+  }
+  if (icache_model) {
+    if (!mempool) {
+      fprintf(stderr, "--icache-model requires --mempool\n");
+      return 1;
+    }
+    s.set_icache_model(icache_model);
+  }
+  if (profile) {
+    if (profile_interval == 0) {
+      fprintf(stderr, "--profile-interval must be positive\n");
+      return 1;
+    }
+    s.set_profiler(profile, profile_interval);
+  }
+  if (quantum)
+    s.set_quantum(quantum);
 
   auto return_code = s.run();
 